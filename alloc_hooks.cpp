@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <new>
+
+#include "alloc_tracker.h"
+
+// Global operator new and delete that count every allocation in AllocationTracker. Only
+// linked into executables that want the counts; the array forms forward to these. The
+// over-aligned forms (C++17 std::align_val_t) are counted too.
+
+namespace {
+    struct Installer {
+        Installer() {
+            AllocationTracker::install();
+        }
+    };
+
+    Installer installer;
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+        std::size_t align = static_cast<std::size_t>(alignment);
+        // aligned_alloc wants a size that is a multiple of the alignment.
+        std::size_t rounded = (size + align - 1) / align * align;
+#ifdef _MSC_VER
+        return _aligned_malloc(rounded == 0 ? align : rounded, align);
+#else
+        return std::aligned_alloc(align, rounded == 0 ? align : rounded);
+#endif
+    }
+
+    void freeAligned(void* pointer) {
+#ifdef _MSC_VER
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+}
+
+void* operator new(std::size_t size) {
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        AllocationTracker::recordAllocation(size);
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer != nullptr) {
+        AllocationTracker::recordAllocation(size);
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer != nullptr) {
+        AllocationTracker::recordFree();
+    }
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    operator delete(pointer);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* pointer = allocateAligned(size, alignment)) {
+        AllocationTracker::recordAllocation(size);
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    void* pointer = allocateAligned(size, alignment);
+    if (pointer != nullptr) {
+        AllocationTracker::recordAllocation(size);
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    if (pointer != nullptr) {
+        AllocationTracker::recordFree();
+    }
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(pointer, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    operator delete(pointer, alignment);
+}
@@ -0,0 +1,109 @@
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace {
+    struct StageSlot {
+        std::atomic<const char*> name;
+        std::atomic<std::uint64_t> allocations;
+        std::atomic<std::uint64_t> bytes;
+    };
+
+    // All constant-initialised, so they are ready before the first operator new of the
+    // process, whichever translation unit it comes from.
+    std::atomic<bool> installed(false);
+    std::atomic<std::uint64_t> totalAllocations(0);
+    std::atomic<std::uint64_t> totalBytes(0);
+    std::atomic<std::uint64_t> totalFrees(0);
+    std::atomic<std::uint64_t> frameAllocations(0);
+    std::atomic<std::uint64_t> frameBytes(0);
+    StageSlot stages[AllocationTracker::maxStages];
+    StageSlot otherStage;
+
+    const char* unscopedName = "unscoped";
+    const char* otherName = "other";
+
+    thread_local const char* currentStage = nullptr;
+
+    // Finds the slot of a stage, claiming a free one for a name not seen before. The same
+    // literal can have a different address in every translation unit, hence the strcmp.
+    StageSlot& findStage(const char* name) {
+        for (auto& slot : stages) {
+            const char* slotName = slot.name.load(std::memory_order_acquire);
+            if (slotName == nullptr) {
+                if (slot.name.compare_exchange_strong(slotName, name, std::memory_order_acq_rel)) {
+                    return slot;
+                }
+            }
+            if (slotName == name || std::strcmp(slotName, name) == 0) {
+                return slot;
+            }
+        }
+        return otherStage;
+    }
+}
+
+bool AllocationTracker::isInstalled() {
+    return installed.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::install() {
+    installed.store(true, std::memory_order_relaxed);
+}
+
+void AllocationTracker::recordAllocation(std::size_t size) {
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(size, std::memory_order_relaxed);
+    StageSlot& slot = findStage(currentStage != nullptr ? currentStage : unscopedName);
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void AllocationTracker::recordFree() {
+    totalFrees.fetch_add(1, std::memory_order_relaxed);
+}
+
+AllocationCounts AllocationTracker::getTotals() {
+    return {totalAllocations.load(std::memory_order_relaxed), totalBytes.load(std::memory_order_relaxed)};
+}
+
+std::int64_t AllocationTracker::getLiveBlocks() {
+    return static_cast<std::int64_t>(totalAllocations.load(std::memory_order_relaxed) -
+                                     totalFrees.load(std::memory_order_relaxed));
+}
+
+AllocationCounts AllocationTracker::endFrame() {
+    AllocationCounts totals = getTotals();
+    AllocationCounts frame = {totals.allocations - frameAllocations.load(std::memory_order_relaxed),
+                              totals.bytes - frameBytes.load(std::memory_order_relaxed)};
+    frameAllocations.store(totals.allocations, std::memory_order_relaxed);
+    frameBytes.store(totals.bytes, std::memory_order_relaxed);
+    return frame;
+}
+
+void AllocationTracker::getStages(std::vector<AllocationStageCounts>& result) {
+    result.clear();
+    for (const auto& slot : stages) {
+        const char* name = slot.name.load(std::memory_order_acquire);
+        if (name == nullptr) {
+            break;
+        }
+        result.push_back({name, {slot.allocations.load(std::memory_order_relaxed),
+                                 slot.bytes.load(std::memory_order_relaxed)}});
+    }
+    if (otherStage.allocations.load(std::memory_order_relaxed) > 0) {
+        result.push_back({otherName, {otherStage.allocations.load(std::memory_order_relaxed),
+                                      otherStage.bytes.load(std::memory_order_relaxed)}});
+    }
+}
+
+const char* AllocationTracker::enterStage(const char* name) {
+    const char* previous = currentStage;
+    currentStage = name;
+    return previous;
+}
+
+void AllocationTracker::leaveStage(const char* previous) {
+    currentStage = previous;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AllocationCounts {
+    std::uint64_t allocations;
+    std::uint64_t bytes;
+};
+
+struct AllocationStageCounts {
+    const char* name;
+    AllocationCounts counts;
+};
+
+// Counts heap allocations. The counting itself is done by the global operator new and
+// delete in alloc_hooks.cpp, the over-aligned forms included; executables that link the
+// oop_game_alloc_hooks object library get them (the benchmark and the soak test always,
+// the game in debug builds), everything else reads zeros and isInstalled() is false.
+//
+// Every allocation is also charged to the stage its thread is in, which is the innermost
+// PROFILE_SCOPE (or AllocationStage) open on that thread; allocations outside any scope go
+// to "unscoped". Stages are told apart by name, and after maxStages different names the
+// rest share the "other" stage. Nothing here allocates, so it is safe to call from the hooks.
+class AllocationTracker {
+public:
+    static const size_t maxStages = 64;
+
+    static bool isInstalled();
+    // Called by the hooks only.
+    static void install();
+    static void recordAllocation(std::size_t size);
+    static void recordFree();
+
+    // Totals since the start of the process.
+    static AllocationCounts getTotals();
+    // Blocks allocated and not yet freed.
+    static std::int64_t getLiveBlocks();
+    // Main thread only: the allocations since the previous call, for per-frame counters.
+    static AllocationCounts endFrame();
+    // Per-stage totals since the start of the process, in the order the stages first
+    // allocated. Reserve maxStages entries up front for the call itself not to allocate.
+    static void getStages(std::vector<AllocationStageCounts>& result);
+
+    // Makes `name` the stage of this thread and returns the previous one for leaveStage.
+    // `name` must outlive the process; string literals are the intended use.
+    static const char* enterStage(const char* name);
+    static void leaveStage(const char* previous);
+};
+
+class AllocationStage {
+private:
+    const char* previous;
+
+public:
+    explicit AllocationStage(const char* name) : previous(AllocationTracker::enterStage(name)) {}
+
+    ~AllocationStage() {
+        AllocationTracker::leaveStage(previous);
+    }
+
+    AllocationStage(const AllocationStage&) = delete;
+    AllocationStage& operator=(const AllocationStage&) = delete;
+};
@@ -0,0 +1,157 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "texture_atlas.h"
+
+// Offline asset cooker: decodes the source images once, scales them to the size the game
+// draws them at, packs the gameplay sprites into one atlas and writes everything as raw
+// RGBA into an asset pack.
+//
+// Usage: oop_game_cook <source directory> <output pack>
+
+namespace {
+    struct SourceImage {
+        const char* name;
+        const char* file;
+        float scale;          // draw scale used by the game; ignored when width is set
+        unsigned width;
+        unsigned height;
+        bool inAtlas;
+    };
+
+    const SourceImage sourceImages[] = {
+            {"spacecraft", "spacecraft.png", 0.10f, 0, 0, true},
+            {"spacecraftHitted", "spacecraftHitted.png", 0.10f, 0, 0, true},
+            {"ball", "ball.png", 0.08f, 0, 0, true},
+            {"meteor1", "meteor1.png", 0.6f, 0, 0, true},
+            {"meteor2", "meteor2.png", 0.6f, 0, 0, true},
+            {"meteor3", "meteor3.png", 0.6f, 0, 0, true},
+            {"mainpage", "mainpage.jpg", 1.0f, 0, 0, false},
+            {"background", "background.jpg", 1.0f, 0, 0, false},
+            {"gameover", "gameover.jpg", 1.0f, 0, 0, false},
+            {"startgame", "startgame.png", 1.0f, 370, 140, false},
+            {"cursor", "cursor.png", 1.0f, 0, 0, false},
+    };
+
+    const char* atlasName = "gameplay";
+    const unsigned atlasMaximumSize = 2048;
+
+    // Area-average downscale. Colour is weighted by alpha so transparent pixels do not
+    // darken the edges of the sprite.
+    sf::Image resize(const sf::Image& source, unsigned width, unsigned height) {
+        sf::Vector2u sourceSize = source.getSize();
+        if (sourceSize.x == width && sourceSize.y == height) {
+            return source;
+        }
+        const sf::Uint8* pixels = source.getPixelsPtr();
+        std::vector<sf::Uint8> result(static_cast<size_t>(width) * height * 4);
+        float stepX = static_cast<float>(sourceSize.x) / width;
+        float stepY = static_cast<float>(sourceSize.y) / height;
+
+        for (unsigned y = 0; y < height; ++y) {
+            unsigned top = static_cast<unsigned>(y * stepY);
+            unsigned bottom = std::max(top + 1, std::min(sourceSize.y, static_cast<unsigned>(std::ceil((y + 1) * stepY))));
+            for (unsigned x = 0; x < width; ++x) {
+                unsigned left = static_cast<unsigned>(x * stepX);
+                unsigned right = std::max(left + 1, std::min(sourceSize.x, static_cast<unsigned>(std::ceil((x + 1) * stepX))));
+                double red = 0, green = 0, blue = 0, alpha = 0;
+                unsigned count = 0;
+                for (unsigned sy = top; sy < bottom; ++sy) {
+                    const sf::Uint8* row = pixels + (static_cast<size_t>(sy) * sourceSize.x + left) * 4;
+                    for (unsigned sx = left; sx < right; ++sx, row += 4) {
+                        double weight = row[3];
+                        red += row[0] * weight;
+                        green += row[1] * weight;
+                        blue += row[2] * weight;
+                        alpha += weight;
+                        ++count;
+                    }
+                }
+                sf::Uint8* out = &result[(static_cast<size_t>(y) * width + x) * 4];
+                if (alpha > 0) {
+                    out[0] = static_cast<sf::Uint8>(red / alpha + 0.5);
+                    out[1] = static_cast<sf::Uint8>(green / alpha + 0.5);
+                    out[2] = static_cast<sf::Uint8>(blue / alpha + 0.5);
+                }
+                out[3] = static_cast<sf::Uint8>(alpha / count + 0.5);
+            }
+        }
+        sf::Image image;
+        image.create(width, height, result.data());
+        return image;
+    }
+
+    CookedTexture toCookedTexture(const std::string& name, const sf::Image& image) {
+        CookedTexture texture;
+        texture.name = name;
+        texture.width = image.getSize().x;
+        texture.height = image.getSize().y;
+        const sf::Uint8* pixels = image.getPixelsPtr();
+        texture.pixels.assign(pixels, pixels + static_cast<size_t>(texture.width) * texture.height * 4);
+        return texture;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <source directory> <output pack>" << std::endl;
+        return 1;
+    }
+    std::string sourceDirectory = argv[1];
+    std::string outputPath = argv[2];
+
+    TextureAtlas atlas;
+    std::vector<CookedTexture> textures;
+    for (const auto& source : sourceImages) {
+        sf::Image image;
+        if (!image.loadFromFile(sourceDirectory + "/" + source.file)) {
+            std::cerr << "Failed to load " << source.file << std::endl;
+            return 1;
+        }
+        unsigned width = source.width;
+        unsigned height = source.height;
+        if (width == 0) {
+            width = std::max(1u, static_cast<unsigned>(std::lround(image.getSize().x * source.scale)));
+            height = std::max(1u, static_cast<unsigned>(std::lround(image.getSize().y * source.scale)));
+        }
+        sf::Image cooked = resize(image, width, height);
+        std::cout << source.name << ": " << image.getSize().x << "x" << image.getSize().y
+                  << " -> " << width << "x" << height << std::endl;
+
+        if (source.inAtlas) {
+            atlas.add(source.name, cooked);
+        } else {
+            textures.push_back(toCookedTexture(source.name, cooked));
+        }
+    }
+
+    sf::Image atlasImage = atlas.pack(atlasMaximumSize);
+    std::vector<AssetPackSprite> sprites;
+    for (size_t id = 0; id < atlas.getRegionCount(); ++id) {
+        AssetPackSprite sprite;
+        std::memset(&sprite, 0, sizeof(sprite));
+        const std::string& name = atlas.getName(static_cast<int>(id));
+        std::memcpy(sprite.name, name.c_str(), std::min(name.size(), assetNameLength - 1));
+        const sf::IntRect& region = atlas.getRegion(static_cast<int>(id));
+        sprite.texture = static_cast<std::uint32_t>(textures.size());
+        sprite.left = region.left;
+        sprite.top = region.top;
+        sprite.width = region.width;
+        sprite.height = region.height;
+        sprites.push_back(sprite);
+    }
+    textures.push_back(toCookedTexture(atlasName, atlasImage));
+    std::cout << atlasName << ": " << atlasImage.getSize().x << "x" << atlasImage.getSize().y << std::endl;
+
+    if (!writeAssetPack(outputPath, textures, sprites)) {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
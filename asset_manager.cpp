@@ -0,0 +1,137 @@
+#include "asset_manager.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#include "texture_atlas.h"
+
+namespace {
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+AssetManager::AssetManager(const AssetPack& pack, unsigned workerCount)
+        : pack(pack), readyCount(0), stopping(false) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&AssetManager::workerLoop, this);
+    }
+}
+
+AssetManager::~AssetManager() {
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        stopping = true;
+        tasks.clear();
+    }
+    tasksChanged.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void AssetManager::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tasksMutex);
+            tasksChanged.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+int AssetManager::enqueue(const std::string& name, bool isFont, std::function<PreparedAsset()> prepare) {
+    auto task = std::make_shared<std::packaged_task<PreparedAsset()>>(std::move(prepare));
+    Entry entry;
+    entry.name = name;
+    entry.isFont = isFont;
+    entry.ready = false;
+    entry.pending = task->get_future();
+    entry.requested = std::chrono::steady_clock::now();
+    entries.push_back(std::move(entry));
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        tasks.emplace_back([task] { (*task)(); });
+    }
+    tasksChanged.notify_one();
+    return static_cast<int>(entries.size() - 1);
+}
+
+AssetManager::TextureHandle AssetManager::requestTexture(const std::string& name) {
+    const AssetPack& source = pack;
+    return {enqueue(name, false, [&source, name] {
+        auto start = std::chrono::steady_clock::now();
+        PreparedAsset prepared;
+        const AssetPackTexture* record = source.findTexture(name);
+        prepared.ok = record != nullptr;
+        if (prepared.ok) {
+            // Touch one byte per page so the disk reads happen here rather than in the
+            // upload on the main thread.
+            const volatile std::uint8_t* pixels = source.getPixels(*record);
+            size_t bytes = static_cast<size_t>(record->width) * record->height * 4;
+            std::uint8_t sink = 0;
+            for (size_t offset = 0; offset < bytes; offset += 4096) {
+                sink ^= pixels[offset];
+            }
+            (void) sink;
+        }
+        prepared.prepareMilliseconds = millisecondsSince(start);
+        return prepared;
+    })};
+}
+
+AssetManager::FontHandle AssetManager::requestFont(const std::string& path) {
+    return {enqueue(path, true, [path] {
+        auto start = std::chrono::steady_clock::now();
+        PreparedAsset prepared;
+        std::ifstream file(path, std::ios::binary);
+        prepared.ok = file.is_open();
+        if (prepared.ok) {
+            prepared.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        prepared.prepareMilliseconds = millisecondsSince(start);
+        return prepared;
+    })};
+}
+
+void AssetManager::finish(Entry& entry, PreparedAsset prepared) {
+    auto uploadStart = std::chrono::steady_clock::now();
+    if (entry.isFont) {
+        // sf::Font reads glyphs from this buffer lazily, so the entry keeps it alive.
+        entry.fontBytes = std::move(prepared.bytes);
+        entry.font.reset(new sf::Font());
+        prepared.ok = prepared.ok && entry.font->loadFromMemory(entry.fontBytes.data(), entry.fontBytes.size());
+    } else {
+        entry.texture.reset(new sf::Texture());
+        prepared.ok = prepared.ok && loadPackedTexture(*entry.texture, pack, entry.name);
+    }
+    if (!prepared.ok) {
+        throw std::runtime_error("Failed to load " + entry.name);
+    }
+    entry.ready = true;
+    ++readyCount;
+    std::cout << "Loaded " << entry.name << " in " << millisecondsSince(entry.requested) << " ms (background "
+              << prepared.prepareMilliseconds << " ms, upload " << millisecondsSince(uploadStart) << " ms)"
+              << std::endl;
+}
+
+void AssetManager::update() {
+    for (auto& entry : entries) {
+        if (!entry.ready && entry.pending.valid() &&
+            entry.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            finish(entry, entry.pending.get());
+        }
+    }
+}
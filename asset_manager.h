@@ -0,0 +1,100 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_pack.h"
+
+// Loads textures and fonts in the background so the window stays responsive.
+// Worker threads do the slow part (faulting in the mapped pack pages, reading font
+// files); update() then creates the GPU resources on the main thread, since the GL
+// context belongs to it. Assets are prepared in request order, so request the ones the
+// first screen needs first.
+class AssetManager {
+public:
+    struct TextureHandle {
+        int id;
+    };
+
+    struct FontHandle {
+        int id;
+    };
+
+private:
+    struct PreparedAsset {
+        bool ok;
+        std::vector<char> bytes;
+        double prepareMilliseconds;
+    };
+
+    struct Entry {
+        std::string name;
+        bool isFont;
+        bool ready;
+        std::future<PreparedAsset> pending;
+        std::unique_ptr<sf::Texture> texture;
+        std::unique_ptr<sf::Font> font;
+        std::vector<char> fontBytes;
+        std::chrono::steady_clock::time_point requested;
+    };
+
+    const AssetPack& pack;
+    std::vector<Entry> entries;
+    int readyCount;
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksChanged;
+    bool stopping;
+
+    void workerLoop();
+    int enqueue(const std::string& name, bool isFont, std::function<PreparedAsset()> prepare);
+    void finish(Entry& entry, PreparedAsset prepared);
+
+public:
+    explicit AssetManager(const AssetPack& pack, unsigned workerCount = 0);
+    ~AssetManager();
+    AssetManager(const AssetManager&) = delete;
+    AssetManager& operator=(const AssetManager&) = delete;
+
+    TextureHandle requestTexture(const std::string& name);
+    FontHandle requestFont(const std::string& path);
+
+    // Main thread only: creates the GPU resources for every asset whose background work has
+    // finished. Throws if an asset could not be loaded.
+    void update();
+
+    bool isReady(TextureHandle handle) const {
+        return entries[handle.id].ready;
+    }
+
+    bool isReady(FontHandle handle) const {
+        return entries[handle.id].ready;
+    }
+
+    const sf::Texture& get(TextureHandle handle) const {
+        return *entries[handle.id].texture;
+    }
+
+    const sf::Font& get(FontHandle handle) const {
+        return *entries[handle.id].font;
+    }
+
+    bool isAllReady() const {
+        return readyCount == static_cast<int>(entries.size());
+    }
+
+    float getProgress() const {
+        return entries.empty() ? 1.0f : static_cast<float>(readyCount) / entries.size();
+    }
+};
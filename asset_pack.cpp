@@ -0,0 +1,220 @@
+#include "asset_pack.h"
+
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(AssetPackHeader) == 16, "asset pack header must have no padding");
+static_assert(sizeof(AssetPackTexture) == 48, "asset pack texture record must have no padding");
+static_assert(sizeof(AssetPackSprite) == 52, "asset pack sprite record must have no padding");
+
+namespace {
+    std::uint64_t alignUp(std::uint64_t value) {
+        return (value + assetPackAlignment - 1) / assetPackAlignment * assetPackAlignment;
+    }
+
+    bool nameEquals(const char (&stored)[assetNameLength], const std::string& name) {
+        return name.size() < assetNameLength && std::strncmp(stored, name.c_str(), assetNameLength) == 0;
+    }
+}
+
+bool writeAssetPack(const std::string& path, const std::vector<CookedTexture>& textures,
+                    const std::vector<AssetPackSprite>& sprites) {
+    AssetPackHeader header;
+    std::memcpy(header.magic, assetPackMagic, sizeof(header.magic));
+    header.version = assetPackVersion;
+    header.textureCount = static_cast<std::uint32_t>(textures.size());
+    header.spriteCount = static_cast<std::uint32_t>(sprites.size());
+
+    std::vector<AssetPackTexture> records(textures.size());
+    std::uint64_t offset = alignUp(sizeof(AssetPackHeader) + records.size() * sizeof(AssetPackTexture) +
+                                   sprites.size() * sizeof(AssetPackSprite));
+    for (size_t i = 0; i < textures.size(); ++i) {
+        if (textures[i].name.size() >= assetNameLength ||
+            textures[i].pixels.size() != static_cast<size_t>(textures[i].width) * textures[i].height * 4) {
+            return false;
+        }
+        std::memset(&records[i], 0, sizeof(AssetPackTexture));
+        std::memcpy(records[i].name, textures[i].name.c_str(), textures[i].name.size());
+        records[i].width = textures[i].width;
+        records[i].height = textures[i].height;
+        records[i].offset = offset;
+        offset = alignUp(offset + textures[i].pixels.size());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(AssetPackTexture));
+    file.write(reinterpret_cast<const char*>(sprites.data()), sprites.size() * sizeof(AssetPackSprite));
+    for (size_t i = 0; i < textures.size(); ++i) {
+        std::uint64_t position = static_cast<std::uint64_t>(file.tellp());
+        std::vector<char> padding(records[i].offset - position, 0);
+        file.write(padding.data(), padding.size());
+        file.write(reinterpret_cast<const char*>(textures[i].pixels.data()), textures[i].pixels.size());
+    }
+    return file.good();
+}
+
+AssetPack::AssetPack()
+        : data(nullptr), size(0), textures(nullptr), sprites(nullptr), textureCount(0), spriteCount(0),
+#ifdef _WIN32
+          fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {}
+#else
+          fileDescriptor(-1) {}
+#endif
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+bool AssetPack::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        close();
+        return false;
+    }
+    data = static_cast<const std::uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fileDescriptor, &status) != 0 || status.st_size == 0) {
+        close();
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data = static_cast<const std::uint8_t*>(mapping);
+    size = static_cast<size_t>(status.st_size);
+#endif
+    if (data == nullptr || !validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close() {
+#ifdef _WIN32
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data != nullptr) {
+        munmap(const_cast<std::uint8_t*>(data), size);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+#endif
+    data = nullptr;
+    size = 0;
+    textures = nullptr;
+    sprites = nullptr;
+    textureCount = 0;
+    spriteCount = 0;
+}
+
+bool AssetPack::validate() {
+    if (size < sizeof(AssetPackHeader)) {
+        return false;
+    }
+    const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(data);
+    if (std::memcmp(header->magic, assetPackMagic, sizeof(header->magic)) != 0 ||
+        header->version != assetPackVersion) {
+        return false;
+    }
+    std::uint64_t tableEnd = sizeof(AssetPackHeader) +
+                             static_cast<std::uint64_t>(header->textureCount) * sizeof(AssetPackTexture) +
+                             static_cast<std::uint64_t>(header->spriteCount) * sizeof(AssetPackSprite);
+    if (tableEnd > size) {
+        return false;
+    }
+    textures = reinterpret_cast<const AssetPackTexture*>(data + sizeof(AssetPackHeader));
+    sprites = reinterpret_cast<const AssetPackSprite*>(textures + header->textureCount);
+
+    for (std::uint32_t i = 0; i < header->textureCount; ++i) {
+        std::uint64_t bytes = static_cast<std::uint64_t>(textures[i].width) * textures[i].height * 4;
+        if (textures[i].offset < tableEnd || textures[i].offset > size || bytes > size - textures[i].offset) {
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < header->spriteCount; ++i) {
+        const AssetPackSprite& sprite = sprites[i];
+        if (sprite.texture >= header->textureCount || sprite.left < 0 || sprite.top < 0 ||
+            sprite.width < 0 || sprite.height < 0 ||
+            static_cast<std::uint64_t>(sprite.left) + sprite.width > textures[sprite.texture].width ||
+            static_cast<std::uint64_t>(sprite.top) + sprite.height > textures[sprite.texture].height) {
+            return false;
+        }
+    }
+    textureCount = header->textureCount;
+    spriteCount = header->spriteCount;
+    return true;
+}
+
+const AssetPackTexture* AssetPack::findTexture(const std::string& name) const {
+    for (std::uint32_t i = 0; i < textureCount; ++i) {
+        if (nameEquals(textures[i].name, name)) {
+            return &textures[i];
+        }
+    }
+    return nullptr;
+}
+
+const AssetPackSprite* AssetPack::findSprite(const std::string& name) const {
+    for (std::uint32_t i = 0; i < spriteCount; ++i) {
+        if (nameEquals(sprites[i].name, name)) {
+            return &sprites[i];
+        }
+    }
+    return nullptr;
+}
+
+const std::uint8_t* AssetPack::getPixels(const AssetPackTexture& texture) const {
+    return data + texture.offset;
+}
+
+std::uint32_t AssetPack::indexOf(const AssetPackTexture& texture) const {
+    return static_cast<std::uint32_t>(&texture - textures);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary asset pack produced by oop_game_cook. Textures are stored as raw RGBA at the size
+// they are drawn on screen, so the game can hand the mapped bytes straight to the GPU.
+//
+// Layout (little-endian): AssetPackHeader, textureCount AssetPackTexture records,
+// spriteCount AssetPackSprite records, then the pixel data of each texture starting at its
+// offset, aligned to assetPackAlignment bytes.
+
+const char assetPackMagic[4] = {'A', 'G', 'P', 'K'};
+const std::uint32_t assetPackVersion = 1;
+const std::uint32_t assetPackAlignment = 64;
+const size_t assetNameLength = 32;
+
+struct AssetPackHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t textureCount;
+    std::uint32_t spriteCount;
+};
+
+struct AssetPackTexture {
+    char name[assetNameLength];
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint64_t offset;
+};
+
+// A named rectangle inside one of the pack's textures; atlas textures hold several.
+struct AssetPackSprite {
+    char name[assetNameLength];
+    std::uint32_t texture;
+    std::int32_t left;
+    std::int32_t top;
+    std::int32_t width;
+    std::int32_t height;
+};
+
+struct CookedTexture {
+    std::string name;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::vector<std::uint8_t> pixels;
+};
+
+bool writeAssetPack(const std::string& path, const std::vector<CookedTexture>& textures,
+                    const std::vector<AssetPackSprite>& sprites);
+
+// Read-only, memory-mapped view of an asset pack. Pixel pointers point into the mapping
+// and stay valid until the pack is closed.
+class AssetPack {
+private:
+    const std::uint8_t* data;
+    size_t size;
+    const AssetPackTexture* textures;
+    const AssetPackSprite* sprites;
+    std::uint32_t textureCount;
+    std::uint32_t spriteCount;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+
+    bool validate();
+
+public:
+    AssetPack();
+    ~AssetPack();
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const AssetPackTexture* findTexture(const std::string& name) const;
+    const AssetPackSprite* findSprite(const std::string& name) const;
+    const std::uint8_t* getPixels(const AssetPackTexture& texture) const;
+    std::uint32_t indexOf(const AssetPackTexture& texture) const;
+
+    std::uint32_t getTextureCount() const {
+        return textureCount;
+    }
+
+    const AssetPackTexture& getTexture(std::uint32_t index) const {
+        return textures[index];
+    }
+
+    std::uint32_t getSpriteCount() const {
+        return spriteCount;
+    }
+
+    const AssetPackSprite& getSprite(std::uint32_t index) const {
+        return sprites[index];
+    }
+};
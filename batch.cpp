@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "batch_runner.h"
+#include "collision_mask.h"
+#include "input_source.h"
+#include "job_system.h"
+
+// Headless batch run: many independent games stepped together by a BatchRunner, as a
+// balancing run or a stand-in for agent training would, reporting the aggregate ticks per
+// second over all instances.
+//
+// Usage: oop_game_batch [--instances <n>] [--ticks <n>] [--threads <n>] [--seed <s>]
+//                       [--policy autopilot|random] [--max-ticks <n>] [--pack <assets.pack>] [--check]
+//
+// --instances games run side by side (default 1024), each for --ticks ticks (default 3600),
+// starting a new game whenever one ends or reaches --max-ticks (default 0, no limit).
+// --threads 0 (the default) uses every hardware thread. --policy picks who plays: one
+// autopilot per instance (the default), or a pointer that wanders at random and always fires.
+// The games play with the game's settings; --pack gives them the sprite masks of a cooked
+// asset pack, without it they collide by bounding boxes.
+// --check runs the same batch again on the calling thread only and exits with 1 if the
+// final state differs.
+
+namespace {
+    const char* usage = " [--instances <n>] [--ticks <n>] [--threads <n>] [--seed <s>]"
+                        " [--policy autopilot|random] [--max-ticks <n>] [--pack <assets.pack>] [--check]";
+
+    const float dt = 1.0f / 60;
+
+    struct Options {
+        size_t instances = 1024;
+        int ticks = 3600;
+        int threads = 0;
+        std::uint64_t seed = 1;
+        bool autopilot = true;
+        int maxTicks = 0;
+        std::string packPath;
+        bool check = false;
+    };
+
+    struct Result {
+        double seconds;
+        std::uint64_t ticks;
+        std::uint64_t games;
+        double rewardSum;
+        std::uint64_t stateHash;
+    };
+
+    // One policy per instance, asked for all instances across the same job system.
+    class Policies {
+    private:
+        bool autopilot;
+        std::vector<Autopilot> autopilots;
+        std::vector<Rng> random;
+        std::vector<TickInput> actions;
+
+    public:
+        Policies(const Options& options, const BatchRunner& batch)
+                : autopilot(options.autopilot), actions(batch.size(), TickInput{{0.0f, 0.0f}, false}) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (autopilot) {
+                    autopilots.emplace_back(batch.getGame(i).getSeed());
+                } else {
+                    random.emplace_back(options.seed, i);
+                    actions[i].pointer = batch.getGame(i).getShip().position;
+                }
+            }
+        }
+
+        const TickInput* next(const BatchRunner& batch, JobSystem* jobs) {
+            auto decide = [this, &batch](size_t begin, size_t end, unsigned) {
+                for (size_t i = begin; i < end; ++i) {
+                    const Simulation& game = batch.getGame(i);
+                    if (autopilot) {
+                        // A new game gets a new autopilot, as in the game itself.
+                        if (game.getTickCount() == 0) {
+                            autopilots[i] = Autopilot(game.getSeed());
+                        }
+                        actions[i] = autopilots[i].next(game);
+                    } else {
+                        const SimConfig& config = game.getConfig();
+                        Vec2& pointer = actions[i].pointer;
+                        pointer.x = std::min(std::max(pointer.x + (random[i].nextFloat() - 0.5f) * 40.0f, 0.0f),
+                                             config.fieldWidth);
+                        pointer.y = std::min(std::max(pointer.y + (random[i].nextFloat() - 0.5f) * 40.0f, 0.0f),
+                                             config.fieldHeight);
+                        actions[i].fire = true;
+                    }
+                }
+            };
+            if (jobs != nullptr) {
+                jobs->parallelFor(batch.size(), 64, decide);
+            } else {
+                decide(0, batch.size(), 0);
+            }
+            return actions.data();
+        }
+    };
+
+    Result run(const Options& options, const SpriteMasks* masks, JobSystem* jobs) {
+        BatchRunner batch(options.instances, options.seed, jobs);
+        if (masks != nullptr) {
+            batch.setSpriteMasks(*masks);
+        }
+        batch.setMaxTicks(options.maxTicks);
+        batch.setLifePenalty(1.0f);
+        Policies policies(options, batch);
+
+        Result result = {0.0, 0, 0, 0.0, 0};
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < options.ticks; ++tick) {
+            batch.step(dt, policies.next(batch, jobs));
+            const float* rewards = batch.getRewards();
+            for (size_t i = 0; i < batch.size(); ++i) {
+                result.rewardSum += rewards[i];
+            }
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.ticks = batch.getTotalTicks();
+        result.games = batch.getFinishedGames();
+        result.stateHash = batch.computeStateHash();
+        return result;
+    }
+
+    void print(const char* label, unsigned threads, const Result& result) {
+        std::printf("%-10s %8u %14llu %10.2f %14.0f %10llu %12.1f   %016llx\n", label, threads,
+                    static_cast<unsigned long long>(result.ticks), result.seconds, result.ticks / result.seconds,
+                    static_cast<unsigned long long>(result.games), result.rewardSum,
+                    static_cast<unsigned long long>(result.stateHash));
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            options.instances = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            options.ticks = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            const char* policy = argv[++i];
+            if (std::strcmp(policy, "autopilot") != 0 && std::strcmp(policy, "random") != 0) {
+                std::fprintf(stderr, "Usage: %s%s\n", argv[0], usage);
+                return 2;
+            }
+            options.autopilot = std::strcmp(policy, "autopilot") == 0;
+        } else if (std::strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+            options.maxTicks = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            options.packPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--check") == 0) {
+            options.check = true;
+        } else {
+            std::fprintf(stderr, "Usage: %s%s\n", argv[0], usage);
+            return 2;
+        }
+    }
+
+    try {
+        std::unique_ptr<SpriteMasks> masks;
+        if (!options.packPath.empty()) {
+            AssetPack pack;
+            if (!pack.open(options.packPath)) {
+                std::fprintf(stderr, "Failed to open %s\n", options.packPath.c_str());
+                return 1;
+            }
+            masks.reset(new SpriteMasks(loadSpriteMasks(pack)));
+        } else {
+            std::fprintf(stderr, "No --pack given, the games collide by bounding boxes\n");
+        }
+        JobSystem jobs(static_cast<unsigned>(options.threads));
+        std::printf("%zu instances, %d ticks each, %s\n", options.instances, options.ticks,
+                    options.autopilot ? "autopilot" : "random policy");
+        std::printf("%-10s %8s %14s %10s %14s %10s %12s   %-16s\n", "run", "threads", "ticks", "seconds", "ticks/s",
+                    "games", "reward", "state hash");
+        Result result = run(options, masks.get(), &jobs);
+        print("batch", jobs.getThreadCount(), result);
+        if (options.check) {
+            Result single = run(options, masks.get(), nullptr);
+            print("single", 1, single);
+            if (single.stateHash != result.stateHash) {
+                std::fprintf(stderr, "the state differs between %u threads and one\n", jobs.getThreadCount());
+                return 1;
+            }
+        }
+    } catch (const std::exception& error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "batch_runner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "job_system.h"
+#include "profiler.h"
+
+namespace {
+    const float degreesToRadians = 3.14159f / 180;
+
+    // Instances per job; one tick of a game is short, so a job takes several.
+    const size_t instanceChunk = 16;
+
+    const size_t initialFoundCapacity = 256;
+}
+
+BatchRunner::BatchRunner(const SimConfig& config, size_t count, std::uint64_t seed, JobSystem* jobs)
+        : config(config), jobs(jobs), observations(count * observationSize, 0.0f), rewards(count, 0.0f),
+          done(count, 0), scores(count, 0), lives(count, 0), gameTicks(count, 0), maxTicks(0), lifePenalty(0.0f),
+          totalTicks(0), finishedGames(0) {
+    games.reserve(count);
+    seeds.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        games.emplace_back(new Simulation(config));
+        seeds.emplace_back(seed, i);
+    }
+    size_t threadCount = jobs != nullptr ? jobs->getThreadCount() : 1;
+    workerFound.resize(threadCount);
+    workerNearby.resize(threadCount);
+    for (size_t worker = 0; worker < threadCount; ++worker) {
+        workerFound[worker].reserve(initialFoundCapacity);
+        workerNearby[worker].reserve(initialFoundCapacity);
+    }
+    reset();
+}
+
+BatchRunner::BatchRunner(size_t count, std::uint64_t seed, JobSystem* jobs)
+        : BatchRunner(gameSimConfig(), count, seed, jobs) {
+}
+
+void BatchRunner::setSpriteMasks(const SpriteMasks& masks) {
+    std::shared_ptr<const PreparedSpriteMasks> prepared = Simulation::prepareSpriteMasks(masks);
+    for (const auto& game : games) {
+        game->setSpriteMasks(prepared);
+    }
+}
+
+void BatchRunner::reset() {
+    for (size_t i = 0; i < games.size(); ++i) {
+        startGame(i);
+        observe(i, 0);
+        rewards[i] = 0.0f;
+        done[i] = 0;
+    }
+}
+
+void BatchRunner::startGame(size_t instance) {
+    Rng& random = seeds[instance];
+    std::uint64_t seed = static_cast<std::uint64_t>(random.next()) << 32 | random.next();
+    Simulation& game = *games[instance];
+    game.reset(seed);
+    scores[instance] = game.getScore();
+    lives[instance] = game.getShip().lives;
+    gameTicks[instance] = 0;
+}
+
+void BatchRunner::stepInstance(size_t instance, const TickInput& action, float dt) {
+    Simulation& game = *games[instance];
+    game.step(dt, action);
+    ++gameTicks[instance];
+
+    int score = game.getScore();
+    int livesLeft = game.getShip().lives;
+    rewards[instance] = static_cast<float>(score - scores[instance]) -
+                        lifePenalty * static_cast<float>(lives[instance] - livesLeft);
+    scores[instance] = score;
+    lives[instance] = livesLeft;
+    done[instance] = game.isGameOver() || (maxTicks > 0 && gameTicks[instance] >= maxTicks);
+}
+
+// The meteors come from the broadphase grid around the ship, so an observation costs the
+// same however many meteors are elsewhere in the field.
+void BatchRunner::observe(size_t instance, unsigned worker) {
+    const Simulation& game = *games[instance];
+    const ShipState& ship = game.getShip();
+    const MeteorField& meteors = game.getMeteors();
+    float* observation = observations.data() + instance * observationSize;
+    float width = config.fieldWidth;
+    float height = config.fieldHeight;
+
+    float angle = ship.rotation * degreesToRadians;
+    observation[0] = ship.position.x / width;
+    observation[1] = ship.position.y / height;
+    observation[2] = std::sin(angle);
+    observation[3] = -std::cos(angle);
+    observation[4] = static_cast<float>(ship.lives);
+    observation[5] = ship.timeSinceShot >= config.fireInterval ? 1.0f : 0.0f;
+
+    std::vector<std::uint32_t>& found = workerFound[worker];
+    std::vector<Nearby>& nearby = workerNearby[worker];
+    float range = static_cast<float>(senseRange);
+    game.queryMeteors({ship.position.x - range, ship.position.y - range, range * 2.0f, range * 2.0f}, found);
+    nearby.clear();
+    for (std::uint32_t meteor : found) {
+        Bounds bounds = meteors.getBounds(meteor);
+        float offsetX = bounds.left + bounds.width / 2.0f - ship.position.x;
+        float offsetY = bounds.top + bounds.height / 2.0f - ship.position.y;
+        float distance = std::sqrt(offsetX * offsetX + offsetY * offsetY);
+        if (distance <= range) {
+            nearby.push_back({distance, meteor});
+        }
+    }
+    // Ties go to the lower index, so the order does not depend on the grid.
+    size_t shown = std::min(nearby.size(), static_cast<size_t>(nearestMeteors));
+    std::partial_sort(nearby.begin(), nearby.begin() + shown, nearby.end(), [](const Nearby& a, const Nearby& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.meteor < b.meteor;
+    });
+
+    float* meteorObservation = observation + shipFeatures;
+    for (size_t k = 0; k < static_cast<size_t>(nearestMeteors); ++k, meteorObservation += meteorFeatures) {
+        if (k >= shown) {
+            std::fill(meteorObservation, meteorObservation + meteorFeatures, 0.0f);
+            continue;
+        }
+        size_t meteor = nearby[k].meteor;
+        Bounds bounds = meteors.getBounds(meteor);
+        Vec2 velocity = meteors.getVelocity(meteor);
+        meteorObservation[0] = (bounds.left + bounds.width / 2.0f - ship.position.x) / width;
+        meteorObservation[1] = (bounds.top + bounds.height / 2.0f - ship.position.y) / height;
+        meteorObservation[2] = velocity.x / width;
+        meteorObservation[3] = velocity.y / height;
+        meteorObservation[4] = static_cast<float>(meteors.getStage(meteor) + 1);
+    }
+}
+
+void BatchRunner::step(float dt, const TickInput* actions) {
+    PROFILE_SCOPE("batch.step");
+    for (size_t i = 0; i < games.size(); ++i) {
+        totalTicks += !done[i];
+    }
+    auto advance = [this, dt, actions](size_t begin, size_t end, unsigned worker) {
+        for (size_t i = begin; i < end; ++i) {
+            if (done[i]) {
+                startGame(i);
+                rewards[i] = 0.0f;
+                done[i] = 0;
+            } else {
+                stepInstance(i, actions[i], dt);
+            }
+            observe(i, worker);
+        }
+    };
+    if (jobs != nullptr) {
+        jobs->parallelFor(games.size(), instanceChunk, advance);
+    } else {
+        advance(0, games.size(), 0);
+    }
+    for (size_t i = 0; i < games.size(); ++i) {
+        finishedGames += done[i];
+    }
+}
+
+std::uint64_t BatchRunner::computeStateHash() const {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const auto& game : games) {
+        std::uint64_t value = game->computeStateHash();
+        for (int byte = 0; byte < 8; ++byte) {
+            hash = (hash ^ ((value >> (byte * 8)) & 0xff)) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
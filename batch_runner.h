@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "rng.h"
+#include "simulation.h"
+
+class JobSystem;
+
+// Many independent games stepped together, for balancing runs and for training agents.
+// Every instance is its own Simulation with its own seed generator and takes its own input
+// each step; instances share nothing, so the outcome does not depend on how they are spread
+// over threads. step() advances them all across a job system and fills flat arrays indexed
+// by instance: observationSize floats, a reward and a done flag each.
+//
+// An instance that is done starts its next game at the following step instead of stepping:
+// that step's action is ignored, its reward is 0 and its observation is the first one of the
+// new game. So the observation that comes with a done flag is the last one of the old game.
+class BatchRunner {
+public:
+    // The ship: x and y as fractions of the field, the direction it faces as x and y, lives,
+    // and 1 if a shot is ready. Then for each of the nearest meteors within senseRange pixels,
+    // closest first: the offset of its centre and its velocity per second, both in field
+    // sizes, and its stage plus one. Zeros where fewer meteors are in range.
+    static const int shipFeatures = 6;
+    static const int meteorFeatures = 5;
+    static const int nearestMeteors = 8;
+    static const int observationSize = shipFeatures + meteorFeatures * nearestMeteors;
+    static const int senseRange = 800;
+
+private:
+    struct Nearby {
+        float distance;
+        std::uint32_t meteor;
+    };
+
+    SimConfig config;
+    JobSystem* jobs;
+    std::vector<std::unique_ptr<Simulation>> games;
+    std::vector<Rng> seeds;
+    std::vector<float> observations;
+    std::vector<float> rewards;
+    std::vector<std::uint8_t> done;
+    std::vector<int> scores;
+    std::vector<int> lives;
+    std::vector<int> gameTicks;
+    int maxTicks;
+    float lifePenalty;
+    std::uint64_t totalTicks;
+    std::uint64_t finishedGames;
+    // Scratch of the nearest-meteor search, one per job system thread.
+    std::vector<std::vector<std::uint32_t>> workerFound;
+    std::vector<std::vector<Nearby>> workerNearby;
+
+    void startGame(size_t instance);
+    void stepInstance(size_t instance, const TickInput& action, float dt);
+    void observe(size_t instance, unsigned worker);
+
+public:
+    // count instances of the game config describes. Instance i draws the seeds of its games
+    // from sequence i of a generator seeded with seed. Without a job system every step runs on
+    // the calling thread.
+    BatchRunner(const SimConfig& config, size_t count, std::uint64_t seed, JobSystem* jobs = nullptr);
+    // count instances of the game as it is played, gameSimConfig().
+    BatchRunner(size_t count, std::uint64_t seed, JobSystem* jobs = nullptr);
+
+    // Gives every instance the sprite masks, made once and shared among all of them.
+    void setSpriteMasks(const SpriteMasks& masks);
+
+    // Starts a new game in every instance.
+    void reset();
+    // Advances every instance by one tick of dt seconds; actions holds one input per instance.
+    void step(float dt, const TickInput* actions);
+
+    // Games are cut off and count as done after this many ticks; 0 lets them run until the
+    // last life is gone.
+    void setMaxTicks(int ticks) {
+        maxTicks = ticks;
+    }
+
+    // The reward of a tick is the points scored minus this for every life lost.
+    void setLifePenalty(float penalty) {
+        lifePenalty = penalty;
+    }
+
+    size_t size() const {
+        return games.size();
+    }
+
+    // size() * observationSize floats, one instance after the other.
+    const float* getObservations() const {
+        return observations.data();
+    }
+
+    const float* getObservation(size_t instance) const {
+        return observations.data() + instance * observationSize;
+    }
+
+    const float* getRewards() const {
+        return rewards.data();
+    }
+
+    const std::uint8_t* getDone() const {
+        return done.data();
+    }
+
+    const Simulation& getGame(size_t instance) const {
+        return *games[instance];
+    }
+
+    // Ticks stepped by all instances together since construction.
+    std::uint64_t getTotalTicks() const {
+        return totalTicks;
+    }
+
+    std::uint64_t getFinishedGames() const {
+        return finishedGames;
+    }
+
+    // The state hashes of all instances combined, for comparing runs.
+    std::uint64_t computeStateHash() const;
+};
@@ -0,0 +1,1017 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "alloc_tracker.h"
+#include "collision_mask.h"
+#include "input_source.h"
+#include "job_system.h"
+#include "meteor_field.h"
+#include "particle_system.h"
+#include "simulation.h"
+#include "spatial_grid.h"
+
+// Headless benchmark suite for the simulation hot paths.
+//
+// Scripted scenarios step a Simulation and report ns/tick, heap allocations per tick and
+// throughput, and list the profiled stages the allocations came from; the steady-state check
+// lets the autopilot play regular games with particle effects and requires that no tick
+// allocates once warmed up; the broadphase comparison times the old all-pairs
+// projectile/meteor scan against the uniform grid at a constant entity density; the
+// narrow-phase run times the pixel mask test per pair against the transformed bounding boxes
+// it refines; the particle run keeps 100k effect particles alive and times their update on
+// one core; the world run steps ever larger fields with and without sleeping meteors; the
+// sweep run compares the hit rates of discrete and swept projectile collisions at speeds
+// and tick rates where shots can pass through meteors; the scaling run steps one large
+// scene with 1 to N job system threads. Results print as a table, or one JSON object per
+// line with --json. --filter <text> runs only benchmarks whose name contains the text,
+// --quick runs a tenth of the ticks. Exits with 1 if the broadphase and the brute-force
+// scan disagree, if the steady state allocates, if a sleeping meteor comes near the ship,
+// if a swept shot misses or if the thread count changes the outcome of the scaling run.
+
+namespace {
+    struct Options {
+        bool json = false;
+        bool quick = false;
+        std::string filter;
+    };
+
+    bool selected(const Options& options, const std::string& name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    // Scenarios
+
+    struct Scenario {
+        const char* name;
+        SimConfig config;
+        int warmupTicks;
+        int ticks;
+        std::function<void(Simulation&, std::mt19937&)> setup;
+        std::function<void(Simulation&, std::mt19937&, int, TickInput&)> script;
+    };
+
+    struct ScenarioResult {
+        double nanosecondsPerTick;
+        double allocationsPerTick;
+        double bytesPerTick;
+        double ticksPerSecond;
+        double averageEntities;
+        double entityUpdatesPerSecond;
+        int ticks;
+        // Stages that allocated during the measured ticks.
+        std::vector<AllocationStageCounts> stages;
+    };
+
+    const float tickSeconds = 1.0f / 60;
+
+    SimConfig survivalConfig() {
+        // Lives never run out, so the ship stays in play for the whole run.
+        SimConfig config;
+        config.startLives = 1 << 30;
+        return config;
+    }
+
+    // Pointer on a circle around the field centre, so the ship turns and its shots spread.
+    Vec2 circlingPointer(const SimConfig& config, int tick) {
+        float angle = tick * 0.05f;
+        return {config.fieldWidth / 2.0f + std::cos(angle) * 200.0f,
+                config.fieldHeight / 2.0f + std::sin(angle) * 200.0f};
+    }
+
+    std::vector<Scenario> makeScenarios() {
+        std::vector<Scenario> scenarios;
+
+        Scenario burst;
+        burst.name = "meteor_burst";
+        burst.config = survivalConfig();
+        burst.warmupTicks = 60;
+        burst.ticks = 2000;
+        burst.setup = [](Simulation& simulation, std::mt19937& random) {
+            const SimConfig& config = simulation.getConfig();
+            std::uniform_real_distribution<float> x(0.0f, config.fieldWidth);
+            std::uniform_real_distribution<float> y(0.0f, config.fieldHeight);
+            std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+            for (int i = 0; i < 2000; ++i) {
+                simulation.spawnMeteor({x(random), y(random)},
+                                       {direction(random) * config.meteorSpeed, direction(random) * config.meteorSpeed},
+                                       static_cast<int>(random() % Simulation::meteorStageCount));
+            }
+        };
+        burst.script = [](Simulation& simulation, std::mt19937&, int, TickInput& input) {
+            input.pointer = {simulation.getConfig().fieldWidth / 2.0f, simulation.getConfig().fieldHeight / 2.0f};
+            input.fire = false;
+        };
+        scenarios.push_back(burst);
+
+        Scenario fire;
+        fire.name = "sustained_fire";
+        fire.config = survivalConfig();
+        fire.config.fireInterval = 0.0f;
+        fire.config.meteorSpawnInterval = 0.05f;
+        fire.warmupTicks = 600;
+        fire.ticks = 6000;
+        fire.setup = [](Simulation&, std::mt19937&) {};
+        fire.script = [](Simulation& simulation, std::mt19937&, int tick, TickInput& input) {
+            input.pointer = circlingPointer(simulation.getConfig(), tick);
+            input.fire = true;
+        };
+        scenarios.push_back(fire);
+
+        Scenario churn;
+        churn.name = "edge_churn";
+        churn.config = survivalConfig();
+        churn.warmupTicks = 120;
+        churn.ticks = 6000;
+        churn.setup = [](Simulation&, std::mt19937&) {};
+        churn.script = [](Simulation& simulation, std::mt19937& random, int, TickInput& input) {
+            // Meteors appear just inside an edge and leave through it a few ticks later.
+            const SimConfig& config = simulation.getConfig();
+            std::uniform_real_distribution<float> along(0.0f, 1.0f);
+            const float speed = 600.0f;
+            for (int i = 0; i < 50; ++i) {
+                int stage = static_cast<int>(random() % Simulation::meteorStageCount);
+                const Vec2& size = config.meteorSizes[stage];
+                switch (random() % 4) {
+                    case 0:
+                        simulation.spawnMeteor({along(random) * config.fieldWidth, -size.y + 1.0f}, {0.0f, -speed}, stage);
+                        break;
+                    case 1:
+                        simulation.spawnMeteor({config.fieldWidth - 1.0f, along(random) * config.fieldHeight}, {speed, 0.0f}, stage);
+                        break;
+                    case 2:
+                        simulation.spawnMeteor({along(random) * config.fieldWidth, config.fieldHeight - 1.0f}, {0.0f, speed}, stage);
+                        break;
+                    default:
+                        simulation.spawnMeteor({-size.x + 1.0f, along(random) * config.fieldHeight}, {-speed, 0.0f}, stage);
+                        break;
+                }
+            }
+            input.pointer = {config.fieldWidth / 2.0f, config.fieldHeight / 2.0f};
+            input.fire = false;
+        };
+        scenarios.push_back(churn);
+
+        // A long regular game; allocations in the measured second half mean memory grows
+        // (or at least churns) in steady state.
+        Scenario longRun;
+        longRun.name = "long_run";
+        longRun.config = survivalConfig();
+        longRun.config.meteorSpawnInterval = 0.1f;
+        longRun.warmupTicks = 100000;
+        longRun.ticks = 100000;
+        longRun.setup = [](Simulation&, std::mt19937&) {};
+        longRun.script = [](Simulation& simulation, std::mt19937&, int tick, TickInput& input) {
+            input.pointer = circlingPointer(simulation.getConfig(), tick);
+            input.fire = tick % 10 == 0;
+        };
+        scenarios.push_back(longRun);
+
+        return scenarios;
+    }
+
+    void getStagesBefore(std::vector<AllocationStageCounts>& stages) {
+        stages.reserve(AllocationTracker::maxStages + 1);
+        AllocationTracker::getStages(stages);
+    }
+
+    // The allocations of every stage since `before` was taken, leaving out stages without any.
+    std::vector<AllocationStageCounts> stagesSince(const std::vector<AllocationStageCounts>& before) {
+        std::vector<AllocationStageCounts> after;
+        AllocationTracker::getStages(after);
+        std::vector<AllocationStageCounts> result;
+        for (const auto& stage : after) {
+            AllocationCounts counts = stage.counts;
+            for (const auto& old : before) {
+                if (old.name == stage.name) {
+                    counts.allocations -= old.counts.allocations;
+                    counts.bytes -= old.counts.bytes;
+                    break;
+                }
+            }
+            if (counts.allocations > 0) {
+                result.push_back({stage.name, counts});
+            }
+        }
+        return result;
+    }
+
+    ScenarioResult runScenario(const Scenario& scenario, bool quick) {
+        int warmupTicks = quick ? scenario.warmupTicks / 10 : scenario.warmupTicks;
+        int ticks = std::max(1, quick ? scenario.ticks / 10 : scenario.ticks);
+
+        std::mt19937 random(1234);
+        Simulation simulation(scenario.config);
+        scenario.setup(simulation, random);
+
+        TickInput input = {{0.0f, 0.0f}, false};
+        for (int tick = 0; tick < warmupTicks; ++tick) {
+            scenario.script(simulation, random, tick, input);
+            simulation.step(tickSeconds, input);
+        }
+
+        double entityTicks = 0.0;
+        std::vector<AllocationStageCounts> stagesBefore;
+        getStagesBefore(stagesBefore);
+        AllocationCounts before = AllocationTracker::getTotals();
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = warmupTicks; tick < warmupTicks + ticks; ++tick) {
+            scenario.script(simulation, random, tick, input);
+            simulation.step(tickSeconds, input);
+            entityTicks += simulation.getMeteors().size() + simulation.getProjectiles().size();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        AllocationCounts after = AllocationTracker::getTotals();
+
+        ScenarioResult result;
+        result.ticks = ticks;
+        result.nanosecondsPerTick = seconds * 1.0e9 / ticks;
+        result.allocationsPerTick = static_cast<double>(after.allocations - before.allocations) / ticks;
+        result.bytesPerTick = static_cast<double>(after.bytes - before.bytes) / ticks;
+        result.stages = stagesSince(stagesBefore);
+        result.ticksPerSecond = ticks / seconds;
+        result.averageEntities = entityTicks / ticks;
+        result.entityUpdatesPerSecond = entityTicks / seconds;
+        return result;
+    }
+
+    void runScenarios(const Options& options) {
+        if (!options.json) {
+            std::printf("%-16s %12s %12s %12s %12s %10s %14s\n", "scenario", "ns/tick", "allocs/tick", "bytes/tick",
+                        "ticks/s", "entities", "entity-upd/s");
+        }
+        std::vector<std::pair<const char*, ScenarioResult>> results;
+        for (const auto& scenario : makeScenarios()) {
+            if (!selected(options, scenario.name)) {
+                continue;
+            }
+            ScenarioResult result = runScenario(scenario, options.quick);
+            if (options.json) {
+                std::string stages;
+                for (const auto& stage : result.stages) {
+                    char entry[128];
+                    std::snprintf(entry, sizeof(entry), "%s\"%s\":%.4f", stages.empty() ? "" : ",", stage.name,
+                                  static_cast<double>(stage.counts.allocations) / result.ticks);
+                    stages += entry;
+                }
+                std::printf("{\"benchmark\":\"%s\",\"ns_per_tick\":%.1f,\"allocs_per_tick\":%.4f,"
+                            "\"bytes_per_tick\":%.1f,\"ticks_per_second\":%.1f,\"avg_entities\":%.1f,"
+                            "\"entity_updates_per_second\":%.0f,\"allocs_per_tick_by_stage\":{%s}}\n",
+                            scenario.name, result.nanosecondsPerTick, result.allocationsPerTick, result.bytesPerTick,
+                            result.ticksPerSecond, result.averageEntities, result.entityUpdatesPerSecond,
+                            stages.c_str());
+            } else {
+                std::printf("%-16s %12.0f %12.4f %12.1f %12.0f %10.1f %14.0f\n", scenario.name,
+                            result.nanosecondsPerTick, result.allocationsPerTick, result.bytesPerTick,
+                            result.ticksPerSecond, result.averageEntities, result.entityUpdatesPerSecond);
+                results.emplace_back(scenario.name, result);
+            }
+        }
+
+        bool headerPrinted = false;
+        for (const auto& entry : results) {
+            for (const auto& stage : entry.second.stages) {
+                if (!headerPrinted) {
+                    std::printf("\n%-16s %-28s %12s %12s\n", "allocations", "stage", "allocs/tick", "bytes/tick");
+                    headerPrinted = true;
+                }
+                std::printf("%-16s %-28s %12.4f %12.1f\n", entry.first, stage.name,
+                            static_cast<double>(stage.counts.allocations) / entry.second.ticks,
+                            static_cast<double>(stage.counts.bytes) / entry.second.ticks);
+            }
+        }
+    }
+
+    // Steady-state check
+
+    // Regular games, one after another, as the autopilot plays them in the game: default
+    // settings, lives that run out, and a burst of particles for every event. The warm-up
+    // covers the first games, in which the storage grows to its working size; from then on
+    // a single allocation in any tick fails the check.
+    bool runSteadyStateCheck(const Options& options) {
+        const char* name = "steady_state";
+        if (!selected(options, name)) {
+            return true;
+        }
+        const long long warmupTicks = (options.quick ? 1 : 10) * 60LL * 60;
+        const long long ticks = (options.quick ? 6 : 60) * 60LL * 60;
+        std::uint64_t seed = 1;
+        Simulation simulation;
+        simulation.reset(seed);
+        Autopilot autopilot(seed);
+        ParticleSystem particles(50000, 1.5f);
+        ParticleBurst burst = {{0.0f, 0.0f}, {0.0f, 0.0f}, 200, 60.0f, 30.0f, 200.0f, 0.5f, 1.5f, 2.0f, 8.0f,
+                               0x8a7a6aff};
+
+        int games = 0;
+        long long allocatingTicks = 0;
+        std::vector<AllocationStageCounts> stagesBefore;
+        AllocationCounts before = {0, 0};
+        auto start = std::chrono::steady_clock::now();
+        for (long long tick = 0; tick < warmupTicks + ticks; ++tick) {
+            if (tick == warmupTicks) {
+                games = 0;
+                getStagesBefore(stagesBefore);
+                before = AllocationTracker::getTotals();
+                start = std::chrono::steady_clock::now();
+            }
+            std::uint64_t allocations = AllocationTracker::getTotals().allocations;
+            TickInput input = autopilot.next(simulation);
+            simulation.step(tickSeconds, input);
+            for (const SimEvent& event : simulation.getEvents()) {
+                burst.position = event.position;
+                burst.velocity = event.velocity;
+                particles.emit(burst);
+            }
+            particles.update(tickSeconds);
+            if (simulation.isGameOver()) {
+                ++games;
+                ++seed;
+                simulation.reset(seed);
+                autopilot = Autopilot(seed);
+                particles.clear();
+            }
+            if (tick >= warmupTicks && AllocationTracker::getTotals().allocations != allocations) {
+                ++allocatingTicks;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        AllocationCounts after = AllocationTracker::getTotals();
+        std::uint64_t allocations = after.allocations - before.allocations;
+        std::uint64_t bytes = after.bytes - before.bytes;
+
+        if (options.json) {
+            std::printf("{\"benchmark\":\"%s\",\"ticks\":%lld,\"games\":%d,\"ns_per_tick\":%.0f,"
+                        "\"allocs\":%llu,\"bytes\":%llu,\"allocating_ticks\":%lld}\n",
+                        name, ticks, games, seconds * 1.0e9 / ticks, static_cast<unsigned long long>(allocations),
+                        static_cast<unsigned long long>(bytes), allocatingTicks);
+        } else {
+            std::printf("\n%-16s %12s %8s %12s %10s %12s %16s\n", "steady state", "ticks", "games", "ns/tick",
+                        "allocs", "bytes", "allocating ticks");
+            std::printf("%-16s %12lld %8d %12.0f %10llu %12llu %16lld\n", name, ticks, games, seconds * 1.0e9 / ticks,
+                        static_cast<unsigned long long>(allocations), static_cast<unsigned long long>(bytes),
+                        allocatingTicks);
+        }
+        if (allocations == 0) {
+            return true;
+        }
+        std::fprintf(stderr, "the steady state allocated in %lld ticks:\n", allocatingTicks);
+        for (const auto& stage : stagesSince(stagesBefore)) {
+            std::fprintf(stderr, "  %s: %llu allocations, %llu bytes\n", stage.name,
+                         static_cast<unsigned long long>(stage.counts.allocations),
+                         static_cast<unsigned long long>(stage.counts.bytes));
+        }
+        return false;
+    }
+
+    // Broadphase comparison
+
+    const float meteorSize = 75.0f;
+    const float projectileSize = 16.0f;
+    // Field area per entity, chosen so the default 1920x1080 field holds about 100 entities.
+    const float areaPerEntity = 1920.0f * 1080.0f / 100.0f;
+
+    struct CollisionScene {
+        float fieldWidth;
+        float fieldHeight;
+        MeteorField meteors;
+        std::vector<Bounds> projectiles;
+    };
+
+    CollisionScene makeScene(size_t entities, unsigned seed) {
+        CollisionScene scene;
+        float scale = std::sqrt(entities * areaPerEntity / (1920.0f * 1080.0f));
+        scene.fieldWidth = 1920.0f * scale;
+        scene.fieldHeight = 1080.0f * scale;
+
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> x(0.0f, scene.fieldWidth);
+        std::uniform_real_distribution<float> y(0.0f, scene.fieldHeight);
+        size_t meteorCount = entities / 2;
+        scene.meteors.reserve(meteorCount);
+        for (size_t i = 0; i < meteorCount; ++i) {
+            scene.meteors.add({x(random), y(random)}, {0.0f, 0.0f}, 1.0f, 0, {meteorSize, meteorSize});
+        }
+        for (size_t i = meteorCount; i < entities; ++i) {
+            scene.projectiles.push_back({x(random), y(random), projectileSize, projectileSize});
+        }
+        return scene;
+    }
+
+    size_t bruteForcePass(const CollisionScene& scene) {
+        size_t hits = 0;
+        for (const auto& projectile : scene.projectiles) {
+            for (size_t j = 0; j < scene.meteors.size(); ++j) {
+                if (projectile.intersects(scene.meteors.getBounds(j))) {
+                    ++hits;
+                }
+            }
+        }
+        return hits;
+    }
+
+    size_t gridPass(const CollisionScene& scene, SpatialGrid& grid, std::vector<std::uint32_t>& candidates) {
+        const MeteorField& meteors = scene.meteors;
+        grid.build(meteors.size(), meteors.getPositionsX().data(), meteors.getPositionsY().data(),
+                   meteors.getWidths().data(), meteors.getHeights().data());
+        size_t hits = 0;
+        for (const auto& projectile : scene.projectiles) {
+            grid.query(projectile, candidates);
+            for (std::uint32_t index : candidates) {
+                if (projectile.intersects(meteors.getBounds(index))) {
+                    ++hits;
+                }
+            }
+        }
+        return hits;
+    }
+
+    template <typename Pass>
+    double nanosecondsPerPass(Pass pass, int iterations, size_t& hits) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            hits = pass();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+
+    bool runBroadphaseBenchmark(const Options& options) {
+        bool matched = true;
+        bool headerPrinted = false;
+        for (size_t entities : {100, 1000, 10000}) {
+            std::string name = "broadphase_" + std::to_string(entities);
+            if (!selected(options, name)) {
+                continue;
+            }
+            if (!options.json && !headerPrinted) {
+                std::printf("\n%-16s %16s %16s %10s %8s\n", "broadphase", "brute ns/pass", "grid ns/pass", "speedup",
+                            "hits");
+                headerPrinted = true;
+            }
+            CollisionScene scene = makeScene(entities, 1234);
+            SpatialGrid grid;
+            grid.configure(0.0f, 0.0f, scene.fieldWidth, scene.fieldHeight, meteorSize);
+            std::vector<std::uint32_t> candidates;
+            int iterations = static_cast<int>(std::max<size_t>(1, 2000000 / (entities * entities / 4 + 1)));
+            if (options.quick) {
+                iterations = std::max(1, iterations / 10);
+            }
+
+            size_t bruteHits = 0;
+            size_t gridHits = 0;
+            double brute = nanosecondsPerPass([&] { return bruteForcePass(scene); }, iterations, bruteHits);
+            double gridTime = nanosecondsPerPass([&] { return gridPass(scene, grid, candidates); }, iterations, gridHits);
+            if (bruteHits != gridHits) {
+                std::fprintf(stderr, "hit count mismatch at %zu entities: brute %zu, grid %zu\n",
+                             entities, bruteHits, gridHits);
+                matched = false;
+            }
+            if (options.json) {
+                std::printf("{\"benchmark\":\"%s\",\"brute_ns_per_pass\":%.0f,\"grid_ns_per_pass\":%.0f,"
+                            "\"speedup\":%.2f,\"hits\":%zu}\n",
+                            name.c_str(), brute, gridTime, brute / gridTime, gridHits);
+            } else {
+                std::printf("%-16zu %16.0f %16.0f %9.1fx %8zu\n", entities, brute, gridTime, brute / gridTime, gridHits);
+            }
+        }
+        return matched;
+    }
+
+    // Narrow phase
+
+    // Stand-in sprites for the shipped art: a lumpy disc for the meteor, a triangle for the
+    // ship and a disc for the projectile, with transparent margins like the PNGs.
+    CollisionMask makeMask(int width, int height, int shape) {
+        std::vector<std::uint8_t> pixels(static_cast<size_t>(width) * height * 4, 0);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                float u = (x + 0.5f) / width * 2.0f - 1.0f;
+                float v = (y + 0.5f) / height * 2.0f - 1.0f;
+                bool solid;
+                if (shape == 0) {
+                    float radius = 0.8f + 0.08f * std::sin(std::atan2(v, u) * 7.0f);
+                    solid = u * u + v * v < radius * radius;
+                } else if (shape == 1) {
+                    solid = v > -0.9f && v < 0.9f && std::fabs(u) < (v + 0.9f) / 1.8f * 0.9f;
+                } else {
+                    solid = u * u + v * v < 0.5f;
+                }
+                pixels[(static_cast<size_t>(y) * width + x) * 4 + 3] = solid ? 255 : 0;
+            }
+        }
+        return CollisionMask::fromRgba(pixels.data(), width, height, static_cast<size_t>(width) * 4);
+    }
+
+    // What getGlobalBounds() did for a rotated sprite: transform the four corners and take
+    // their bounding box.
+    Bounds transformedBounds(Vec2 position, Vec2 origin, Vec2 size, float degrees) {
+        float angle = degrees * 3.14159265f / 180.0f;
+        float cosine = std::cos(angle);
+        float sine = std::sin(angle);
+        float corners[4][2] = {{0.0f, 0.0f}, {size.x, 0.0f}, {0.0f, size.y}, {size.x, size.y}};
+        float minX = 1.0e30f, minY = 1.0e30f, maxX = -1.0e30f, maxY = -1.0e30f;
+        for (const auto& corner : corners) {
+            float x = corner[0] - origin.x;
+            float y = corner[1] - origin.y;
+            float screenX = position.x + cosine * x - sine * y;
+            float screenY = position.y + sine * x + cosine * y;
+            minX = std::min(minX, screenX);
+            maxX = std::max(maxX, screenX);
+            minY = std::min(minY, screenY);
+            maxY = std::max(maxY, screenY);
+        }
+        return {minX, minY, maxX - minX, maxY - minY};
+    }
+
+    struct NarrowPair {
+        Vec2 position;
+        float rotation;
+    };
+
+    // Broadphase candidates around one meteor at the origin: the old per-pair cost (the
+    // transformed bounding boxes of both sprites and their overlap) against the new one (a
+    // box test on precomputed boxes, then the mask test for boxes that overlap). Ship pairs
+    // share their rotation in groups of 64, as all pairs of one tick do. Also reports how
+    // many box hits the masks keep.
+    void runNarrowphaseBenchmark(const Options& options) {
+        const Vec2 meteorSprite = {300.0f, 300.0f};
+        const Vec2 shipSprite = {153.0f, 108.0f};
+        const Vec2 projectileSprite = {65.0f, 65.0f};
+        CollisionMask meteorMask = makeMask(300, 300, 0);
+        CollisionMask projectileMask = makeMask(65, 65, 2);
+        CollisionMask shipMask = makeMask(153, 108, 1);
+        std::vector<CollisionMask> shipMasks;
+        for (int step = 0; step < Simulation::shipMaskRotations; ++step) {
+            shipMasks.push_back(shipMask.rotated(step * 360.0f / Simulation::shipMaskRotations));
+        }
+        Bounds meteorBounds = {0.0f, 0.0f, meteorSprite.x, meteorSprite.y};
+
+        bool headerPrinted = false;
+        for (int ship = 0; ship < 2; ++ship) {
+            std::string name = ship ? "narrowphase_ship" : "narrowphase_projectile";
+            if (!selected(options, name)) {
+                continue;
+            }
+            if (!options.json && !headerPrinted) {
+                std::printf("\n%-24s %14s %14s %14s\n", "narrowphase", "bounds ns/pair", "mask ns/pair",
+                            "box hits kept");
+                headerPrinted = true;
+            }
+
+            Vec2 size = ship ? shipSprite : projectileSprite;
+            std::mt19937 random(7);
+            std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+            std::uniform_real_distribution<float> x(-meteorSprite.x / 2.0f, meteorSprite.x * 1.5f);
+            std::uniform_real_distribution<float> y(-meteorSprite.y / 2.0f, meteorSprite.y * 1.5f);
+            std::vector<NarrowPair> pairs(4096);
+            float rotation = 0.0f;
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                if (ship && i % 64 == 0) {
+                    rotation = angle(random);
+                }
+                pairs[i] = {{x(random), y(random)}, rotation};
+            }
+
+            int rounds = options.quick ? 20 : 200;
+            size_t boxHits = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int round = 0; round < rounds; ++round) {
+                for (const auto& pair : pairs) {
+                    Bounds a = transformedBounds(pair.position, {size.x / 2.0f, size.y / 2.0f}, size, pair.rotation);
+                    Bounds b = transformedBounds({0.0f, 0.0f}, {0.0f, 0.0f}, meteorSprite, 0.0f);
+                    boxHits += a.intersects(b);
+                }
+            }
+            double boundsTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            size_t maskHits = 0;
+            start = std::chrono::steady_clock::now();
+            for (int round = 0; round < rounds; ++round) {
+                for (const auto& pair : pairs) {
+                    float turns = pair.rotation / 360.0f;
+                    int step = static_cast<int>(std::floor((turns - std::floor(turns)) * Simulation::shipMaskRotations + 0.5f)) %
+                               Simulation::shipMaskRotations;
+                    const CollisionMask& mask = ship ? shipMasks[step] : projectileMask;
+                    float width = static_cast<float>(mask.getSpriteWidth());
+                    float height = static_cast<float>(mask.getSpriteHeight());
+                    Bounds box = {pair.position.x - width / 2.0f, pair.position.y - height / 2.0f, width, height};
+                    if (box.intersects(meteorBounds)) {
+                        maskHits += mask.overlaps(meteorMask, static_cast<int>(std::lround(-box.left)),
+                                                  static_cast<int>(std::lround(-box.top)));
+                    }
+                }
+            }
+            double maskTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            double pairCount = static_cast<double>(pairs.size()) * rounds;
+            double kept = boxHits > 0 ? static_cast<double>(maskHits) / boxHits : 0.0;
+            if (options.json) {
+                std::printf("{\"benchmark\":\"%s\",\"bounds_ns_per_pair\":%.1f,\"mask_ns_per_pair\":%.1f,"
+                            "\"box_hits_kept\":%.3f}\n",
+                            name.c_str(), boundsTime / pairCount, maskTime / pairCount, kept);
+            } else {
+                std::printf("%-24s %14.1f %14.1f %13.1f%%\n", name.c_str(), boundsTime / pairCount,
+                            maskTime / pairCount, kept * 100.0);
+            }
+        }
+    }
+
+    // Particles
+
+    // A particle pool held at 100k live particles by explosion-sized bursts that replace the
+    // ones dying each tick, as a long run of hits would. Reports the update and emission
+    // cost per 60 Hz tick on the calling thread and the heap allocations, which must be 0.
+    void runParticleBenchmark(const Options& options) {
+        const char* name = "particles_100k";
+        if (!selected(options, name)) {
+            return;
+        }
+        const size_t liveParticles = 100000;
+        ParticleSystem particles(liveParticles, 1.5f);
+        ParticleBurst burst = {{960.0f, 540.0f}, {10.0f, 5.0f}, 300, 60.0f, 30.0f, 300.0f, 1.0f, 2.0f, 2.0f, 8.0f,
+                               0xffa030ff};
+        Rng random(3);
+        auto refill = [&]() {
+            while (particles.getCount() + static_cast<size_t>(burst.count) <= liveParticles) {
+                burst.position = {random.nextFloat() * 1920.0f, random.nextFloat() * 1080.0f};
+                particles.emit(burst);
+            }
+        };
+        refill();
+
+        int ticks = options.quick ? 60 : 600;
+        double liveTicks = 0.0;
+        std::uint64_t allocationsBefore = AllocationTracker::getTotals().allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; ++tick) {
+            particles.update(tickSeconds);
+            refill();
+            liveTicks += particles.getCount();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double allocations = static_cast<double>(AllocationTracker::getTotals().allocations - allocationsBefore);
+
+        double nanosecondsPerTick = seconds * 1.0e9 / ticks;
+        double budget = nanosecondsPerTick / (1.0e9 / 60.0) * 100.0;
+        if (options.json) {
+            std::printf("{\"benchmark\":\"%s\",\"ns_per_tick\":%.0f,\"avg_particles\":%.0f,"
+                        "\"ns_per_particle\":%.2f,\"frame_budget_percent\":%.2f,\"allocs\":%.0f}\n",
+                        name, nanosecondsPerTick, liveTicks / ticks, seconds * 1.0e9 / liveTicks, budget, allocations);
+        } else {
+            std::printf("\n%-16s %12s %12s %12s %12s %8s\n", "particles", "ns/tick", "particles", "ns/particle",
+                        "60Hz budget", "allocs");
+            std::printf("%-16s %12.0f %12.0f %12.2f %11.2f%% %8.0f\n", name, nanosecondsPerTick, liveTicks / ticks,
+                        seconds * 1.0e9 / liveTicks, budget, allocations);
+        }
+    }
+
+    // Large world
+
+    // Worlds 2 to 8 screens wide and high at the same meteor density, stepped with every
+    // meteor awake and then with the ones far from the ship asleep, while the ship flies at
+    // full speed from one random point of the field to the next. With sleeping the cost of a
+    // tick should stay close to that of the smallest world. Every tick each sleeping meteor
+    // is checked where it really is by now, which has to be farther than awakeDistance from
+    // the ship; otherwise it could be on screen without being drawn or hit.
+    double runWorld(int screens, bool sleeping, int ticks, size_t& awake, long long& tooClose) {
+        SimConfig config = survivalConfig();
+        config.fieldWidth = 1920.0f * screens;
+        config.fieldHeight = 1080.0f * screens;
+        config.meteorSpawnInterval = 1.0e9f;
+        config.shipSpeed = 1500.0f;
+        if (sleeping) {
+            config.awakeDistance = 960.0f + 512.0f;
+        }
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> x(0.0f, config.fieldWidth);
+        std::uniform_real_distribution<float> y(0.0f, config.fieldHeight);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+        Simulation simulation(config);
+        for (int i = 0; i < 200 * screens * screens; ++i) {
+            simulation.spawnMeteor({x(random), y(random)}, {direction(random) * 60.0f, direction(random) * 60.0f}, 2);
+        }
+        TickInput input = {{config.fieldWidth / 2.0f, config.fieldHeight / 2.0f}, false};
+        double seconds = 0.0;
+        for (int tick = 0; tick < ticks; ++tick) {
+            if (tick % 120 == 0) {
+                input.pointer = {x(random), y(random)};
+            }
+            auto start = std::chrono::steady_clock::now();
+            simulation.step(tickSeconds, input);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const MeteorField& meteors = simulation.getMeteors();
+            Vec2 ship = simulation.getShip().position;
+            std::uint32_t lastTick = static_cast<std::uint32_t>(simulation.getTickCount() - 1);
+            for (size_t i = simulation.getAwakeMeteorCount(); i < meteors.size(); ++i) {
+                float missed = static_cast<float>(lastTick - meteors.getMovedTick(i)) * tickSeconds;
+                Bounds bounds = meteors.getBounds(i);
+                Vec2 velocity = meteors.getVelocity(i);
+                float left = bounds.left + velocity.x * missed;
+                float top = bounds.top + velocity.y * missed;
+                tooClose += left + bounds.width > ship.x - config.awakeDistance &&
+                            left < ship.x + config.awakeDistance &&
+                            top + bounds.height > ship.y - config.awakeDistance &&
+                            top < ship.y + config.awakeDistance;
+            }
+        }
+        awake = simulation.getAwakeMeteorCount();
+        return seconds * 1.0e9 / ticks;
+    }
+
+    bool runWorldBenchmark(const Options& options) {
+        bool headerPrinted = false;
+        bool asleepFar = true;
+        for (int screens = 2; screens <= 8; screens *= 2) {
+            for (bool sleeping : {false, true}) {
+                std::string name = (sleeping ? "world_lod_" : "world_full_") + std::to_string(screens);
+                if (!selected(options, name)) {
+                    continue;
+                }
+                if (!options.json && !headerPrinted) {
+                    std::printf("\n%-16s %12s %12s %12s %12s\n", "world", "meteors", "awake", "ns/tick", "too close");
+                    headerPrinted = true;
+                }
+                size_t awake = 0;
+                long long tooClose = 0;
+                double nanoseconds = runWorld(screens, sleeping, options.quick ? 600 : 6000, awake, tooClose);
+                int meteors = 200 * screens * screens;
+                if (tooClose > 0) {
+                    std::fprintf(stderr, "%s: %lld sleeping meteor ticks within awakeDistance of the ship\n",
+                                 name.c_str(), tooClose);
+                    asleepFar = false;
+                }
+                if (options.json) {
+                    std::printf("{\"benchmark\":\"%s\",\"meteors\":%d,\"awake\":%zu,\"ns_per_tick\":%.0f,"
+                                "\"sleeping_too_close\":%lld}\n",
+                                name.c_str(), meteors, awake, nanoseconds, tooClose);
+                } else {
+                    std::printf("%-16s %12d %12zu %12.0f %12lld\n", name.c_str(), meteors, awake, nanoseconds,
+                                tooClose);
+                }
+            }
+        }
+        return asleepFar;
+    }
+
+    // Job system scaling
+
+    // A field 16 screens wide and high with 20k small meteors and the projectile pool kept
+    // full, so movement and collision detection dominate a tick.
+    SimConfig scalingConfig() {
+        SimConfig config = survivalConfig();
+        config.fieldWidth = 1920.0f * 16;
+        config.fieldHeight = 1080.0f * 16;
+        config.meteorSpawnInterval = 1.0e9f;
+        config.projectileCapacity = 16384;
+        config.projectileSize = {projectileSize, projectileSize};
+        for (auto& size : config.meteorSizes) {
+            size = {meteorSize, meteorSize};
+        }
+        return config;
+    }
+
+    double runScaling(unsigned threads, int ticks, std::uint64_t& stateHash, bool swept = false) {
+        SimConfig config = scalingConfig();
+        config.sweptProjectiles = swept;
+        std::mt19937 random(99);
+        std::uniform_real_distribution<float> x(0.0f, config.fieldWidth);
+        std::uniform_real_distribution<float> y(0.0f, config.fieldHeight);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+        JobSystem jobs(threads);
+        Simulation simulation(config);
+        simulation.setJobSystem(&jobs);
+        for (int i = 0; i < 20000; ++i) {
+            simulation.spawnMeteor({x(random), y(random)}, {direction(random) * 60.0f, direction(random) * 60.0f}, 0);
+        }
+
+        TickInput input = {{config.fieldWidth / 2.0f, config.fieldHeight / 2.0f}, false};
+        double seconds = 0.0;
+        for (int tick = 0; tick < ticks; ++tick) {
+            // Projectiles that hit something are replaced before the next tick.
+            while (!simulation.getProjectiles().full()) {
+                Projectile projectile;
+                projectile.position = {x(random), y(random)};
+                projectile.velocity = {direction(random) * 400.0f, direction(random) * 400.0f};
+                projectile.rotation = 0.0f;
+                simulation.spawnProjectile(projectile);
+            }
+            auto start = std::chrono::steady_clock::now();
+            simulation.step(tickSeconds, input);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        stateHash = simulation.computeStateHash();
+        return seconds * 1.0e9 / ticks;
+    }
+
+    bool runScalingBenchmark(const Options& options) {
+        std::vector<unsigned> threadCounts;
+        unsigned hardwareThreads = std::max(2u, std::thread::hardware_concurrency());
+        for (unsigned threads = 1; threads < hardwareThreads; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(hardwareThreads);
+
+        bool deterministic = true;
+        bool headerPrinted = false;
+        double baseline = 0.0;
+        std::uint64_t baselineHash = 0;
+        for (unsigned threads : threadCounts) {
+            std::string name = "scaling_" + std::to_string(threads);
+            if (!selected(options, name)) {
+                continue;
+            }
+            if (!options.json && !headerPrinted) {
+                std::printf("\n%-16s %12s %10s %18s\n", "threads", "ns/tick", "speedup", "state hash");
+                headerPrinted = true;
+            }
+            std::uint64_t stateHash = 0;
+            double nanoseconds = runScaling(threads, options.quick ? 30 : 300, stateHash);
+            if (baseline == 0.0) {
+                baseline = nanoseconds;
+                baselineHash = stateHash;
+            } else if (stateHash != baselineHash) {
+                std::fprintf(stderr, "state hash with %u threads differs from the first run\n", threads);
+                deterministic = false;
+            }
+            if (options.json) {
+                std::printf("{\"benchmark\":\"%s\",\"threads\":%u,\"ns_per_tick\":%.1f,\"speedup\":%.2f,"
+                            "\"state_hash\":\"%016llx\"}\n",
+                            name.c_str(), threads, nanoseconds, baseline / nanoseconds,
+                            static_cast<unsigned long long>(stateHash));
+            } else {
+                std::printf("%-16u %12.0f %9.2fx   %016llx\n", threads, nanoseconds, baseline / nanoseconds,
+                            static_cast<unsigned long long>(stateHash));
+            }
+        }
+        return deterministic;
+    }
+
+    // Swept collisions
+
+    struct SweepCase {
+        const char* name;
+        float tickRate;
+        float projectileSpeed;
+        float meteorSpeed;
+    };
+
+    // One meteor and one projectile on a collision course, from 300 to 450 pixels apart: a
+    // projectile flying at a still meteor, or a meteor flying at a still projectile. Steps
+    // until the projectile hits or both have passed each other, and returns whether it hit.
+    bool runSweepTrial(const SweepCase& sweepCase, bool swept, std::mt19937& random, long long& ticks,
+                       double& seconds) {
+        SimConfig config = survivalConfig();
+        config.meteorSpawnInterval = 1.0e9f;
+        config.sweptProjectiles = swept;
+        config.projectileSize = {projectileSize, projectileSize};
+        for (auto& size : config.meteorSizes) {
+            size = {meteorSize, meteorSize};
+        }
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> distance(300.0f, 450.0f);
+        float heading = angle(random);
+        float gap = distance(random);
+        Vec2 center = {config.fieldWidth / 2.0f, config.fieldHeight / 2.0f};
+        Vec2 away = {center.x + std::cos(heading) * gap, center.y + std::sin(heading) * gap};
+
+        Simulation simulation(config);
+        Projectile projectile;
+        projectile.rotation = 0.0f;
+        if (sweepCase.projectileSpeed > 0.0f) {
+            simulation.spawnMeteor({center.x - meteorSize / 2.0f, center.y - meteorSize / 2.0f}, {0.0f, 0.0f}, 2);
+            projectile.position = away;
+            projectile.velocity = {-std::cos(heading) * sweepCase.projectileSpeed,
+                                   -std::sin(heading) * sweepCase.projectileSpeed};
+        } else {
+            simulation.spawnMeteor({center.x - meteorSize / 2.0f, center.y - meteorSize / 2.0f},
+                                   {std::cos(heading) * sweepCase.meteorSpeed, std::sin(heading) * sweepCase.meteorSpeed},
+                                   2);
+            projectile.position = away;
+            projectile.velocity = {0.0f, 0.0f};
+        }
+        simulation.spawnProjectile(projectile);
+
+        // The ship waits in a corner, out of the way.
+        TickInput input = {{0.0f, 0.0f}, false};
+        float dt = 1.0f / sweepCase.tickRate;
+        float speed = std::max(sweepCase.projectileSpeed, sweepCase.meteorSpeed);
+        int tickLimit = static_cast<int>((gap + meteorSize * 2.0f) / (speed * dt)) + 2;
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < tickLimit && simulation.getScore() == 0; ++tick) {
+            simulation.step(dt, input);
+            ++ticks;
+        }
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return simulation.getScore() > 0;
+    }
+
+    // Hit rates of discrete and swept projectile collisions for fast projectiles, fast
+    // meteors and low tick rates, where every trial should hit. Then the cost of a swept
+    // tick in the large scaling scene. Returns false if a swept trial missed.
+    bool runSweepBenchmark(const Options& options) {
+        const SweepCase cases[] = {
+            {"sweep_60hz_600", 60.0f, 600.0f, 0.0f},
+            {"sweep_60hz_6000", 60.0f, 6000.0f, 0.0f},
+            {"sweep_20hz_3000", 20.0f, 3000.0f, 0.0f},
+            {"sweep_10hz_6000", 10.0f, 6000.0f, 0.0f},
+            {"sweep_meteor_30hz", 30.0f, 0.0f, 4000.0f},
+        };
+        int trials = options.quick ? 200 : 2000;
+        bool complete = true;
+        bool headerPrinted = false;
+        for (const SweepCase& sweepCase : cases) {
+            if (!selected(options, sweepCase.name)) {
+                continue;
+            }
+            if (!options.json && !headerPrinted) {
+                std::printf("\n%-18s %8s %12s %14s %14s %14s %14s\n", "sweep", "tick Hz", "px/tick",
+                            "discrete hits", "swept hits", "discrete ns", "swept ns");
+                headerPrinted = true;
+            }
+            double hitRate[2];
+            double nanosecondsPerTick[2];
+            for (int swept = 0; swept < 2; ++swept) {
+                std::mt19937 random(5);
+                long long ticks = 0;
+                int hits = 0;
+                double seconds = 0.0;
+                for (int trial = 0; trial < trials; ++trial) {
+                    hits += runSweepTrial(sweepCase, swept != 0, random, ticks, seconds);
+                }
+                hitRate[swept] = 100.0 * hits / trials;
+                nanosecondsPerTick[swept] = seconds * 1.0e9 / std::max(1LL, ticks);
+            }
+            complete = complete && hitRate[1] == 100.0;
+            float step = std::max(sweepCase.projectileSpeed, sweepCase.meteorSpeed) / sweepCase.tickRate;
+            if (options.json) {
+                std::printf("{\"benchmark\":\"%s\",\"tick_rate\":%.0f,\"pixels_per_tick\":%.0f,"
+                            "\"discrete_hit_percent\":%.1f,\"swept_hit_percent\":%.1f,"
+                            "\"discrete_ns_per_tick\":%.0f,\"swept_ns_per_tick\":%.0f}\n",
+                            sweepCase.name, sweepCase.tickRate, step, hitRate[0], hitRate[1], nanosecondsPerTick[0],
+                            nanosecondsPerTick[1]);
+            } else {
+                std::printf("%-18s %8.0f %12.0f %13.1f%% %13.1f%% %14.0f %14.0f\n", sweepCase.name,
+                            sweepCase.tickRate, step, hitRate[0], hitRate[1], nanosecondsPerTick[0],
+                            nanosecondsPerTick[1]);
+            }
+        }
+        if (!complete) {
+            std::fprintf(stderr, "swept collision missed a projectile on a collision course\n");
+        }
+
+        const char* name = "sweep_cost";
+        if (selected(options, name)) {
+            int ticks = options.quick ? 30 : 300;
+            std::uint64_t stateHash = 0;
+            double discrete = runScaling(1, ticks, stateHash, false);
+            double swept = runScaling(1, ticks, stateHash, true);
+            if (options.json) {
+                std::printf("{\"benchmark\":\"%s\",\"discrete_ns_per_tick\":%.0f,\"swept_ns_per_tick\":%.0f}\n",
+                            name, discrete, swept);
+            } else {
+                std::printf("%-18s %8s %12s %14s %14s %14.0f %14.0f\n", name, "60", "-", "-", "-", discrete, swept);
+            }
+        }
+        return complete;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            options.json = true;
+        } else if (std::strcmp(argv[i], "--quick") == 0) {
+            options.quick = true;
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--json] [--quick] [--filter <text>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    runScenarios(options);
+    bool steady = runSteadyStateCheck(options);
+    bool matched = runBroadphaseBenchmark(options);
+    runNarrowphaseBenchmark(options);
+    runParticleBenchmark(options);
+    bool asleepFar = runWorldBenchmark(options);
+    bool swept = runSweepBenchmark(options);
+    bool deterministic = runScalingBenchmark(options);
+    return steady && matched && asleepFar && swept && deterministic ? 0 : 1;
+}
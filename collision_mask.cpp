@@ -0,0 +1,224 @@
+#include "collision_mask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "asset_pack.h"
+
+namespace {
+    CollisionMask maskOfSprite(const AssetPack& pack, const std::string& name) {
+        const AssetPackSprite* sprite = pack.findSprite(name);
+        if (sprite == nullptr || sprite->texture >= pack.getTextureCount()) {
+            throw std::runtime_error("Failed to load collision mask of " + name);
+        }
+        const AssetPackTexture& texture = pack.getTexture(sprite->texture);
+        size_t rowBytes = static_cast<size_t>(texture.width) * 4;
+        const std::uint8_t* pixels = pack.getPixels(texture) + sprite->top * rowBytes + sprite->left * 4;
+        return CollisionMask::fromRgba(pixels, sprite->width, sprite->height, rowBytes);
+    }
+}
+
+CollisionMask::CollisionMask()
+        : spriteWidth(0), spriteHeight(0), left(0), top(0), width(0), height(0), wordsPerRow(0), centerX(0.0f),
+          centerY(0.0f), radius(0.0f) {}
+
+CollisionMask CollisionMask::fromRgba(const std::uint8_t* pixels, int width, int height, size_t rowBytes,
+                                      std::uint8_t threshold) {
+    std::vector<char> solid(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        const std::uint8_t* row = pixels + y * rowBytes;
+        for (int x = 0; x < width; ++x) {
+            solid[static_cast<size_t>(y) * width + x] = row[x * 4 + 3] >= threshold;
+        }
+    }
+    return fromSolid(solid, width, height);
+}
+
+CollisionMask CollisionMask::fromSolid(const std::vector<char>& solid, int spriteWidth, int spriteHeight) {
+    CollisionMask mask;
+    mask.spriteWidth = spriteWidth;
+    mask.spriteHeight = spriteHeight;
+
+    int minX = spriteWidth, minY = spriteHeight, maxX = -1, maxY = -1;
+    for (int y = 0; y < spriteHeight; ++y) {
+        for (int x = 0; x < spriteWidth; ++x) {
+            if (solid[static_cast<size_t>(y) * spriteWidth + x]) {
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+            }
+        }
+    }
+    if (maxX < 0) {
+        return mask;
+    }
+
+    mask.left = minX;
+    mask.top = minY;
+    mask.width = maxX - minX + 1;
+    mask.height = maxY - minY + 1;
+    mask.wordsPerRow = (mask.width + 63) / 64;
+    mask.bits.assign(static_cast<size_t>(mask.wordsPerRow) * mask.height, 0);
+    mask.spanStart.assign(mask.height, 0);
+    mask.spanEnd.assign(mask.height, 0);
+    mask.centerX = minX + mask.width / 2.0f;
+    mask.centerY = minY + mask.height / 2.0f;
+    float farthest = 0.0f;
+    for (int y = 0; y < mask.height; ++y) {
+        std::uint64_t* row = &mask.bits[static_cast<size_t>(y) * mask.wordsPerRow];
+        int first = -1;
+        int last = -1;
+        for (int x = 0; x < mask.width; ++x) {
+            if (solid[static_cast<size_t>(y + minY) * spriteWidth + x + minX]) {
+                row[x / 64] |= std::uint64_t(1) << (x % 64);
+                first = first < 0 ? x : first;
+                last = x;
+            }
+        }
+        if (first >= 0) {
+            mask.spanStart[y] = static_cast<std::int16_t>(first);
+            mask.spanEnd[y] = static_cast<std::int16_t>(last + 1);
+            // The farthest pixel corner of a row lies at one end of its span.
+            float dy = std::max(std::fabs(y + minY - mask.centerY), std::fabs(y + minY + 1 - mask.centerY));
+            float dx = std::max(std::fabs(first + minX - mask.centerX), std::fabs(last + minX + 1 - mask.centerX));
+            farthest = std::max(farthest, dx * dx + dy * dy);
+        }
+    }
+    mask.radius = std::sqrt(farthest);
+
+    int blocks = (mask.height + spanBlockRows - 1) / spanBlockRows;
+    mask.blockStart.assign(blocks, static_cast<std::int16_t>(mask.width));
+    mask.blockEnd.assign(blocks, 0);
+    for (int y = 0; y < mask.height; ++y) {
+        if (mask.spanStart[y] < mask.spanEnd[y]) {
+            int block = y / spanBlockRows;
+            mask.blockStart[block] = std::min(mask.blockStart[block], mask.spanStart[y]);
+            mask.blockEnd[block] = std::max(mask.blockEnd[block], mask.spanEnd[y]);
+        }
+    }
+    return mask;
+}
+
+CollisionMask CollisionMask::rotated(float degrees) const {
+    float angle = degrees * 3.14159265f / 180.0f;
+    float cosine = std::cos(angle);
+    float sine = std::sin(angle);
+    // The small bias keeps e.g. a 90 degree turn, where cos is not exactly 0, from adding a column.
+    int rotatedWidth = static_cast<int>(std::ceil(std::fabs(spriteWidth * cosine) + std::fabs(spriteHeight * sine) - 0.001f));
+    int rotatedHeight = static_cast<int>(std::ceil(std::fabs(spriteWidth * sine) + std::fabs(spriteHeight * cosine) - 0.001f));
+
+    // Each pixel centre of the rotated sprite is turned back into the source sprite.
+    std::vector<char> solid(static_cast<size_t>(rotatedWidth) * rotatedHeight);
+    for (int y = 0; y < rotatedHeight; ++y) {
+        float dy = y + 0.5f - rotatedHeight / 2.0f;
+        for (int x = 0; x < rotatedWidth; ++x) {
+            float dx = x + 0.5f - rotatedWidth / 2.0f;
+            float sourceX = cosine * dx + sine * dy + spriteWidth / 2.0f;
+            float sourceY = -sine * dx + cosine * dy + spriteHeight / 2.0f;
+            solid[static_cast<size_t>(y) * rotatedWidth + x] =
+                    test(static_cast<int>(std::floor(sourceX)), static_cast<int>(std::floor(sourceY)));
+        }
+    }
+    return fromSolid(solid, rotatedWidth, rotatedHeight);
+}
+
+bool CollisionMask::test(int x, int y) const {
+    x -= left;
+    y -= top;
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return false;
+    }
+    return (bits[static_cast<size_t>(y) * wordsPerRow + x / 64] >> (x % 64) & 1) != 0;
+}
+
+std::uint64_t CollisionMask::rowBits(int row, int column) const {
+    const std::uint64_t* words = &bits[static_cast<size_t>(row) * wordsPerRow];
+    int word = column >= 0 ? column / 64 : -((63 - column) / 64);
+    int shift = column - word * 64;
+    std::uint64_t low = word >= 0 && word < wordsPerRow ? words[word] : 0;
+    std::uint64_t high = word + 1 >= 0 && word + 1 < wordsPerRow ? words[word + 1] : 0;
+    return shift == 0 ? low : low >> shift | high << (64 - shift);
+}
+
+bool CollisionMask::overlaps(const CollisionMask& other, int offsetX, int offsetY) const {
+    float centerDistanceX = offsetX + other.centerX - centerX;
+    float centerDistanceY = offsetY + other.centerY - centerY;
+    float reach = radius + other.radius;
+    if (centerDistanceX * centerDistanceX + centerDistanceY * centerDistanceY >= reach * reach) {
+        return false;
+    }
+
+    // Position of the other cropped mask relative to this one.
+    int dx = offsetX + other.left - left;
+    int dy = offsetY + other.top - top;
+    int firstRow = std::max(0, dy);
+    int lastRow = std::min(height, dy + other.height);
+    int firstColumn = std::max(0, dx);
+    int lastColumn = std::min(width, dx + other.width);
+    if (firstRow >= lastRow || firstColumn >= lastColumn) {
+        return false;
+    }
+
+    // A block of rows is skipped when its solid span misses that of the other mask's rows
+    // beside it, which lie in at most two of the other mask's blocks. In the remaining rows
+    // only those whose solid spans overlap are compared. Bits of the other mask outside its
+    // row come out as 0, so whole words of this mask can be tested.
+    for (int block = firstRow / spanBlockRows; block * spanBlockRows < lastRow; ++block) {
+        int blockFirstRow = std::max(firstRow, block * spanBlockRows);
+        int blockLastRow = std::min(lastRow, (block + 1) * spanBlockRows);
+        int otherFirstBlock = (blockFirstRow - dy) / spanBlockRows;
+        int otherLastBlock = (blockLastRow - 1 - dy) / spanBlockRows;
+        int otherStart = std::min(other.blockStart[otherFirstBlock], other.blockStart[otherLastBlock]) + dx;
+        int otherEnd = std::max(other.blockEnd[otherFirstBlock], other.blockEnd[otherLastBlock]) + dx;
+        if (std::max<int>(blockStart[block], otherStart) >= std::min<int>(blockEnd[block], otherEnd)) {
+            continue;
+        }
+        for (int y = blockFirstRow; y < blockLastRow; ++y) {
+            int otherRow = y - dy;
+            int start = std::max<int>(spanStart[y], other.spanStart[otherRow] + dx);
+            int end = std::min<int>(spanEnd[y], other.spanEnd[otherRow] + dx);
+            if (start >= end) {
+                continue;
+            }
+            const std::uint64_t* row = &bits[static_cast<size_t>(y) * wordsPerRow];
+            for (int word = start / 64; word <= (end - 1) / 64; ++word) {
+                if (row[word] & other.rowBits(otherRow, word * 64 - dx)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+std::uint64_t CollisionMask::hash() const {
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash = (hash ^ (value >> (i * 8) & 0xFF)) * 1099511628211ull;
+        }
+    };
+    mix(static_cast<std::uint64_t>(spriteWidth));
+    mix(static_cast<std::uint64_t>(spriteHeight));
+    mix(static_cast<std::uint64_t>(left));
+    mix(static_cast<std::uint64_t>(top));
+    mix(static_cast<std::uint64_t>(width));
+    mix(static_cast<std::uint64_t>(height));
+    for (std::uint64_t word : bits) {
+        mix(word);
+    }
+    return hash;
+}
+
+SpriteMasks loadSpriteMasks(const AssetPack& pack) {
+    SpriteMasks masks;
+    masks.ship = maskOfSprite(pack, "spacecraft");
+    masks.projectile = maskOfSprite(pack, "ball");
+    masks.meteors[0] = maskOfSprite(pack, "meteor1");
+    masks.meteors[1] = maskOfSprite(pack, "meteor2");
+    masks.meteors[2] = maskOfSprite(pack, "meteor3");
+    return masks;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class AssetPack;
+
+// One bit per pixel of a sprite at its on-screen size, set where the sprite is opaque.
+// Rows are stored as 64-bit words (bit n of word k is column 64k + n) and cropped to the
+// opaque pixels. The narrow phase rejects most pairs on the bounding circles and cropped
+// boxes of the solid pixels and on the solid spans of blocks of rows and of single rows,
+// and tests the rest by ANDing whole words of both masks.
+class CollisionMask {
+private:
+    int spriteWidth;
+    int spriteHeight;
+    // Position and size of the cropped mask inside the sprite.
+    int left;
+    int top;
+    int width;
+    int height;
+    int wordsPerRow;
+    // Circle around the solid pixels, centred on the cropped box, in sprite coordinates.
+    float centerX;
+    float centerY;
+    float radius;
+    std::vector<std::uint64_t> bits;
+    // First and one past the last solid column of each cropped row; equal if it has none.
+    std::vector<std::int16_t> spanStart;
+    std::vector<std::int16_t> spanEnd;
+    // The same over blocks of spanBlockRows rows.
+    std::vector<std::int16_t> blockStart;
+    std::vector<std::int16_t> blockEnd;
+
+    static const int spanBlockRows = 8;
+
+    static CollisionMask fromSolid(const std::vector<char>& solid, int spriteWidth, int spriteHeight);
+    // 64 bits of a cropped row starting at column, which may lie outside the mask.
+    std::uint64_t rowBits(int row, int column) const;
+
+public:
+    CollisionMask();
+
+    // Pixels whose alpha (the fourth byte of each RGBA pixel) is at least threshold are solid.
+    static CollisionMask fromRgba(const std::uint8_t* pixels, int width, int height, size_t rowBytes,
+                                  std::uint8_t threshold = 128);
+
+    // The sprite rotated clockwise by degrees about its centre, like an sf::Sprite with its
+    // origin in the middle, in a sprite the size of the rotated bounding box.
+    CollisionMask rotated(float degrees) const;
+
+    // Whether the pixel of the sprite is solid; false outside the sprite.
+    bool test(int x, int y) const;
+    // Whether this sprite, with its top-left corner at the origin, shares a solid pixel with
+    // other, with its top-left corner at (offsetX, offsetY).
+    bool overlaps(const CollisionMask& other, int offsetX, int offsetY) const;
+
+    std::uint64_t hash() const;
+
+    int getSpriteWidth() const {
+        return spriteWidth;
+    }
+
+    int getSpriteHeight() const {
+        return spriteHeight;
+    }
+
+    bool empty() const {
+        return bits.empty();
+    }
+};
+
+// Masks of the gameplay sprites. The ship is given unrotated; Simulation::setSpriteMasks
+// derives its rotations.
+struct SpriteMasks {
+    CollisionMask ship;
+    CollisionMask projectile;
+    CollisionMask meteors[3];
+};
+
+// Builds the masks from the cooked gameplay atlas. Throws if a sprite is missing.
+SpriteMasks loadSpriteMasks(const AssetPack& pack);
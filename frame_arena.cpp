@@ -0,0 +1,30 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(size_t capacity)
+        : block(new unsigned char[capacity]), capacity(capacity), used(0), overflowBytes(0), peak(0) {}
+
+void* FrameArena::allocateBytes(size_t size, size_t alignment) {
+    // The blocks come from operator new[], which aligns them for any fundamental type.
+    size_t offset = (used + alignment - 1) / alignment * alignment;
+    if (offset + size <= capacity) {
+        used = offset + size;
+        return block.get() + offset;
+    }
+    size_t bytes = std::max<size_t>(size, 1);
+    overflow.emplace_back(new unsigned char[bytes]);
+    overflowBytes += bytes;
+    return overflow.back().get();
+}
+
+void FrameArena::reset() {
+    peak = std::max(peak, used + overflowBytes);
+    if (!overflow.empty()) {
+        capacity = std::max(capacity * 2, used + overflowBytes);
+        overflow.clear();
+        block.reset(new unsigned char[capacity]);
+    }
+    used = 0;
+    overflowBytes = 0;
+}
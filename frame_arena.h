@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for scratch data that lives for one tick. allocate() hands out the next
+// bytes of one block and reset() takes them all back at once; nothing is freed one by one,
+// so only trivially destructible types go in, and the memory comes back uninitialised.
+//
+// A tick that needs more than the block holds gets the rest from extra blocks, and the next
+// reset() replaces them all with one block big enough for that tick. After the first few
+// ticks of a game the arena therefore stops touching the heap.
+class FrameArena {
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity;
+    size_t used;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+    size_t overflowBytes;
+    size_t peak;
+
+    void* allocateBytes(size_t size, size_t alignment);
+
+public:
+    explicit FrameArena(size_t capacity = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    // Everything allocated since the last reset becomes invalid.
+    void reset();
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    // Bytes handed out since the last reset, including those from extra blocks.
+    size_t getUsed() const {
+        return used + overflowBytes;
+    }
+
+    // The most bytes any one tick needed.
+    size_t getPeak() const {
+        return peak;
+    }
+};
@@ -0,0 +1,363 @@
+#include "game_client.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+    const float radiansToDegrees = 180.0f / 3.14159265f;
+    const auto helloInterval = std::chrono::milliseconds(250);
+    const auto connectTimeout = std::chrono::seconds(5);
+    const auto silenceTimeout = std::chrono::seconds(5);
+    // Beyond this many ticks off, the drawn tick jumps instead of drifting back.
+    const double renderTickSnap = 8.0;
+    const double renderTickDrift = 0.05;
+    // The server steps every ship by one tick per input.
+    const float tickSeconds = 1.0f / netTickRate;
+
+    float percentile(std::vector<float> values, float fraction) {
+        if (values.empty()) {
+            return 0.0f;
+        }
+        size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    // Adds the count-th sample to a ring of at most capacity samples.
+    void keepSample(std::vector<float>& samples, std::uint64_t count, size_t capacity, float value) {
+        if (samples.size() < capacity) {
+            samples.push_back(value);
+        } else {
+            samples[count % capacity] = value;
+        }
+    }
+
+    float angleBetween(float from, float to) {
+        float difference = to - from;
+        return difference - std::floor((difference + 180.0f) / 360.0f) * 360.0f;
+    }
+
+    Vec2 shipPosition(const NetShip& ship) {
+        return {dequantisePosition(ship.x), dequantisePosition(ship.y)};
+    }
+
+    Vec2 entityPosition(const NetEntity& entity, double ticks) {
+        float seconds = static_cast<float>(ticks / netTickRate);
+        return {dequantisePosition(entity.x) + dequantiseVelocity(entity.velocityX) * seconds,
+                dequantisePosition(entity.y) + dequantiseVelocity(entity.velocityY) * seconds};
+    }
+}
+
+GameClient::GameClient(const sf::IpAddress& address, unsigned short port, const NetConditions& conditions,
+                       std::uint64_t seed)
+        : channel(conditions, seed),
+          serverAddress(address),
+          serverPort(port),
+          state(State::Connecting),
+          welcome{0, 0, 0.0f, 0.0f, 0.0f},
+          connectStarted(std::chrono::steady_clock::now()),
+          latestTick(netNoTick),
+          renderTick(0.0),
+          previousRenderTick(0.0),
+          inputSequence(0),
+          lastAckedInput(0),
+          firstPredictedInput(0),
+          predicted(),
+          previousPredicted(),
+          hasPrediction(false),
+          snapshotsReceived(0),
+          snapshotsLost(0),
+          snapshotsLate(0),
+          snapshotsUndecodable(0),
+          underruns(0),
+          roundTripCount(0),
+          errorCount(0),
+          lastRoundTrip(0.0f),
+          maxPositionError(0.0f),
+          maxRotationError(0.0f) {
+    roundTrips.reserve(sampleHistory);
+    positionErrors.reserve(sampleHistory);
+    rotationErrors.reserve(sampleHistory);
+    if (!channel.bind(sf::Socket::AnyPort)) {
+        throw std::runtime_error("Failed to bind a UDP port");
+    }
+    writeHello(packet);
+    channel.send(packet, serverAddress, serverPort);
+    lastHello = connectStarted;
+}
+
+void GameClient::poll() {
+    sf::IpAddress address;
+    unsigned short port;
+    while (channel.receive(received, address, port)) {
+        if (address != serverAddress || port != serverPort) {
+            continue;
+        }
+        PacketReader reader(received.data(), received.size());
+        NetPacketType type;
+        if (!readPacketType(reader, type)) {
+            continue;
+        }
+        lastHeard = std::chrono::steady_clock::now();
+        if (type == NetPacketType::Welcome && state == State::Connecting) {
+            if (readWelcome(reader, welcome)) {
+                config.fieldWidth = welcome.fieldWidth;
+                config.fieldHeight = welcome.fieldHeight;
+                config.rotationSmoothing = welcome.rotationSmoothing;
+                config.shipCount = welcome.playerCount;
+                state = State::Playing;
+            }
+        } else if (type == NetPacketType::Full && state == State::Connecting) {
+            state = State::Rejected;
+        } else if (type == NetPacketType::Snapshot && state == State::Playing) {
+            handleSnapshot(reader);
+        } else if (type == NetPacketType::Bye) {
+            state = State::Disconnected;
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (state == State::Connecting) {
+        if (now - connectStarted > connectTimeout) {
+            state = State::Disconnected;
+        } else if (now - lastHello > helloInterval) {
+            writeHello(packet);
+            channel.send(packet, serverAddress, serverPort);
+            lastHello = now;
+        }
+    } else if (state == State::Playing && hasSnapshot() && now - lastHeard > silenceTimeout) {
+        state = State::Disconnected;
+    }
+    channel.flush();
+}
+
+void GameClient::handleSnapshot(PacketReader& reader) {
+    NetSnapshotHeader header;
+    if (!readSnapshotHeader(reader, header) || header.tick == netNoTick ||
+        header.playerIndex != welcome.playerIndex) {
+        ++snapshotsUndecodable;
+        return;
+    }
+    if (hasSnapshot() && header.tick <= latestTick) {
+        ++snapshotsLate;
+        return;
+    }
+    const NetSnapshot* baseline = nullptr;
+    if (header.baselineTick != netNoTick) {
+        const NetSnapshot& candidate = snapshots[header.baselineTick % historySize];
+        if (candidate.tick != header.baselineTick || header.tick - header.baselineTick >= historySize) {
+            ++snapshotsUndecodable;
+            return;
+        }
+        baseline = &candidate;
+    }
+    NetSnapshot& snapshot = snapshots[header.tick % historySize];
+    if (!readSnapshotBody(reader, header, baseline, snapshot) ||
+        snapshot.ships.size() != static_cast<size_t>(config.shipCount)) {
+        snapshot.tick = netNoTick;
+        ++snapshotsUndecodable;
+        return;
+    }
+
+    ++snapshotsReceived;
+    if (!hasSnapshot()) {
+        renderTick = previousRenderTick = static_cast<double>(header.tick) - interpolationDelay;
+    } else {
+        snapshotsLost += header.tick - latestTick - 1;
+    }
+    latestTick = header.tick;
+    reconcile(snapshot, header.lastInput);
+}
+
+// Restarts the prediction from the server's ship and re-applies the inputs it has not seen.
+// Steering only depends on the pointer, so the prediction matches the server exactly unless
+// the server had to skip or repeat inputs.
+void GameClient::reconcile(const NetSnapshot& snapshot, std::uint32_t lastInput) {
+    const NetShip& ship = snapshot.ships[welcome.playerIndex];
+    if (lastInput == 0 || lastInput > inputSequence || ship.lives == 0) {
+        hasPrediction = false;
+        return;
+    }
+    Vec2 position = shipPosition(ship);
+    float rotation = dequantiseRotation(ship.rotation);
+    bool remembered = inputSequence - lastInput < historySize;
+    if (lastInput > lastAckedInput) {
+        if (remembered) {
+            std::chrono::duration<float, std::milli> roundTrip =
+                    std::chrono::steady_clock::now() - inputSentAt[lastInput % historySize];
+            lastRoundTrip = roundTrip.count();
+            keepSample(roundTrips, roundTripCount++, sampleHistory, lastRoundTrip);
+        }
+        if (remembered && hasPrediction && lastInput >= firstPredictedInput) {
+            const Vec2& guess = predictedPositions[lastInput % historySize];
+            float positionError = std::hypot(guess.x - position.x, guess.y - position.y);
+            float rotationError = std::fabs(angleBetween(predictedRotations[lastInput % historySize], rotation));
+            keepSample(positionErrors, errorCount, sampleHistory, positionError);
+            keepSample(rotationErrors, errorCount, sampleHistory, rotationError);
+            ++errorCount;
+            maxPositionError = std::max(maxPositionError, positionError);
+            maxRotationError = std::max(maxRotationError, rotationError);
+        }
+        lastAckedInput = lastInput;
+    }
+
+    ShipState rebuilt = {position, rotation, ship.lives, 0.0f, 0.0f, position, true};
+    if (remembered) {
+        for (std::uint32_t sequence = lastInput + 1; sequence <= inputSequence; ++sequence) {
+            Simulation::steerShip(rebuilt, inputs[sequence % historySize], config, tickSeconds);
+        }
+    }
+    if (!hasPrediction) {
+        previousPredicted = rebuilt;
+        firstPredictedInput = inputSequence + 1;
+    }
+    predicted = rebuilt;
+    hasPrediction = true;
+}
+
+void GameClient::tick(const TickInput& input) {
+    if (state != State::Playing) {
+        return;
+    }
+    // Pointers go over the wire in whole pixels; the prediction uses the same values.
+    TickInput sent = {{std::round(input.pointer.x), std::round(input.pointer.y)}, input.fire};
+    ++inputSequence;
+    inputs[inputSequence % historySize] = sent;
+    previousPredicted = predicted;
+    if (hasPrediction) {
+        Simulation::steerShip(predicted, sent, config, tickSeconds);
+    }
+    predictedPositions[inputSequence % historySize] = predicted.position;
+    predictedRotations[inputSequence % historySize] = predicted.rotation;
+    sendInputs();
+
+    if (hasSnapshot()) {
+        previousRenderTick = renderTick;
+        renderTick += 1.0;
+        double target = static_cast<double>(latestTick) - interpolationDelay;
+        if (std::fabs(target - renderTick) > renderTickSnap) {
+            renderTick = previousRenderTick = target;
+        } else {
+            renderTick += (target - renderTick) * renderTickDrift;
+        }
+        if (renderTick > latestTick) {
+            ++underruns;
+        }
+    }
+    channel.flush();
+}
+
+void GameClient::sendInputs() {
+    TickInput recent[netInputRedundancy];
+    std::uint32_t count = std::min<std::uint32_t>(inputSequence, netInputRedundancy);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        recent[i] = inputs[(inputSequence - count + 1 + i) % historySize];
+    }
+    NetInputHeader header = {latestTick, inputSequence, static_cast<std::uint8_t>(count)};
+    writeInput(packet, header, recent);
+    channel.send(packet, serverAddress, serverPort);
+    inputSentAt[inputSequence % historySize] = std::chrono::steady_clock::now();
+}
+
+const NetSnapshot* GameClient::findSnapshot(std::uint32_t tick) const {
+    for (std::uint32_t back = 0; back < historySize && back <= tick; ++back) {
+        const NetSnapshot& snapshot = snapshots[(tick - back) % historySize];
+        if (snapshot.tick == tick - back) {
+            return &snapshot;
+        }
+    }
+    return nullptr;
+}
+
+const NetSnapshot* GameClient::findSnapshotAfter(std::uint32_t tick) const {
+    for (std::uint32_t next = tick + 1; next <= latestTick && next - tick < historySize; ++next) {
+        const NetSnapshot& snapshot = snapshots[next % historySize];
+        if (snapshot.tick == next) {
+            return &snapshot;
+        }
+    }
+    return nullptr;
+}
+
+void GameClient::buildView(float alpha, NetView& view) const {
+    view.ships.clear();
+    view.meteors.clear();
+    view.projectiles.clear();
+    view.playerIndex = welcome.playerIndex;
+    if (!hasSnapshot()) {
+        return;
+    }
+    const NetSnapshot& latest = snapshots[latestTick % historySize];
+    view.score = latest.score;
+    view.gameOver = latest.gameOver;
+
+    double time = previousRenderTick + (renderTick - previousRenderTick) * alpha;
+    std::uint32_t before = time <= 0.0 ? 0 : std::min(latestTick, static_cast<std::uint32_t>(time));
+    const NetSnapshot* from = findSnapshot(before);
+    if (from == nullptr) {
+        from = &latest;
+    }
+    const NetSnapshot* to = findSnapshotAfter(from->tick);
+    double since = time - from->tick;
+
+    // Meteors and projectiles fly straight, so one snapshot and the velocity place them.
+    for (const NetEntity& meteor : from->meteors) {
+        view.meteors.push_back({entityPosition(meteor, since), meteor.stage});
+    }
+    for (const NetEntity& projectile : from->projectiles) {
+        float rotation = std::atan2(static_cast<float>(projectile.velocityX), static_cast<float>(-projectile.velocityY));
+        view.projectiles.push_back({entityPosition(projectile, since), rotation * radiansToDegrees});
+    }
+
+    float blend = to != nullptr ? static_cast<float>(std::max(0.0, std::min(1.0, since / (to->tick - from->tick)))) : 0.0f;
+    for (size_t i = 0; i < from->ships.size(); ++i) {
+        NetView::Ship ship;
+        // The own ship shows its lives and hits without the interpolation delay.
+        const NetShip& current = i == welcome.playerIndex ? latest.ships[i] : from->ships[i];
+        ship.lives = current.lives;
+        ship.hit = current.hit != 0;
+        if (i == welcome.playerIndex && hasPrediction) {
+            ship.position = {previousPredicted.position.x + (predicted.position.x - previousPredicted.position.x) * alpha,
+                             previousPredicted.position.y + (predicted.position.y - previousPredicted.position.y) * alpha};
+            ship.rotation = previousPredicted.rotation + angleBetween(previousPredicted.rotation, predicted.rotation) * alpha;
+        } else {
+            const NetShip& start = from->ships[i];
+            const NetShip& end = to != nullptr ? to->ships[i] : start;
+            Vec2 a = shipPosition(start);
+            Vec2 b = shipPosition(end);
+            float rotation = dequantiseRotation(start.rotation);
+            ship.position = {a.x + (b.x - a.x) * blend, a.y + (b.y - a.y) * blend};
+            ship.rotation = rotation + angleBetween(rotation, dequantiseRotation(end.rotation)) * blend;
+        }
+        view.ships.push_back(ship);
+    }
+}
+
+void GameClient::disconnect() {
+    if (state == State::Playing || state == State::Connecting) {
+        writeBye(packet);
+        channel.send(packet, serverAddress, serverPort);
+        // Sent at once, whatever delay is simulated, since the client is about to go.
+        channel.flush();
+    }
+    state = State::Disconnected;
+}
+
+void GameClient::printReport(const char* name, double seconds) const {
+    const NetTraffic& traffic = channel.getTraffic();
+    double down = (traffic.bytesReceived + traffic.packetsReceived * udpHeaderBytes) * 8.0 / 1000.0 / seconds;
+    double up = (traffic.bytesSent + traffic.packetsSent * udpHeaderBytes) * 8.0 / 1000.0 / seconds;
+    std::printf("%s (player %d): %llu snapshots, %llu lost, %llu late, %llu undecodable, %llu underruns\n", name,
+                welcome.playerIndex + 1, static_cast<unsigned long long>(snapshotsReceived),
+                static_cast<unsigned long long>(snapshotsLost), static_cast<unsigned long long>(snapshotsLate),
+                static_cast<unsigned long long>(snapshotsUndecodable), static_cast<unsigned long long>(underruns));
+    std::printf("  down %.1f kbit/s, up %.1f kbit/s including IP/UDP headers\n", down, up);
+    // Percentiles are over the last sampleHistory inputs, the maxima over the whole session.
+    std::printf("  input round trip p50 %.1f ms, p99 %.1f ms\n", percentile(roundTrips, 0.5f),
+                percentile(roundTrips, 0.99f));
+    std::printf("  prediction error p99 %.2f px, %.2f degrees; max %.2f px, %.2f degrees\n",
+                percentile(positionErrors, 0.99f), percentile(rotationErrors, 0.99f), maxPositionError,
+                maxRotationError);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "net_channel.h"
+#include "net_protocol.h"
+#include "simulation.h"
+
+// What a network client draws in one frame, in field coordinates.
+struct NetView {
+    struct Ship {
+        Vec2 position;
+        float rotation;
+        int lives;
+        bool hit;
+    };
+
+    struct Meteor {
+        Vec2 position;
+        int stage;
+    };
+
+    struct Projectile {
+        Vec2 position;
+        float rotation;
+    };
+
+    std::vector<Ship> ships;
+    std::vector<Meteor> meteors;
+    std::vector<Projectile> projectiles;
+    int playerIndex = 0;
+    int score = 0;
+    bool gameOver = false;
+};
+
+// Client of a GameServer. The client's own ship is predicted: every input is applied locally
+// at once and re-applied on top of each snapshot for the inputs the server has not used yet.
+// Everything else is drawn interpolationDelay ticks behind the newest snapshot, so there is
+// usually a snapshot on either side of the time drawn even when one is lost or late.
+class GameClient {
+public:
+    enum class State {
+        Connecting,    // sending Hello until a Welcome arrives
+        Playing,       // welcomed; snapshots start once every player has joined
+        Rejected,      // the server is full
+        Disconnected   // the server left or went silent
+    };
+
+    // Snapshots kept as baselines and for interpolation, and inputs kept for prediction.
+    static const std::uint32_t historySize = 64;
+    static const int interpolationDelay = 4;
+    // Round trips and prediction errors kept for the report; older ones are overwritten.
+    static const size_t sampleHistory = 4096;
+
+private:
+    NetChannel channel;
+    sf::IpAddress serverAddress;
+    unsigned short serverPort;
+    State state;
+    NetWelcome welcome;
+    SimConfig config;
+    std::chrono::steady_clock::time_point lastHello;
+    std::chrono::steady_clock::time_point lastHeard;
+    std::chrono::steady_clock::time_point connectStarted;
+
+    // Received snapshots by tick modulo historySize.
+    NetSnapshot snapshots[historySize];
+    std::uint32_t latestTick;
+    // The server tick drawn, which trails latestTick by about interpolationDelay.
+    double renderTick;
+    double previousRenderTick;
+
+    std::uint32_t inputSequence;
+    TickInput inputs[historySize];
+    // Predicted ship after each input, to measure how far off the prediction was.
+    Vec2 predictedPositions[historySize];
+    float predictedRotations[historySize];
+    std::chrono::steady_clock::time_point inputSentAt[historySize];
+    std::uint32_t lastAckedInput;
+    // The first input predicted since the prediction last (re)started.
+    std::uint32_t firstPredictedInput;
+    ShipState predicted;
+    ShipState previousPredicted;
+    bool hasPrediction;
+
+    std::vector<std::uint8_t> packet;
+    std::vector<std::uint8_t> received;
+
+    std::uint64_t snapshotsReceived;
+    std::uint64_t snapshotsLost;
+    std::uint64_t snapshotsLate;
+    std::uint64_t snapshotsUndecodable;
+    std::uint64_t underruns;
+    // The last sampleHistory of each, in no particular order once full.
+    std::vector<float> roundTrips;
+    // Distance between the predicted ship and the server's after the same input.
+    std::vector<float> positionErrors;
+    std::vector<float> rotationErrors;
+    std::uint64_t roundTripCount;
+    std::uint64_t errorCount;
+    float lastRoundTrip;
+    // Largest prediction errors of the whole session.
+    float maxPositionError;
+    float maxRotationError;
+
+    void handleSnapshot(PacketReader& reader);
+    void reconcile(const NetSnapshot& snapshot, std::uint32_t lastInput);
+    void sendInputs();
+    // The newest snapshot at or before tick, or nullptr.
+    const NetSnapshot* findSnapshot(std::uint32_t tick) const;
+    const NetSnapshot* findSnapshotAfter(std::uint32_t tick) const;
+
+public:
+    GameClient(const sf::IpAddress& address, unsigned short port, const NetConditions& conditions = NetConditions(),
+               std::uint64_t seed = 1);
+
+    // Handles every waiting packet; call once per frame, before tick.
+    void poll();
+    // Sends this tick's input and predicts the own ship with it; call once per fixed tick.
+    void tick(const TickInput& input);
+    // Fills view for drawing alpha of a tick past the last call to tick.
+    void buildView(float alpha, NetView& view) const;
+    // Tells the server the client is leaving.
+    void disconnect();
+    void printReport(const char* name, double seconds) const;
+
+    State getState() const {
+        return state;
+    }
+
+    bool hasSnapshot() const {
+        return latestTick != netNoTick;
+    }
+
+    int getPlayerIndex() const {
+        return welcome.playerIndex;
+    }
+
+    const SimConfig& getConfig() const {
+        return config;
+    }
+
+    // Round-trip time of the newest acknowledged input, in milliseconds; 0 before the first.
+    float getRoundTripMilliseconds() const {
+        return lastRoundTrip;
+    }
+};
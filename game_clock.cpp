@@ -0,0 +1,45 @@
+#include "game_clock.h"
+
+#include <algorithm>
+
+#include <SFML/System/Sleep.hpp>
+
+const sf::Time GameClock::maximumBacklog = sf::milliseconds(250);
+
+GameClock::GameClock(float ticksPerSecond)
+        : tickLength(sf::seconds(1.0f / ticksPerSecond)), frameLength(sf::Time::Zero), accumulator(sf::Time::Zero),
+          frameStart(sf::Time::Zero), lastFrame(sf::Time::Zero) {}
+
+void GameClock::setFrameRateLimit(float framesPerSecond) {
+    frameLength = framesPerSecond > 0.0f ? sf::seconds(1.0f / framesPerSecond) : sf::Time::Zero;
+}
+
+void GameClock::beginFrame() {
+    sf::Time now = clock.getElapsedTime();
+    lastFrame = now - frameStart;
+    frameStart = now;
+    accumulator += lastFrame;
+    // At tick rates below 4 Hz one tick is longer than the backlog; it must still fit.
+    sf::Time backlog = std::max(maximumBacklog, tickLength);
+    if (accumulator > backlog) {
+        accumulator = backlog;
+    }
+}
+
+bool GameClock::tick() {
+    if (accumulator < tickLength) {
+        return false;
+    }
+    accumulator -= tickLength;
+    return true;
+}
+
+void GameClock::endFrame() {
+    if (frameLength == sf::Time::Zero) {
+        return;
+    }
+    sf::Time remaining = frameStart + frameLength - clock.getElapsedTime();
+    if (remaining > sf::Time::Zero) {
+        sf::sleep(remaining);
+    }
+}
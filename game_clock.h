@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+
+// Real-time clock for the game loop. The simulation advances in fixed ticks: beginFrame()
+// adds the real time since the last frame to an accumulator, and tick() hands out one
+// fixed step at a time while a whole tick is left, so gameplay does not depend on the
+// display rate. The remainder gives the interpolation factor for drawing between the last
+// two ticks. endFrame() sleeps off what is left of the frame budget when a frame rate
+// limit is set, so the loop no longer spins at 100% CPU.
+class GameClock {
+private:
+    sf::Clock clock;
+    sf::Time tickLength;
+    sf::Time frameLength;
+    sf::Time accumulator;
+    sf::Time frameStart;
+    sf::Time lastFrame;
+
+public:
+    // Real time that is dropped instead of simulated, e.g. after a stall or while the
+    // window was being dragged, so the game never has to catch up more than this, or more
+    // than one tick where a tick is longer.
+    static const sf::Time maximumBacklog;
+
+    explicit GameClock(float ticksPerSecond = 60.0f);
+
+    // 0 turns the limit off, e.g. when vertical sync paces the loop instead.
+    void setFrameRateLimit(float framesPerSecond);
+
+    void beginFrame();
+    bool tick();
+    void endFrame();
+
+    float getTickSeconds() const {
+        return tickLength.asSeconds();
+    }
+
+    // How far real time has run past the last tick, in ticks, in [0, 1).
+    float getAlpha() const {
+        return accumulator.asSeconds() / tickLength.asSeconds();
+    }
+
+    // Real length of the previous frame, for statistics.
+    sf::Time getFrameTime() const {
+        return lastFrame;
+    }
+};
@@ -0,0 +1,236 @@
+#include "game_server.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    SimConfig withShips(SimConfig config, int playerCount) {
+        config.shipCount = playerCount;
+        return config;
+    }
+}
+
+GameServer::GameServer(const SimConfig& config, const Options& options, const SpriteMasks* masks)
+        : options(options),
+          channel(options.conditions, options.seed ^ 0x5345525645ull),
+          simulation(withShips(config, options.playerCount)),
+          players(options.playerCount),
+          tickInputs(options.playerCount, TickInput{{config.fieldWidth / 2.0f, config.fieldHeight / 2.0f}, false}),
+          tickCount(0),
+          started(false) {
+    if (options.playerCount < 1 || options.playerCount > Simulation::maxShips) {
+        throw std::runtime_error("Failed to start server: player count must be 1 to 8");
+    }
+    if (!channel.bind(options.port)) {
+        throw std::runtime_error("Failed to bind UDP port " + std::to_string(options.port));
+    }
+    if (masks != nullptr) {
+        simulation.setSpriteMasks(*masks);
+    }
+    simulation.reset(options.seed);
+    for (auto& player : players) {
+        player.lastInput = tickInputs[0];
+    }
+}
+
+int GameServer::findPlayer(const sf::IpAddress& address, unsigned short port) const {
+    for (size_t i = 0; i < players.size(); ++i) {
+        if (players[i].connected && players[i].address == address && players[i].port == port) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void GameServer::poll() {
+    std::vector<std::uint8_t> received;
+    sf::IpAddress address;
+    unsigned short port;
+    while (channel.receive(received, address, port)) {
+        PacketReader reader(received.data(), received.size());
+        NetPacketType type;
+        if (!readPacketType(reader, type)) {
+            continue;
+        }
+        if (type == NetPacketType::Hello) {
+            if (readHello(reader)) {
+                handleHello(address, port);
+            }
+            continue;
+        }
+        int index = findPlayer(address, port);
+        if (index < 0) {
+            continue;
+        }
+        Player& player = players[index];
+        player.lastHeard = std::chrono::steady_clock::now();
+        if (type == NetPacketType::Input) {
+            handleInput(player, reader, received.size());
+        } else if (type == NetPacketType::Bye) {
+            player.connected = false;
+            std::cout << "Player " << index + 1 << " left" << std::endl;
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < players.size(); ++i) {
+        if (players[i].connected && now - players[i].lastHeard > std::chrono::seconds(timeoutSeconds)) {
+            players[i].connected = false;
+            std::cout << "Player " << i + 1 << " timed out" << std::endl;
+        }
+    }
+    channel.flush();
+}
+
+void GameServer::handleHello(const sf::IpAddress& address, unsigned short port) {
+    int index = findPlayer(address, port);
+    if (index >= 0) {
+        // The welcome was lost; the client is still asking.
+        sendWelcome(index);
+        return;
+    }
+    for (size_t i = 0; i < players.size(); ++i) {
+        Player& player = players[i];
+        if (player.connected) {
+            continue;
+        }
+        player.connected = true;
+        player.address = address;
+        player.port = port;
+        player.lastHeard = std::chrono::steady_clock::now();
+        // A rejoining client numbers its inputs from 1 again and has no snapshots yet.
+        for (auto& sequence : player.inputSequences) {
+            sequence = 0;
+        }
+        player.newestSequence = 0;
+        player.lastApplied = 0;
+        player.ackedTick = netNoTick;
+        std::cout << "Player " << i + 1 << " joined from " << address.toString() << ":" << port << std::endl;
+        sendWelcome(static_cast<int>(i));
+
+        bool everyone = true;
+        for (const auto& other : players) {
+            everyone = everyone && other.connected;
+        }
+        if (everyone && !started) {
+            started = true;
+            std::cout << "All " << players.size() << " players joined, starting" << std::endl;
+        }
+        return;
+    }
+    writeFull(packet);
+    channel.send(packet, address, port);
+}
+
+void GameServer::sendWelcome(int index) {
+    const SimConfig& config = simulation.getConfig();
+    NetWelcome welcome = {static_cast<std::uint8_t>(index), static_cast<std::uint8_t>(players.size()),
+                          config.fieldWidth, config.fieldHeight, config.rotationSmoothing};
+    writeWelcome(packet, welcome);
+    channel.send(packet, players[index].address, players[index].port);
+}
+
+void GameServer::handleInput(Player& player, PacketReader& reader, size_t size) {
+    NetInputHeader header;
+    TickInput inputs[netInputRedundancy];
+    if (!readInput(reader, header, inputs) || header.lastSequence < header.count) {
+        return;
+    }
+    ++player.inputPackets;
+    player.inputBytes += size;
+    if (header.ackedTick != netNoTick && header.ackedTick <= tickCount &&
+        (player.ackedTick == netNoTick || header.ackedTick > player.ackedTick)) {
+        player.ackedTick = header.ackedTick;
+    }
+    std::uint32_t first = header.lastSequence - header.count + 1;
+    for (std::uint32_t i = 0; i < header.count; ++i) {
+        std::uint32_t sequence = first + i;
+        if (sequence > player.lastApplied && sequence + historySize > player.newestSequence) {
+            player.inputs[sequence % historySize] = inputs[i];
+            player.inputSequences[sequence % historySize] = sequence;
+        }
+    }
+    if (header.lastSequence > player.newestSequence) {
+        player.newestSequence = header.lastSequence;
+    }
+}
+
+// The input of the tick after the last applied one. If it has not arrived, the previous
+// input is repeated and the same input is tried again next tick.
+TickInput GameServer::nextInput(Player& player) {
+    if (player.newestSequence > player.lastApplied + maxQueuedInputs) {
+        player.lastApplied = player.newestSequence - maxQueuedInputs;
+    }
+    std::uint32_t sequence = player.lastApplied + 1;
+    if (player.inputSequences[sequence % historySize] == sequence) {
+        player.lastInput = player.inputs[sequence % historySize];
+        player.lastApplied = sequence;
+    } else if (player.connected) {
+        ++player.missedInputs;
+    }
+    if (!player.connected) {
+        player.lastInput.fire = false;
+    }
+    return player.lastInput;
+}
+
+void GameServer::tick(float dt) {
+    if (!started) {
+        return;
+    }
+    for (size_t i = 0; i < players.size(); ++i) {
+        tickInputs[i] = nextInput(players[i]);
+    }
+    simulation.step(dt, tickInputs.data());
+    ++tickCount;
+
+    captureSnapshot(simulation, tickCount, current);
+    for (size_t i = 0; i < players.size(); ++i) {
+        Player& player = players[i];
+        if (!player.connected) {
+            continue;
+        }
+        const NetSnapshot* baseline = nullptr;
+        if (player.ackedTick != netNoTick && tickCount - player.ackedTick < historySize &&
+            player.sent[player.ackedTick % historySize].tick == player.ackedTick) {
+            baseline = &player.sent[player.ackedTick % historySize];
+        }
+        NetSnapshotHeader header = {tickCount, netNoTick, player.lastApplied, static_cast<std::uint8_t>(i)};
+        writeSnapshot(packet, header, current, baseline, player.sent[tickCount % historySize]);
+        channel.send(packet, player.address, player.port);
+        ++player.snapshots;
+        player.fullSnapshots += baseline == nullptr;
+        player.snapshotBytes += packet.size();
+    }
+    channel.flush();
+}
+
+void GameServer::shutdown() {
+    writeBye(packet);
+    for (const auto& player : players) {
+        if (player.connected) {
+            channel.send(packet, player.address, player.port);
+        }
+    }
+    channel.flush();
+}
+
+void GameServer::printReport(double seconds) const {
+    std::printf("server: %u ticks in %.1f s, %zu meteors, %zu projectiles at the end\n", tickCount, seconds,
+                simulation.getMeteors().size(), simulation.getProjectiles().size());
+    std::printf("%-8s %12s %12s %10s %12s %8s\n", "player", "down kbit/s", "avg bytes", "full", "up kbit/s",
+                "missed");
+    for (size_t i = 0; i < players.size(); ++i) {
+        const Player& player = players[i];
+        // Rates include the IPv4 and UDP headers.
+        double down = (player.snapshotBytes + player.snapshots * udpHeaderBytes) * 8.0 / 1000.0 / seconds;
+        double up = (player.inputBytes + player.inputPackets * udpHeaderBytes) * 8.0 / 1000.0 / seconds;
+        double average = player.snapshots > 0 ? static_cast<double>(player.snapshotBytes) / player.snapshots : 0.0;
+        std::printf("%-8zu %12.1f %12.1f %10llu %12.1f %8llu\n", i + 1, down, average,
+                    static_cast<unsigned long long>(player.fullSnapshots), up,
+                    static_cast<unsigned long long>(player.missedInputs));
+    }
+    std::printf("server packets dropped by simulated loss: %llu\n",
+                static_cast<unsigned long long>(channel.getTraffic().packetsDropped));
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "net_channel.h"
+#include "net_protocol.h"
+#include "simulation.h"
+
+// Authoritative multiplayer server: owns the only Simulation, with one ship per player.
+// Players join with a Hello; the game starts once every slot is taken. Each tick applies the
+// next buffered input of every player, steps the simulation and sends every player a
+// snapshot encoded against the newest one they acknowledged.
+class GameServer {
+public:
+    struct Options {
+        int playerCount = 2;
+        unsigned short port = netDefaultPort;
+        std::uint64_t seed = 1;
+        NetConditions conditions;
+    };
+
+    // Ticks of snapshots kept as baselines, and of inputs buffered, per player.
+    static const std::uint32_t historySize = 64;
+    // Inputs waiting beyond this many are skipped, so a client that sent a burst does not
+    // play with a growing delay.
+    static const std::uint32_t maxQueuedInputs = 3;
+    // A player silent for this long is dropped; their ship stays in the field, idle.
+    static const int timeoutSeconds = 5;
+
+private:
+    struct Player {
+        bool connected = false;
+        sf::IpAddress address;
+        unsigned short port = 0;
+        std::chrono::steady_clock::time_point lastHeard;
+
+        TickInput inputs[historySize];
+        std::uint32_t inputSequences[historySize] = {};
+        std::uint32_t newestSequence = 0;
+        std::uint32_t lastApplied = 0;
+        TickInput lastInput = {{0.0f, 0.0f}, false};
+        std::uint32_t ackedTick = netNoTick;
+        // What was sent for each of the last historySize ticks, by tick modulo historySize.
+        NetSnapshot sent[historySize];
+
+        std::uint64_t snapshots = 0;
+        std::uint64_t fullSnapshots = 0;
+        std::uint64_t snapshotBytes = 0;
+        std::uint64_t inputPackets = 0;
+        std::uint64_t inputBytes = 0;
+        std::uint64_t missedInputs = 0;
+    };
+
+    Options options;
+    NetChannel channel;
+    Simulation simulation;
+    std::vector<Player> players;
+    std::vector<TickInput> tickInputs;
+    NetSnapshot current;
+    std::vector<std::uint8_t> packet;
+    std::uint32_t tickCount;
+    bool started;
+
+    int findPlayer(const sf::IpAddress& address, unsigned short port) const;
+    void handleHello(const sf::IpAddress& address, unsigned short port);
+    void handleInput(Player& player, PacketReader& reader, size_t size);
+    void sendWelcome(int index);
+    TickInput nextInput(Player& player);
+
+public:
+    // masks (nullptr for none) turn on pixel collisions, as in Simulation::setSpriteMasks.
+    // Throws std::runtime_error if the port cannot be bound.
+    GameServer(const SimConfig& config, const Options& options, const SpriteMasks* masks = nullptr);
+
+    // Handles every waiting packet and sends delayed ones that are due; call at least once per tick.
+    void poll();
+    // Steps the game one tick once every player has joined, and sends the snapshots.
+    void tick(float dt);
+    // Tells the players the server is going away.
+    void shutdown();
+    void printReport(double seconds) const;
+
+    bool isStarted() const {
+        return started;
+    }
+
+    bool isGameOver() const {
+        return simulation.isGameOver();
+    }
+
+    unsigned short getPort() const {
+        return channel.getLocalPort();
+    }
+
+    const Simulation& getSimulation() const {
+        return simulation;
+    }
+};
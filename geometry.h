@@ -0,0 +1,18 @@
+#pragma once
+
+struct Vec2 {
+    float x;
+    float y;
+};
+
+struct Bounds {
+    float left;
+    float top;
+    float width;
+    float height;
+
+    bool intersects(const Bounds& other) const {
+        return left < other.left + other.width && other.left < left + width &&
+               top < other.top + other.height && other.top < top + height;
+    }
+};
@@ -0,0 +1,192 @@
+#include "hud.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    const float cornerMargin = 10.0f;
+}
+
+const sf::Vector2f Hud::artworkSize(1920.0f, 1080.0f);
+
+Hud::Hud() : font(nullptr), viewSize(artworkSize), batchesDirty(true) {}
+
+void Hud::setFont(const sf::Font& value) {
+    font = &value;
+    for (auto& widget : texts) {
+        widget.dirty = true;
+    }
+}
+
+void Hud::layout(sf::Vector2f size) {
+    viewSize = size;
+    for (auto& widget : texts) {
+        widget.dirty = true;
+    }
+    for (auto& button : buttons) {
+        sf::Vector2f topLeft = toView(sf::Vector2f(button.artworkRect.left, button.artworkRect.top));
+        sf::Vector2f bottomRight = toView(sf::Vector2f(button.artworkRect.left + button.artworkRect.width,
+                                                       button.artworkRect.top + button.artworkRect.height));
+        button.rect = sf::FloatRect(topLeft.x, topLeft.y, bottomRight.x - topLeft.x, bottomRight.y - topLeft.y);
+    }
+}
+
+sf::Vector2f Hud::toView(sf::Vector2f artworkPoint) const {
+    return sf::Vector2f(artworkPoint.x * viewSize.x / artworkSize.x, artworkPoint.y * viewSize.y / artworkSize.y);
+}
+
+int Hud::addText(const std::string& text, unsigned characterSize, sf::Color color, Anchor anchor, sf::Vector2f offset) {
+    TextWidget widget;
+    widget.text = text;
+    widget.value = 0;
+    widget.characterSize = characterSize;
+    widget.color = color;
+    widget.anchor = anchor;
+    widget.offset = offset;
+    widget.visible = true;
+    widget.dirty = true;
+    texts.push_back(widget);
+    return static_cast<int>(texts.size() - 1);
+}
+
+int Hud::addCounter(const std::string& prefix, unsigned characterSize, sf::Color color, Anchor anchor, sf::Vector2f offset) {
+    int id = addText(prefix + "0", characterSize, color, anchor, offset);
+    texts[id].prefix = prefix;
+    return id;
+}
+
+int Hud::addButton(const sf::FloatRect& artworkRect) {
+    buttons.push_back({artworkRect, artworkRect});
+    layout(viewSize);
+    return static_cast<int>(buttons.size() - 1);
+}
+
+void Hud::setValue(int id, int value) {
+    TextWidget& widget = texts[id];
+    if (widget.value == value) {
+        return;
+    }
+    widget.value = value;
+    // Built in place, so a changing counter reuses the string's storage.
+    char digits[16];
+    std::snprintf(digits, sizeof(digits), "%d", value);
+    widget.text.assign(widget.prefix).append(digits);
+    widget.dirty = true;
+}
+
+void Hud::setText(int id, const std::string& text) {
+    TextWidget& widget = texts[id];
+    if (widget.text == text) {
+        return;
+    }
+    widget.text = text;
+    widget.dirty = true;
+}
+
+void Hud::setVisible(int id, bool visible) {
+    if (texts[id].visible != visible) {
+        texts[id].visible = visible;
+        batchesDirty = true;
+    }
+}
+
+void Hud::rebuild(TextWidget& widget) {
+    widget.vertices.clear();
+    widget.dirty = false;
+    batchesDirty = true;
+    if (font == nullptr) {
+        return;
+    }
+
+    // Glyph placement follows sf::Text: the first baseline sits characterSize below the top.
+    float lineSpacing = font->getLineSpacing(widget.characterSize);
+    float x = 0.0f;
+    float y = static_cast<float>(widget.characterSize);
+    float width = 0.0f;
+    sf::Uint32 previous = 0;
+    for (char character : widget.text) {
+        sf::Uint32 current = static_cast<unsigned char>(character);
+        if (current == '\n') {
+            x = 0.0f;
+            y += lineSpacing;
+            previous = 0;
+            continue;
+        }
+        x += font->getKerning(previous, current, widget.characterSize);
+        const sf::Glyph& glyph = font->getGlyph(current, widget.characterSize, false);
+        float left = x + glyph.bounds.left;
+        float top = y + glyph.bounds.top;
+        float right = left + glyph.bounds.width;
+        float bottom = top + glyph.bounds.height;
+        float u0 = static_cast<float>(glyph.textureRect.left);
+        float v0 = static_cast<float>(glyph.textureRect.top);
+        float u1 = u0 + glyph.textureRect.width;
+        float v1 = v0 + glyph.textureRect.height;
+
+        widget.vertices.push_back(sf::Vertex(sf::Vector2f(left, top), widget.color, sf::Vector2f(u0, v0)));
+        widget.vertices.push_back(sf::Vertex(sf::Vector2f(right, top), widget.color, sf::Vector2f(u1, v0)));
+        widget.vertices.push_back(sf::Vertex(sf::Vector2f(right, bottom), widget.color, sf::Vector2f(u1, v1)));
+        widget.vertices.push_back(sf::Vertex(sf::Vector2f(left, top), widget.color, sf::Vector2f(u0, v0)));
+        widget.vertices.push_back(sf::Vertex(sf::Vector2f(right, bottom), widget.color, sf::Vector2f(u1, v1)));
+        widget.vertices.push_back(sf::Vertex(sf::Vector2f(left, bottom), widget.color, sf::Vector2f(u0, v1)));
+
+        x += glyph.advance;
+        width = std::max(width, x);
+        previous = current;
+    }
+
+    sf::Vector2f origin;
+    switch (widget.anchor) {
+        case Anchor::TopLeft:
+            origin = sf::Vector2f(cornerMargin + widget.offset.x, cornerMargin + widget.offset.y);
+            break;
+        case Anchor::TopRight:
+            origin = sf::Vector2f(viewSize.x - cornerMargin - width - widget.offset.x, cornerMargin + widget.offset.y);
+            break;
+        case Anchor::Artwork:
+            origin = toView(widget.offset);
+            break;
+    }
+    for (auto& vertex : widget.vertices) {
+        vertex.position += origin;
+    }
+}
+
+void Hud::draw(sf::RenderTarget& target, RenderStats* stats) {
+    if (font == nullptr) {
+        return;
+    }
+    for (auto& widget : texts) {
+        if (widget.dirty) {
+            rebuild(widget);
+        }
+    }
+    if (batchesDirty) {
+        for (auto& batch : batches) {
+            batch.second.clear();
+        }
+        for (const auto& widget : texts) {
+            if (!widget.visible) {
+                continue;
+            }
+            sf::VertexArray& batch = batches[widget.characterSize];
+            batch.setPrimitiveType(sf::Triangles);
+            for (const auto& vertex : widget.vertices) {
+                batch.append(vertex);
+            }
+        }
+        batchesDirty = false;
+    }
+
+    for (const auto& batch : batches) {
+        if (batch.second.getVertexCount() == 0) {
+            continue;
+        }
+        sf::RenderStates states;
+        states.texture = &font->getTexture(batch.first);
+        target.draw(batch.second, states);
+        if (stats != nullptr) {
+            stats->add(batch.second.getVertexCount());
+        }
+    }
+}
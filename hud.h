@@ -0,0 +1,81 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "render_stats.h"
+
+// Retained overlay for the score, lives, menu and game-over texts and the button hit areas.
+// Widgets keep their glyph quads and only rebuild them when their value changes; draw()
+// submits every visible text of one character size in a single call, since all glyphs of a
+// size live on the same font page.
+//
+// Positions are given either relative to a window corner (HUD counters) or in the 1920x1080
+// coordinates of the menu and game-over artwork, which are scaled to the current view.
+class Hud {
+public:
+    enum class Anchor {
+        TopLeft,
+        TopRight,
+        Artwork
+    };
+
+private:
+    struct TextWidget {
+        std::string prefix;
+        std::string text;
+        int value;
+        unsigned characterSize;
+        sf::Color color;
+        Anchor anchor;
+        sf::Vector2f offset;
+        bool visible;
+        bool dirty;
+        std::vector<sf::Vertex> vertices;
+    };
+
+    struct Button {
+        sf::FloatRect artworkRect;
+        sf::FloatRect rect;
+    };
+
+    const sf::Font* font;
+    sf::Vector2f viewSize;
+    std::vector<TextWidget> texts;
+    std::vector<Button> buttons;
+    std::map<unsigned, sf::VertexArray> batches;
+    bool batchesDirty;
+
+    void rebuild(TextWidget& widget);
+    sf::Vector2f toView(sf::Vector2f artworkPoint) const;
+
+public:
+    static const sf::Vector2f artworkSize;
+
+    Hud();
+
+    void setFont(const sf::Font& value);
+    // Recomputes every position for a view of the given size.
+    void layout(sf::Vector2f size);
+
+    int addText(const std::string& text, unsigned characterSize, sf::Color color, Anchor anchor, sf::Vector2f offset);
+    // A text shown as prefix followed by an integer; the integer is set with setValue.
+    int addCounter(const std::string& prefix, unsigned characterSize, sf::Color color, Anchor anchor, sf::Vector2f offset);
+    int addButton(const sf::FloatRect& artworkRect);
+
+    void setValue(int id, int value);
+    void setText(int id, const std::string& text);
+    void setVisible(int id, bool visible);
+
+    const sf::FloatRect& getButtonRect(int id) const {
+        return buttons[id].rect;
+    }
+
+    bool isButtonAt(int id, sf::Vector2f point) const {
+        return buttons[id].rect.contains(point);
+    }
+
+    void draw(sf::RenderTarget& target, RenderStats* stats = nullptr);
+};
@@ -0,0 +1,274 @@
+#include "input_log.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+    // Pointers on whole pixels (all of them when they come from the mouse) are stored as
+    // integer deltas; anything else falls back to raw floats.
+    bool isWholePixel(float value) {
+        return std::fabs(value) < 16777216.0f && std::floor(value) == value;
+    }
+
+    std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    std::int64_t unzigzag(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    InputLogHeader makeHeader(const Simulation& simulation, float tickSeconds, std::uint32_t hashInterval) {
+        const SimConfig& config = simulation.getConfig();
+        InputLogHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, inputLogMagic, sizeof(header.magic));
+        header.version = inputLogVersion;
+        header.seed = simulation.getSeed();
+        header.maskHash = simulation.getSpriteMaskHash();
+        header.tickSeconds = tickSeconds;
+        header.hashInterval = hashInterval;
+        header.fieldWidth = config.fieldWidth;
+        header.fieldHeight = config.fieldHeight;
+        header.startLives = config.startLives;
+        header.meteorSpawnInterval = config.meteorSpawnInterval;
+        header.meteorSpeed = config.meteorSpeed;
+        header.projectileSpeed = config.projectileSpeed;
+        header.fireInterval = config.fireInterval;
+        header.projectileCapacity = static_cast<std::uint32_t>(config.projectileCapacity);
+        header.hitFlashDuration = config.hitFlashDuration;
+        header.rotationSmoothing = config.rotationSmoothing;
+        header.shipSize[0] = config.shipSize.x;
+        header.shipSize[1] = config.shipSize.y;
+        header.projectileSize[0] = config.projectileSize.x;
+        header.projectileSize[1] = config.projectileSize.y;
+        for (int stage = 0; stage < Simulation::meteorStageCount; ++stage) {
+            header.meteorSizes[stage * 2] = config.meteorSizes[stage].x;
+            header.meteorSizes[stage * 2 + 1] = config.meteorSizes[stage].y;
+        }
+        header.shipSpeed = config.shipSpeed;
+        header.awakeDistance = config.awakeDistance;
+        header.sleepInterval = config.sleepInterval;
+        header.sweptProjectiles = config.sweptProjectiles ? 1 : 0;
+        return header;
+    }
+}
+
+SimConfig toSimConfig(const InputLogHeader& header) {
+    SimConfig config;
+    config.fieldWidth = header.fieldWidth;
+    config.fieldHeight = header.fieldHeight;
+    config.startLives = header.startLives;
+    config.meteorSpawnInterval = header.meteorSpawnInterval;
+    config.meteorSpeed = header.meteorSpeed;
+    config.projectileSpeed = header.projectileSpeed;
+    config.fireInterval = header.fireInterval;
+    config.projectileCapacity = header.projectileCapacity;
+    config.hitFlashDuration = header.hitFlashDuration;
+    config.rotationSmoothing = header.rotationSmoothing;
+    config.shipSize = {header.shipSize[0], header.shipSize[1]};
+    config.projectileSize = {header.projectileSize[0], header.projectileSize[1]};
+    for (int stage = 0; stage < Simulation::meteorStageCount; ++stage) {
+        config.meteorSizes[stage] = {header.meteorSizes[stage * 2], header.meteorSizes[stage * 2 + 1]};
+    }
+    config.shipSpeed = header.shipSpeed;
+    config.awakeDistance = header.awakeDistance;
+    config.sleepInterval = header.sleepInterval;
+    config.sweptProjectiles = header.sweptProjectiles != 0;
+    config.seed = header.seed;
+    return config;
+}
+
+InputRecorder::InputRecorder() : lastPointer{0.0f, 0.0f}, hashInterval(1), ticks(0) {}
+
+bool InputRecorder::open(const std::string& path, const Simulation& simulation, float tickSeconds,
+                         std::uint32_t interval) {
+    file.close();
+    // The log holds one input per tick, so only one-ship games can be recorded.
+    if (simulation.getShipCount() != 1) {
+        return false;
+    }
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    hashInterval = interval == 0 ? 1 : interval;
+    ticks = 0;
+    lastPointer = {0.0f, 0.0f};
+    InputLogHeader header = makeHeader(simulation, tickSeconds, hashInterval);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return file.good();
+}
+
+void InputRecorder::writeVarint(std::uint64_t value) {
+    while (value >= 0x80) {
+        file.put(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    file.put(static_cast<char>(value));
+}
+
+void InputRecorder::record(const TickInput& input, const Simulation& simulation) {
+    if (!file.is_open()) {
+        return;
+    }
+    ++ticks;
+    std::uint8_t flags = input.fire ? inputLogFire : 0;
+    bool moved = input.pointer.x != lastPointer.x || input.pointer.y != lastPointer.y;
+    bool whole = isWholePixel(input.pointer.x) && isWholePixel(input.pointer.y) &&
+                 isWholePixel(lastPointer.x) && isWholePixel(lastPointer.y);
+    if (moved) {
+        flags |= whole ? inputLogPointerDelta : inputLogPointerRaw;
+    }
+    bool hashed = ticks % hashInterval == 0;
+    if (hashed) {
+        flags |= inputLogHash;
+    }
+
+    file.put(static_cast<char>(flags));
+    if (flags & inputLogPointerDelta) {
+        writeVarint(zigzag(static_cast<std::int64_t>(input.pointer.x) - static_cast<std::int64_t>(lastPointer.x)));
+        writeVarint(zigzag(static_cast<std::int64_t>(input.pointer.y) - static_cast<std::int64_t>(lastPointer.y)));
+    } else if (flags & inputLogPointerRaw) {
+        file.write(reinterpret_cast<const char*>(&input.pointer), sizeof(input.pointer));
+    }
+    if (hashed) {
+        std::uint32_t hash = static_cast<std::uint32_t>(simulation.computeStateHash());
+        file.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    }
+    lastPointer = input.pointer;
+
+    // Roughly once a second, so a crash loses little of the session.
+    if (ticks % 64 == 0) {
+        file.flush();
+    }
+}
+
+void InputRecorder::close(const Simulation& simulation) {
+    if (!file.is_open()) {
+        return;
+    }
+    file.put(static_cast<char>(inputLogEnd));
+    writeVarint(ticks);
+    std::uint64_t hash = simulation.computeStateHash();
+    file.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    file.close();
+}
+
+InputLogReader::InputLogReader()
+        : cursor(0), pointer{0.0f, 0.0f}, ended(false), recordedTicks(0), finalHash(0) {
+    std::memset(&header, 0, sizeof(header));
+}
+
+bool InputLogReader::open(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    cursor = 0;
+    pointer = {0.0f, 0.0f};
+    ended = false;
+    recordedTicks = 0;
+    finalHash = 0;
+    return readBytes(&header, sizeof(header)) && std::memcmp(header.magic, inputLogMagic, sizeof(header.magic)) == 0 &&
+           header.version == inputLogVersion;
+}
+
+bool InputLogReader::readBytes(void* target, size_t bytes) {
+    if (data.size() - cursor < bytes) {
+        return false;
+    }
+    std::memcpy(target, data.data() + cursor, bytes);
+    cursor += bytes;
+    return true;
+}
+
+bool InputLogReader::readVarint(std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < data.size(); shift += 7) {
+        std::uint8_t byte = data[cursor++];
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InputLogReader::next(TickInput& input, bool& hasHash, std::uint32_t& hash) {
+    std::uint8_t flags;
+    if (ended || !readBytes(&flags, 1)) {
+        return false;
+    }
+    if (flags == inputLogEnd) {
+        std::uint64_t ticks;
+        ended = readVarint(ticks) && readBytes(&finalHash, sizeof(finalHash));
+        recordedTicks = ticks;
+        return false;
+    }
+
+    size_t recordStart = cursor - 1;
+    Vec2 next = pointer;
+    bool complete = true;
+    if (flags & inputLogPointerDelta) {
+        std::uint64_t dx = 0;
+        std::uint64_t dy = 0;
+        complete = readVarint(dx) && readVarint(dy);
+        next.x = static_cast<float>(static_cast<std::int64_t>(pointer.x) + unzigzag(dx));
+        next.y = static_cast<float>(static_cast<std::int64_t>(pointer.y) + unzigzag(dy));
+    } else if (flags & inputLogPointerRaw) {
+        complete = readBytes(&next, sizeof(next));
+    }
+    hasHash = (flags & inputLogHash) != 0;
+    if (complete && hasHash) {
+        complete = readBytes(&hash, sizeof(hash));
+    }
+    if (!complete) {
+        cursor = recordStart;
+        return false;
+    }
+    pointer = next;
+    input.pointer = pointer;
+    input.fire = (flags & inputLogFire) != 0;
+    return true;
+}
+
+ReplayResult replayInputLog(const std::string& path, JobSystem* jobs, const SpriteMasks* masks) {
+    InputLogReader reader;
+    if (!reader.open(path)) {
+        throw std::runtime_error("Failed to open input log " + path);
+    }
+    const InputLogHeader& header = reader.getHeader();
+    Simulation simulation(toSimConfig(header));
+    simulation.setJobSystem(jobs);
+    if (header.maskHash != 0) {
+        if (masks == nullptr) {
+            throw std::runtime_error("The log was played with sprite masks; load them from the game's asset pack");
+        }
+        simulation.setSpriteMasks(*masks);
+        if (simulation.getSpriteMaskHash() != header.maskHash) {
+            throw std::runtime_error("The sprite masks differ from the ones the log was played with");
+        }
+    }
+
+    ReplayResult result = {0, 0, false, false, 0.0};
+    auto start = std::chrono::steady_clock::now();
+    TickInput input;
+    bool hasHash = false;
+    std::uint32_t hash = 0;
+    while (reader.next(input, hasHash, hash)) {
+        simulation.step(header.tickSeconds, input);
+        ++result.ticks;
+        if (hasHash && result.firstMismatch == 0 && static_cast<std::uint32_t>(simulation.computeStateHash()) != hash) {
+            result.firstMismatch = result.ticks;
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.complete = reader.hasEndRecord() && reader.getRecordedTicks() == result.ticks;
+    result.finalHashMatches = result.complete && simulation.computeStateHash() == reader.getFinalHash();
+    return result;
+}
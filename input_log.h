@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "simulation.h"
+
+class JobSystem;
+
+// Binary log of the input a game was played with, enough to re-simulate it exactly.
+//
+// Layout (little-endian): InputLogHeader, then one record per tick. A record starts with a
+// flags byte: inputLogFire, then inputLogPointerDelta (two zigzag varints, the change of
+// the whole-pixel pointer since the last record) or inputLogPointerRaw (two floats, for
+// pointers off the pixel grid), then inputLogHash (the low 32 bits of
+// Simulation::computeStateHash after the tick). An unchanged pointer takes no bytes, so
+// most ticks cost one byte plus the hash. A log that was closed properly ends with
+// inputLogEnd, the tick count as a varint and the full 64-bit final state hash; a log cut
+// short by a crash still replays up to its last complete record.
+
+const char inputLogMagic[4] = {'A', 'G', 'I', 'R'};
+const std::uint32_t inputLogVersion = 5;
+
+const std::uint8_t inputLogFire = 1 << 0;
+const std::uint8_t inputLogPointerDelta = 1 << 1;
+const std::uint8_t inputLogPointerRaw = 1 << 2;
+const std::uint8_t inputLogHash = 1 << 3;
+const std::uint8_t inputLogEnd = 0x80;
+
+// The seed, tick length, sprite masks and every SimConfig field, in fixed-size types.
+struct InputLogHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t seed;
+    // Simulation::getSpriteMaskHash of the game, 0 if it ran without masks.
+    std::uint64_t maskHash;
+    float tickSeconds;
+    std::uint32_t hashInterval;
+    float fieldWidth;
+    float fieldHeight;
+    std::int32_t startLives;
+    float meteorSpawnInterval;
+    float meteorSpeed;
+    float projectileSpeed;
+    float fireInterval;
+    std::uint32_t projectileCapacity;
+    float hitFlashDuration;
+    float rotationSmoothing;
+    float shipSize[2];
+    float projectileSize[2];
+    float meteorSizes[6];
+    float shipSpeed;
+    float awakeDistance;
+    std::int32_t sleepInterval;
+    std::uint32_t sweptProjectiles;
+};
+
+SimConfig toSimConfig(const InputLogHeader& header);
+
+// Streams the input of one game to a log. Open it right after Simulation::reset and call
+// record() after every step.
+class InputRecorder {
+private:
+    std::ofstream file;
+    Vec2 lastPointer;
+    std::uint32_t hashInterval;
+    unsigned long long ticks;
+
+    void writeVarint(std::uint64_t value);
+
+public:
+    InputRecorder();
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    // hashInterval 1 stores a state hash after every tick; larger values give a smaller log
+    // that still finds a desync within that many ticks. Fails for games with more than one ship.
+    bool open(const std::string& path, const Simulation& simulation, float tickSeconds, std::uint32_t hashInterval = 1);
+    void record(const TickInput& input, const Simulation& simulation);
+    // Writes the end record. A recorder destroyed without close() leaves a log that ends
+    // after its last tick record, like one cut off by a crash.
+    void close(const Simulation& simulation);
+
+    bool isOpen() const {
+        return file.is_open();
+    }
+};
+
+class InputLogReader {
+private:
+    std::vector<std::uint8_t> data;
+    size_t cursor;
+    InputLogHeader header;
+    Vec2 pointer;
+    bool ended;
+    unsigned long long recordedTicks;
+    std::uint64_t finalHash;
+
+    bool readVarint(std::uint64_t& value);
+    bool readBytes(void* target, size_t bytes);
+
+public:
+    InputLogReader();
+
+    // Reads the whole log; false if it cannot be read or has the wrong magic or version.
+    bool open(const std::string& path);
+
+    const InputLogHeader& getHeader() const {
+        return header;
+    }
+
+    // Fills in the input of the next tick and its stored hash, if any. Returns false at the
+    // end of the log, or at a record cut short.
+    bool next(TickInput& input, bool& hasHash, std::uint32_t& hash);
+
+    // Only known once next() has returned false.
+    bool hasEndRecord() const {
+        return ended;
+    }
+
+    unsigned long long getRecordedTicks() const {
+        return recordedTicks;
+    }
+
+    std::uint64_t getFinalHash() const {
+        return finalHash;
+    }
+};
+
+struct ReplayResult {
+    unsigned long long ticks;
+    // Tick number (1-based) of the first stored hash that did not match, 0 if none.
+    unsigned long long firstMismatch;
+    bool finalHashMatches;
+    bool complete;
+    double seconds;
+};
+
+// Re-simulates a whole log without rendering and checks every stored hash. A game played
+// with sprite masks needs the same masks; throws if they are missing or differ.
+ReplayResult replayInputLog(const std::string& path, JobSystem* jobs = nullptr, const SpriteMasks* masks = nullptr);
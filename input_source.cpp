@@ -0,0 +1,130 @@
+#include "input_source.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Pointer movement per tick while travelling and while only turning, in pixels.
+    const float cruiseSpeed = 7.0f;
+    const float turnSpeed = 2.0f;
+    // Extra room kept around meteors, and from the edges of the field.
+    const float safetyMargin = 120.0f;
+    const float edgeMargin = 100.0f;
+    // Distance to its target at which the bot stops closing in.
+    const float standoffDistance = 450.0f;
+    // The bot fires while its ship points at the target within this many degrees.
+    const float aimTolerance = 12.0f;
+    const int wanderInterval = 120;
+    const float radiansToDegrees = 180.0f / 3.14159265f;
+
+    Vec2 normalised(Vec2 value) {
+        float length = std::sqrt(value.x * value.x + value.y * value.y);
+        return length > 0.0f ? Vec2{value.x / length, value.y / length} : Vec2{0.0f, 0.0f};
+    }
+
+    // Ship rotations are in degrees clockwise from straight up.
+    float bearing(Vec2 from, Vec2 to) {
+        return std::atan2(to.x - from.x, from.y - to.y) * radiansToDegrees;
+    }
+
+    float angleBetween(float from, float to) {
+        float difference = to - from;
+        return difference - std::floor((difference + 180.0f) / 360.0f) * 360.0f;
+    }
+}
+
+RecordedInput::RecordedInput() : last{{0.0f, 0.0f}, false}, finished(true) {}
+
+bool RecordedInput::open(const std::string& path) {
+    finished = !reader.open(path);
+    return !finished;
+}
+
+TickInput RecordedInput::next(const Simulation&) {
+    bool hasHash;
+    std::uint32_t hash;
+    if (!finished && !reader.next(last, hasHash, hash)) {
+        finished = true;
+    }
+    return last;
+}
+
+Autopilot::Autopilot(std::uint64_t seed, size_t shipIndex)
+        : shipIndex(shipIndex), random(seed, 0x626f74), pointer{0.0f, 0.0f}, hasPointer(false), wander{1.0f, 0.0f},
+          wanderTicks(0) {}
+
+TickInput Autopilot::next(const Simulation& simulation) {
+    const SimConfig& config = simulation.getConfig();
+    const ShipState& ship = simulation.getShip(shipIndex);
+    if (!hasPointer) {
+        pointer = ship.hasPointer ? ship.position : Vec2{config.fieldWidth / 2.0f, config.fieldHeight / 2.0f};
+        hasPointer = true;
+    }
+
+    // Every meteor closer than its reach pushes the ship away, harder the closer it is; the
+    // nearest meteor inside the field is the target.
+    float shipRadius = 0.5f * std::max(config.shipSize.x, config.shipSize.y);
+    Vec2 away = {0.0f, 0.0f};
+    Vec2 target = {0.0f, 0.0f};
+    float targetDistance = 0.0f;
+    bool hasTarget = false;
+    const MeteorField& meteors = simulation.getMeteors();
+    for (size_t i = 0; i < meteors.size(); ++i) {
+        Bounds bounds = meteors.getBounds(i);
+        Vec2 centre = {bounds.left + bounds.width / 2.0f, bounds.top + bounds.height / 2.0f};
+        Vec2 offset = {pointer.x - centre.x, pointer.y - centre.y};
+        float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+        float reach = 0.5f * std::max(bounds.width, bounds.height) + shipRadius + safetyMargin;
+        if (distance < reach) {
+            Vec2 direction = distance > 0.0f ? Vec2{offset.x / distance, offset.y / distance} : wander;
+            float weight = (reach - distance) / reach;
+            away.x += direction.x * weight;
+            away.y += direction.y * weight;
+        }
+        bool inside = centre.x > 0.0f && centre.y > 0.0f && centre.x < config.fieldWidth && centre.y < config.fieldHeight;
+        if (inside && (!hasTarget || distance < targetDistance)) {
+            target = centre;
+            targetDistance = distance;
+            hasTarget = true;
+        }
+    }
+
+    Vec2 heading = {0.0f, 0.0f};
+    float speed = cruiseSpeed;
+    float aimError = hasTarget ? std::fabs(angleBetween(ship.rotation, bearing(ship.position, target))) : 180.0f;
+    if (away.x != 0.0f || away.y != 0.0f) {
+        heading = normalised(away);
+    } else if (hasTarget) {
+        // Close in on the target. Once near, stand still while facing it, since a pointer
+        // that does not move leaves the ship's rotation alone, and only creep towards it to
+        // turn the ship back on target.
+        heading = normalised({target.x - pointer.x, target.y - pointer.y});
+        if (targetDistance < standoffDistance) {
+            speed = aimError > aimTolerance ? turnSpeed : 0.0f;
+        }
+    } else {
+        if (--wanderTicks <= 0) {
+            float angle = random.nextFloat() * 6.2831853f;
+            wander = {std::cos(angle), std::sin(angle)};
+            wanderTicks = wanderInterval;
+        }
+        heading = wander;
+    }
+
+    // Keep off the edges, where meteors come in from.
+    if (pointer.x < edgeMargin * 2.0f) {
+        heading.x += 1.0f;
+    } else if (pointer.x > config.fieldWidth - edgeMargin * 2.0f) {
+        heading.x -= 1.0f;
+    }
+    if (pointer.y < edgeMargin * 2.0f) {
+        heading.y += 1.0f;
+    } else if (pointer.y > config.fieldHeight - edgeMargin * 2.0f) {
+        heading.y -= 1.0f;
+    }
+    heading = normalised(heading);
+    pointer.x = std::max(edgeMargin, std::min(config.fieldWidth - edgeMargin, pointer.x + heading.x * speed));
+    pointer.y = std::max(edgeMargin, std::min(config.fieldHeight - edgeMargin, pointer.y + heading.y * speed));
+
+    return {{std::round(pointer.x), std::round(pointer.y)}, hasTarget && aimError < aimTolerance};
+}
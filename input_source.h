@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "input_log.h"
+#include "rng.h"
+#include "simulation.h"
+
+// Where the input of each tick comes from: the mouse and keyboard (LiveInput in the game),
+// a recorded log or the autopilot. The game loop asks its source once per tick, right
+// before stepping, so a source that is not a person can drive the game just as well.
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // The input for the next step of simulation.
+    virtual TickInput next(const Simulation& simulation) = 0;
+
+    // True once the source has no more input, e.g. at the end of a recording. next() then
+    // keeps returning the last input.
+    virtual bool isFinished() const {
+        return false;
+    }
+};
+
+// Plays back an input log. The simulation must have been reset with the log's settings
+// (toSimConfig of the header) and seed for the game to come out the same.
+class RecordedInput : public InputSource {
+private:
+    InputLogReader reader;
+    TickInput last;
+    bool finished;
+
+public:
+    RecordedInput();
+
+    // False if the log cannot be read.
+    bool open(const std::string& path);
+    TickInput next(const Simulation& simulation) override;
+
+    bool isFinished() const override {
+        return finished;
+    }
+
+    const InputLogHeader& getHeader() const {
+        return reader.getHeader();
+    }
+};
+
+// A bot that plays one ship. It steers away from meteors that come close, and otherwise
+// closes in on the nearest meteor and fires while the ship faces it. The ship turns towards
+// the way the pointer moves, so the bot aims by moving the pointer at its target.
+class Autopilot : public InputSource {
+private:
+    size_t shipIndex;
+    Rng random;
+    Vec2 pointer;
+    bool hasPointer;
+    // Direction of travel while no meteor is in sight, changed now and then.
+    Vec2 wander;
+    int wanderTicks;
+
+public:
+    explicit Autopilot(std::uint64_t seed = 1, size_t shipIndex = 0);
+
+    TickInput next(const Simulation& simulation) override;
+};
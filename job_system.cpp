@@ -0,0 +1,103 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned threadCount) : queuedJobs(0), unfinishedJobs(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+bool JobSystem::takeJob(unsigned worker, Job& job) {
+    {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.jobs.size() > own.front) {
+            job = own.jobs.back();
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkerQueue& victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.jobs.size() > victim.front) {
+            job = victim.jobs[victim.front++];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::runOne(unsigned worker) {
+    Job job;
+    if (!takeJob(worker, job)) {
+        return false;
+    }
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    job.invoke(job.body, job.begin, job.end, worker);
+    unfinishedJobs.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerLoop(unsigned worker) {
+    for (;;) {
+        if (runOne(worker)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queuedJobs.load(std::memory_order_relaxed) > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void JobSystem::run(size_t count, size_t grain, void* body, Invoke invoke) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunkCount = (count + grain - 1) / grain;
+    for (auto& queue : queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->jobs.clear();
+        queue->front = 0;
+    }
+    // Both counters are set before any chunk is visible, so a thread that is still looking
+    // for work from the previous loop cannot finish a chunk before it has been counted.
+    unfinishedJobs.store(chunkCount, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs.store(chunkCount, std::memory_order_relaxed);
+    }
+    // Each queue gets a contiguous run of chunks, pushed highest first so its owner pops
+    // them in ascending order and thieves take the far end.
+    size_t chunksPerQueue = (chunkCount + queues.size() - 1) / queues.size();
+    for (size_t chunk = chunkCount; chunk-- > 0; ) {
+        WorkerQueue& queue = *queues[chunk / chunksPerQueue];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(Job{body, invoke, chunk * grain, std::min(count, (chunk + 1) * grain)});
+    }
+    wake.notify_all();
+
+    while (unfinishedJobs.load(std::memory_order_acquire) > 0) {
+        if (!runOne(0)) {
+            std::this_thread::yield();
+        }
+    }
+}
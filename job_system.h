@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Small work-stealing job system for the simulation's data-parallel loops.
+//
+// parallelFor cuts an index range into chunks and deals them out to per-thread queues.
+// Each thread takes chunks from the back of its own queue and, once that is empty, steals
+// from the front of the others', so uneven chunks still keep every core busy. The calling
+// thread works as worker 0 until the whole range is done; with one thread, or a range no
+// larger than one chunk, the body simply runs inline. Only one thread may call parallelFor
+// at a time, and bodies must not call it themselves.
+class JobSystem {
+private:
+    typedef void (*Invoke)(void* body, size_t begin, size_t end, unsigned worker);
+
+    struct Job {
+        void* body;
+        Invoke invoke;
+        size_t begin;
+        size_t end;
+    };
+
+    // The owner pops from the back, thieves advance front; both under the mutex. The
+    // storage is reused between loops, so a loop allocates nothing once it has grown.
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<Job> jobs;
+        size_t front = 0;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queuedJobs;
+    std::atomic<size_t> unfinishedJobs;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    bool takeJob(unsigned worker, Job& job);
+    bool runOne(unsigned worker);
+    void workerLoop(unsigned worker);
+    void run(size_t count, size_t grain, void* body, Invoke invoke);
+
+public:
+    // 0 uses every hardware thread.
+    explicit JobSystem(unsigned threadCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned getThreadCount() const {
+        return static_cast<unsigned>(queues.size());
+    }
+
+    // Calls body(begin, end, worker) for consecutive chunks of at most grain indices that
+    // together cover [0, count), and returns once all of them have finished. worker is in
+    // [0, getThreadCount()) and identifies the thread, for per-thread scratch buffers.
+    template <typename Body>
+    void parallelFor(size_t count, size_t grain, Body& body) {
+        if (count == 0) {
+            return;
+        }
+        if (threads.empty() || count <= grain) {
+            body(size_t(0), count, 0u);
+            return;
+        }
+        run(count, grain, &body, [](void* context, size_t begin, size_t end, unsigned worker) {
+            (*static_cast<Body*>(context))(begin, end, worker);
+        });
+    }
+};
@@ -0,0 +1,51 @@
+#include "latency_tracker.h"
+
+#include <algorithm>
+
+LatencyTracker::LatencyTracker(size_t history)
+        : samples(std::max<size_t>(history, 1)), cursor(0), count(0), pending(false), lastMilliseconds(0.0f),
+          sorted(samples.size()) {}
+
+void LatencyTracker::inputApplied(Clock::time_point time) {
+    if (!pending || time < pendingSince) {
+        pendingSince = time;
+        pending = true;
+    }
+}
+
+void LatencyTracker::framePresented(Clock::time_point time) {
+    if (!pending) {
+        return;
+    }
+    lastMilliseconds = std::chrono::duration<float, std::milli>(time - pendingSince).count();
+    samples[cursor] = lastMilliseconds;
+    cursor = (cursor + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+    pending = false;
+}
+
+void LatencyTracker::clear() {
+    cursor = 0;
+    count = 0;
+    pending = false;
+    lastMilliseconds = 0.0f;
+}
+
+LatencyTracker::Stats LatencyTracker::getStats() const {
+    Stats stats = {count, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if (count == 0) {
+        return stats;
+    }
+    std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + count);
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += sorted[i];
+    }
+    stats.averageMilliseconds = sum / count;
+    stats.p50Milliseconds = sorted[count / 2];
+    stats.p95Milliseconds = sorted[count * 95 / 100];
+    stats.p99Milliseconds = sorted[count * 99 / 100];
+    stats.maximumMilliseconds = sorted[count - 1];
+    return stats;
+}
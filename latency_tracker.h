@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Input-to-present latency: the time from an input reaching the game to the end of the
+// display() call of the first frame that shows it. The game loop reports when a tick applied
+// new input and when a frame was presented; one frame gives one sample, measured from the
+// oldest input it shows. Keeps the last `history` samples.
+class LatencyTracker {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Stats {
+        size_t count;
+        double averageMilliseconds;
+        double p50Milliseconds;
+        double p95Milliseconds;
+        double p99Milliseconds;
+        double maximumMilliseconds;
+    };
+
+private:
+    std::vector<float> samples;
+    size_t cursor;
+    size_t count;
+    bool pending;
+    Clock::time_point pendingSince;
+    float lastMilliseconds;
+    // Reused by getStats(), so reading the statistics does not allocate.
+    mutable std::vector<float> sorted;
+
+public:
+    explicit LatencyTracker(size_t history = 4096);
+
+    // A tick applied input that arrived at `time`.
+    void inputApplied(Clock::time_point time);
+    // A frame was presented at `time`; it shows every input applied so far.
+    void framePresented(Clock::time_point time);
+    void clear();
+
+    // Latency of the last frame that showed new input.
+    float getLastMilliseconds() const {
+        return lastMilliseconds;
+    }
+
+    Stats getStats() const;
+};
@@ -0,0 +1,83 @@
+#include "live_input.h"
+
+#include <algorithm>
+
+LiveInput::LiveInput(const sf::Window& window)
+        : window(window), camera(nullptr), worldSize{0.0f, 0.0f}, fireHeld(false), firePressed(false), pending(false), last{{0.0f, 0.0f}, false},
+          lastMouse(0, 0), hasLast(false), changed(false) {}
+
+void LiveInput::setCamera(const sf::View* view, Vec2 world) {
+    camera = view;
+    worldSize = world;
+}
+
+void LiveInput::handleEvent(const sf::Event& event, Clock::time_point time) {
+    bool relevant = false;
+    switch (event.type) {
+        case sf::Event::MouseMoved:
+            relevant = true;
+            break;
+        case sf::Event::KeyPressed:
+            if (event.key.code == sf::Keyboard::Space) {
+                fireHeld = true;
+                firePressed = true;
+                relevant = true;
+            }
+            break;
+        case sf::Event::KeyReleased:
+            if (event.key.code == sf::Keyboard::Space) {
+                fireHeld = false;
+                relevant = true;
+            }
+            break;
+        case sf::Event::LostFocus:
+            // The release would go to another window.
+            fireHeld = false;
+            break;
+        default:
+            break;
+    }
+    if (relevant && !pending) {
+        pending = true;
+        pendingSince = time;
+    }
+}
+
+TickInput LiveInput::next(const Simulation&) {
+    return read();
+}
+
+TickInput LiveInput::read() {
+    Clock::time_point now = Clock::now();
+    sf::Vector2i mousePosition = sf::Mouse::getPosition(window);
+    TickInput input;
+    input.pointer = {static_cast<float>(mousePosition.x), static_cast<float>(mousePosition.y)};
+    if (camera != nullptr) {
+        sf::Vector2f size = camera->getSize();
+        sf::Vector2u windowSize = window.getSize();
+        float x = camera->getCenter().x + (input.pointer.x / windowSize.x - 0.5f) * size.x;
+        float y = camera->getCenter().y + (input.pointer.y / windowSize.y - 0.5f) * size.y;
+        input.pointer = {std::min(std::max(x, 0.0f), worldSize.x), std::min(std::max(y, 0.0f), worldSize.y)};
+    }
+    input.fire = fireHeld || firePressed;
+    firePressed = false;
+
+    // The mouse, not the pointer, since the pointer also moves with the camera.
+    changed = !hasLast || mousePosition != lastMouse || input.fire != last.fire;
+    if (changed) {
+        // A move without an event yet happened after the last poll, so it arrived just now.
+        changedSince = pending ? pendingSince : now;
+    }
+    pending = false;
+    last = input;
+    lastMouse = mousePosition;
+    hasLast = true;
+    return input;
+}
+
+bool LiveInput::getLastChange(Clock::time_point& time) const {
+    if (changed) {
+        time = changedSince;
+    }
+    return changed;
+}
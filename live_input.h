@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+
+#include <SFML/Graphics/View.hpp>
+#include <SFML/Window.hpp>
+
+#include "input_source.h"
+
+// The mouse (relative to the window) steers and Space fires. The game loop hands every event
+// to handleEvent() as it polls it, with the time it did so. next() reads the pointer once
+// more right before the tick, so each tick steers with the latest position. A Space press
+// fires for at least one tick, even if the key is released again before the tick comes.
+// With a camera the pointer is the world point under the mouse, kept inside the world.
+class LiveInput : public InputSource {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+private:
+    const sf::Window& window;
+    const sf::View* camera;
+    Vec2 worldSize;
+    bool fireHeld;
+    bool firePressed;
+    // The oldest event the next tick has not taken in yet.
+    bool pending;
+    Clock::time_point pendingSince;
+    TickInput last;
+    sf::Vector2i lastMouse;
+    bool hasLast;
+    bool changed;
+    Clock::time_point changedSince;
+
+public:
+    explicit LiveInput(const sf::Window& window);
+
+    // The view the world is drawn with, or nullptr for window coordinates; it has to outlive
+    // this object.
+    void setCamera(const sf::View* view, Vec2 world);
+
+    void handleEvent(const sf::Event& event, Clock::time_point time);
+    // The input of the next tick, for loops that do not step a Simulation themselves, such as
+    // the online client's; next() returns the same.
+    TickInput read();
+    TickInput next(const Simulation& simulation) override;
+
+    // True if the input the last read() or next() returned differs from the tick before, with
+    // the time the earliest part of the change reached the game.
+    bool getLastChange(Clock::time_point& time) const;
+};
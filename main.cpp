@@ -1,470 +1,789 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/System/Clock.hpp>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <random>
+#include <string>
+
+#include "alloc_tracker.h"
+#include "asset_manager.h"
+#include "asset_pack.h"
+#include "game_client.h"
+#include "game_clock.h"
+#include "hud.h"
+#include "input_log.h"
+#include "input_source.h"
+#include "job_system.h"
+#include "latency_tracker.h"
+#include "live_input.h"
+#include "particle_renderer.h"
+#include "particle_system.h"
+#include "profiler.h"
+#include "profiler_overlay.h"
+#include "render_stats.h"
+#include "score_store.h"
+#include "simulation.h"
+#include "state_interpolator.h"
+#include "sprite_batch.h"
+#include "texture_atlas.h"
+
+// Every game gets its own seed; it is stored in the replay, so the game can still be re-run.
+std::uint64_t newGameSeed() {
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32 | device()) ^ static_cast<std::uint64_t>(std::time(nullptr));
+}
+
+std::string formatLeaderboard(const ScoreStore& scores) {
+    std::string text = "Top scores";
+    const std::vector<ScoreEntry>& entries = scores.getLeaderboard();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        char date[32] = "-";
+        std::time_t timestamp = static_cast<std::time_t>(entries[i].timestamp);
+        if (timestamp != 0) {
+            std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M", std::localtime(&timestamp));
+        }
+        text += "\n" + std::to_string(i + 1) + ". " + std::to_string(entries[i].score) + "   " + date;
+    }
+    return text;
+}
+
+std::string formatSessionStats(const ScoreStore& scores) {
+    const ScoreStore::SessionStats& session = scores.getSessionStats();
+    long long average = session.games > 0 ? session.totalScore / session.games : 0;
+    return "This session: " + std::to_string(session.games) + " games, best " + std::to_string(session.bestScore) +
+           ", average " + std::to_string(average) + "\nAll time: " + std::to_string(scores.getLifetimeStats().games) +
+           " games";
+}
+
+sf::Vector2f toVector(const Vec2& value) {
+    return sf::Vector2f(value.x, value.y);
+}
 
 class Spaceship {
 private:
-    int lives;
-    sf::Sprite sprite;
-    sf::Texture texture;
-    sf::Texture hittedTexture;
-    sf::Texture projectileTexture;
-    bool textureChanged;
-    sf::Clock textureTimer;
-    sf::Clock projectileClock;
-    float currentRotation;
-    const float rotationSmoothing;
-    sf::Vector2i lastMousePosition;
+    const TextureAtlas& atlas;
+    int textureId;
+    int hittedTextureId;
+    int projectileTextureId;
 
 public:
-    Spaceship() : lives(3), currentRotation(0.0f), rotationSmoothing(0.05f), textureChanged(false) {
-        if (!texture.loadFromFile("C:\\KSE IT\\oop_game\\spacecraft.png")) {
-            throw std::runtime_error("Failed to load texture");
-        }
-        if (!hittedTexture.loadFromFile("C:\\KSE IT\\oop_game\\spacecraftHitted.png")) {
-            throw std::runtime_error("Failed to load hitted texture");
-        }
-        if (!projectileTexture.loadFromFile("C:\\KSE IT\\oop_game\\ball.png")){
-            throw std::runtime_error("Failed to load projectile texture");
-        }
-        sprite.setTexture(texture);
-        sprite.setOrigin(texture.getSize().x / 2.0f, texture.getSize().y / 2.0f);
-        sprite.setScale(0.10f, 0.10f);
-        lastMousePosition = sf::Mouse::getPosition();
+    // The cooked textures are already at their on-screen size, so sprites are drawn unscaled.
+    explicit Spaceship(const TextureAtlas& atlas)
+            : atlas(atlas),
+              textureId(atlas.find("spacecraft")),
+              hittedTextureId(atlas.find("spacecraftHitted")),
+              projectileTextureId(atlas.find("ball")) {}
+
+    Vec2 getSize() const {
+        sf::Vector2u size = atlas.getRegionSize(textureId);
+        return {static_cast<float>(size.x), static_cast<float>(size.y)};
+    }
+
+    Vec2 getProjectileSize() const {
+        sf::Vector2u size = atlas.getRegionSize(projectileTextureId);
+        return {static_cast<float>(size.x), static_cast<float>(size.y)};
+    }
+
+    void addShip(SpriteBatch& batch, Vec2 position, float rotation, bool hit) const {
+        int id = hit ? hittedTextureId : textureId;
+        sf::Vector2u size = atlas.getRegionSize(id);
+        batch.add(atlas.getRegion(id), toVector(position), sf::Vector2f(size.x / 2.0f, size.y / 2.0f), rotation,
+                  sf::Vector2f(1.0f, 1.0f));
+    }
+
+    void addProjectile(SpriteBatch& batch, Vec2 position, float rotation) const {
+        const sf::IntRect& region = atlas.getRegion(projectileTextureId);
+        batch.add(region, toVector(position), sf::Vector2f(region.width / 2.0f, region.height / 2.0f), rotation,
+                  sf::Vector2f(1.0f, 1.0f));
     }
 
-    void move(const sf::RenderWindow& window) {
-        sf::Vector2i currentMousePosition = sf::Mouse::getPosition(window);
-        sprite.setPosition(static_cast<float>(currentMousePosition.x), static_cast<float>(currentMousePosition.y));
+    void draw(SpriteBatch& batch, const Simulation& simulation, const StateInterpolator& state) const {
+        addShip(batch, state.getShipPosition(), state.getShipRotation(), simulation.isShipHit());
+    }
 
-        sf::Vector2f direction = static_cast<sf::Vector2f>(currentMousePosition - lastMousePosition);
-        if (direction.x != 0 || direction.y != 0) {
-            float targetAngle = std::atan2(direction.y, direction.x) * 180 / 3.14159f + 90;
-            float angleDifference = targetAngle - currentRotation;
-            angleDifference -= std::floor((angleDifference + 180) / 360) * 360;
-            currentRotation += angleDifference * rotationSmoothing;
-            sprite.setRotation(currentRotation);
+    void drawProjectiles(SpriteBatch& batch, const Simulation& simulation, const StateInterpolator& state) const {
+        const ProjectilePool& projectiles = simulation.getProjectiles();
+        for (size_t i = 0; i < projectiles.size(); ++i) {
+            addProjectile(batch, state.getProjectilePosition(i), projectiles[i].rotation);
         }
-        lastMousePosition = currentMousePosition;
     }
 
-    void blinkTextureForDuration() {
-        if (!textureChanged) {
-            textureChanged = true;
-            sprite.setTexture(hittedTexture);
+    // Only the projectiles that can be seen in the visible part of the world.
+    void drawProjectiles(SpriteBatch& batch, const Simulation& simulation, const StateInterpolator& state,
+                         const Bounds& visible) const {
+        const ProjectilePool& projectiles = simulation.getProjectiles();
+        Vec2 size = simulation.getConfig().projectileSize;
+        for (size_t i = 0; i < projectiles.size(); ++i) {
+            Vec2 position = state.getProjectilePosition(i);
+            if (visible.intersects({position.x - size.x, position.y - size.y, size.x * 2.0f, size.y * 2.0f})) {
+                addProjectile(batch, position, projectiles[i].rotation);
+            }
         }
     }
 
-    void blinkReversed(){
-        if (textureChanged){
-            sprite.setTexture(texture);
-            textureChanged = false;
+    // Ships and projectiles of a network game.
+    void draw(SpriteBatch& batch, const NetView& view) const {
+        for (const NetView::Ship& ship : view.ships) {
+            if (ship.lives > 0) {
+                addShip(batch, ship.position, ship.rotation, ship.hit);
+            }
+        }
+        for (const NetView::Projectile& projectile : view.projectiles) {
+            addProjectile(batch, projectile.position, projectile.rotation);
         }
     }
+};
 
-    std::vector<sf::Sprite> projectiles;
 
-    void shootProjectile() {
-        if (projectileClock.getElapsedTime().asSeconds() >= 0.3f) {
-            sf::Sprite projectile(projectileTexture);
+// A world of several screens: the ship's top speed, and how far past the edge of the view
+// meteors are still simulated every tick.
+const float worldShipSpeed = 1500.0f;
+const float awakeMargin = 512.0f;
 
-            projectile.setScale(0.08f, 0.08f);
+// How far a drawn meteor may be from where the broadphase has it, through interpolation.
+const float meteorCullMargin = 64.0f;
 
-            float scaleFactor = 0.1f;
-            sf::Vector2f noseOffset(std::sin(currentRotation * 3.14159f / 180) * sprite.getGlobalBounds().height * scaleFactor,
-                                    -std::cos(currentRotation * 3.14159f / 180) * sprite.getGlobalBounds().height * scaleFactor);
-            projectile.setPosition(sprite.getPosition() + noseOffset);
-            projectile.setRotation(currentRotation);
+class Asteroid {
+private:
+    const TextureAtlas& atlas;
+    int meteorTextureIds[Simulation::meteorStageCount];
+    std::vector<std::uint32_t> candidates;
 
-            projectiles.push_back(projectile);
-            projectileClock.restart();
+public:
+    explicit Asteroid(const TextureAtlas& atlas) : atlas(atlas) {
+        const char* names[Simulation::meteorStageCount] = {"meteor1", "meteor2", "meteor3"};
+        for (int stage = 0; stage < Simulation::meteorStageCount; ++stage) {
+            meteorTextureIds[stage] = atlas.find(names[stage]);
         }
     }
 
-    void updateProjectiles(const sf::RenderWindow& window) {
-        for (auto& projectile : projectiles) {
-            float angle = projectile.getRotation();
-            float speed = 2.0f;
-            projectile.move(std::sin(angle * 3.14159f / 180) * speed, -std::cos(angle * 3.14159f / 180) * speed);
-        }
-
-        projectiles.erase(
-                std::remove_if(
-                        projectiles.begin(),
-                        projectiles.end(),
-                        [&window](const sf::Sprite& projectile) {
-                            return projectile.getPosition().y < -projectile.getGlobalBounds().height ||
-                                   projectile.getPosition().y > window.getSize().y ||
-                                   projectile.getPosition().x < -projectile.getGlobalBounds().width ||
-                                   projectile.getPosition().x > window.getSize().x;
-                        }
-                ),
-                projectiles.end()
-        );
+    Vec2 getMeteorSize(int stage) const {
+        sf::Vector2u size = atlas.getRegionSize(meteorTextureIds[stage]);
+        return {static_cast<float>(size.x), static_cast<float>(size.y)};
     }
 
-    sf::Sprite& getSprite() {
-        return sprite;
+    void addMeteor(SpriteBatch& batch, Vec2 position, int stage, float scale) const {
+        batch.add(atlas.getRegion(meteorTextureIds[stage]), toVector(position), sf::Vector2f(0.0f, 0.0f), 0.0f,
+                  sf::Vector2f(scale, scale));
     }
 
-    int getLives() const{
-        return lives;
+    void draw(SpriteBatch& batch, const Simulation& simulation, const StateInterpolator& state) const {
+        const MeteorField& meteors = simulation.getMeteors();
+        for (size_t i = 0; i < meteors.size(); ++i) {
+            addMeteor(batch, state.getMeteorPosition(i), meteors.getStage(i), meteors.getScale(i));
+        }
     }
 
-    void setLives(int value){
-        lives = value;
+    // Only the meteors in the visible part of the world, found through the simulation's
+    // broadphase, so the cost follows what is on screen rather than the size of the world.
+    void draw(SpriteBatch& batch, const Simulation& simulation, const StateInterpolator& state,
+              const Bounds& visible) {
+        const MeteorField& meteors = simulation.getMeteors();
+        simulation.queryMeteors({visible.left - meteorCullMargin, visible.top - meteorCullMargin,
+                                 visible.width + meteorCullMargin * 2.0f, visible.height + meteorCullMargin * 2.0f},
+                                candidates);
+        size_t drawn = 0;
+        for (std::uint32_t i : candidates) {
+            Vec2 position = state.getMeteorPosition(i);
+            Bounds bounds = meteors.getBounds(i);
+            if (visible.intersects({position.x, position.y, bounds.width, bounds.height})) {
+                addMeteor(batch, position, meteors.getStage(i), meteors.getScale(i));
+                ++drawn;
+            }
+        }
+        PROFILE_COUNTER("meteorsDrawn", drawn);
     }
 
-    void decreaseLives() {
-        --lives;
+    void draw(SpriteBatch& batch, const NetView& view) const {
+        for (const NetView::Meteor& meteor : view.meteors) {
+            addMeteor(batch, meteor.position, meteor.stage, 1.0f);
+        }
     }
 };
 
-
-class ScoreManager {
+// Debris and sparks for meteor hits and ship damage. Debris is drawn with alpha blending,
+// sparks additively; each kind is one particle pool and one draw call.
+class Explosions {
 private:
-    int currentScore;
-    std::string filePath;
-    int highScore;
+    static const size_t debrisCapacity = 50000;
+    static const size_t sparkCapacity = 50000;
+
+    ParticleSystem debris;
+    ParticleSystem sparks;
+    ParticleRenderer debrisRenderer;
+    ParticleRenderer sparkRenderer;
+
+    void burst(ParticleSystem& system, Vec2 position, Vec2 velocity, int count, float radius, float speed,
+               float lifetime, float size, std::uint32_t color) {
+        system.emit({position, velocity, count, radius, speed * 0.25f, speed, lifetime * 0.5f, lifetime,
+                     size * 0.5f, size, color});
+    }
 
 public:
-    ScoreManager() : currentScore(0), filePath("C:\\KSE IT\\oop_game\\high_score.txt") {}
-
-    void saveHighScore() {
-        std::ofstream file(filePath);
-        if (file.is_open()) {
-            file << currentScore;
-            file.close();
+    Explosions()
+            : debris(debrisCapacity, 1.5f, 1),
+              sparks(sparkCapacity, 3.0f, 2),
+              debrisRenderer(debris, sf::BlendAlpha),
+              sparkRenderer(sparks, sf::BlendAdd) {}
+
+    void handle(const std::vector<SimEvent>& events) {
+        for (const SimEvent& event : events) {
+            // Later meteor stages are smaller, so they throw less debris.
+            float scale = 1.0f - 0.25f * event.stage;
+            switch (event.type) {
+                case SimEvent::Type::MeteorHit:
+                    burst(debris, event.position, event.velocity, static_cast<int>(60 * scale), 60.0f * scale, 90.0f,
+                          1.2f, 6.0f, 0x8a7a6aff);
+                    burst(sparks, event.position, event.velocity, 80, 20.0f, 220.0f, 0.4f, 4.0f, 0xffb347ff);
+                    break;
+                case SimEvent::Type::MeteorDestroyed:
+                    burst(debris, event.position, event.velocity, static_cast<int>(200 * scale), 100.0f * scale, 140.0f,
+                          1.8f, 8.0f, 0x8a7a6aff);
+                    burst(sparks, event.position, event.velocity, 300, 40.0f, 320.0f, 0.6f, 5.0f, 0xffa030ff);
+                    break;
+                case SimEvent::Type::ShipHit:
+                    burst(sparks, event.position, event.velocity, 250, 30.0f, 260.0f, 0.5f, 4.0f, 0x9cd8ffff);
+                    burst(debris, event.position, event.velocity, 60, 30.0f, 120.0f, 1.0f, 4.0f, 0xc0c0c8ff);
+                    break;
+            }
         }
     }
 
-    int loadHighScore() {
-        std::ifstream file(filePath);
-        int loadedHighScore = 0;
-        if (file.is_open()) {
-            file >> loadedHighScore;
-            file.close();
-        }
-        return loadedHighScore;
+    void update(float dt) {
+        debris.update(dt);
+        sparks.update(dt);
     }
 
-    void setScore(int value) {
-        currentScore += value;
+    void clear() {
+        debris.clear();
+        sparks.clear();
     }
 
-    void resetScore(){
-        currentScore = 0;
+    void draw(sf::RenderTarget& target, RenderStats* stats = nullptr) {
+        debrisRenderer.draw(target, debris, stats);
+        sparkRenderer.draw(target, sparks, stats);
     }
 
-    int getCurrentScore(){
-        return currentScore;
+    size_t getParticleCount() const {
+        return debris.getCount() + sparks.getCount();
     }
 };
 
+// Options of the offscreen render benchmark (--render-bench).
+struct RenderBenchmarkOptions {
+    int frames = 600;
+    int entities = 200;
+    // PNG frames are written here for golden-image comparison; empty writes none.
+    std::string dumpDirectory;
+};
 
-class Asteroid {
+class GameRendering{
 private:
-    float meteorSpawnInterval;
-    sf::Texture meteorTexture1;
-    sf::Texture meteorTexture2;
-    sf::Texture meteorTexture3;
+    // Who plays: the mouse and keyboard, the autopilot or a recorded game.
+    enum class Player {
+        Person,
+        Autopilot,
+        Recording
+    };
+
+    AssetPack assets;
+    std::string packPath = "assets.pack";
+    std::string fontPath = "zh-cn.ttf";
+    float frameRateLimit = 60.0f;
+    float tickRate = 60.0f;
+    Player player = Player::Person;
+    std::string recordingPath;
+    int worldScreens = 1;
+
+    void drawLoadingScreen(sf::RenderWindow& window, float progress) {
+        sf::Vector2f windowSize(static_cast<float>(window.getSize().x), static_cast<float>(window.getSize().y));
+        sf::RectangleShape frame(sf::Vector2f(windowSize.x * 0.4f, 12.0f));
+        frame.setPosition(windowSize.x * 0.3f, windowSize.y * 0.5f);
+        frame.setFillColor(sf::Color::Transparent);
+        frame.setOutlineColor(sf::Color::White);
+        frame.setOutlineThickness(2.0f);
+        sf::RectangleShape bar(sf::Vector2f(frame.getSize().x * progress, frame.getSize().y));
+        bar.setPosition(frame.getPosition());
+        bar.setFillColor(sf::Color::White);
+
+        window.clear();
+        window.draw(frame);
+        window.draw(bar);
+        window.display();
+    }
 
-public:
-    Asteroid() : meteorSpawnInterval(3.5f), currentMeteorSpawnTime(0.0f) {
-        if (!meteorTexture1.loadFromFile("C:\\KSE IT\\oop_game\\meteor1.png") ||
-            !meteorTexture2.loadFromFile("C:\\KSE IT\\oop_game\\meteor2.png") ||
-            !meteorTexture3.loadFromFile("C:\\KSE IT\\oop_game\\meteor3.png")) {
-            throw std::runtime_error("Failed to load texture");
+    void dumpProfile() {
+        Profiler& profiler = Profiler::get();
+        // Into the working directory, wherever the game is installed.
+        if (profiler.writeChromeTrace("profile.json") && profiler.writeCsv("profile.csv")) {
+            std::cout << "Profile written to profile.json and profile.csv" << std::endl;
+        } else {
+            std::cout << "Failed to write profile.json and profile.csv in the working directory" << std::endl;
+        }
+        // Debug builds count heap allocations too; list where they came from.
+        if (AllocationTracker::isInstalled()) {
+            std::vector<AllocationStageCounts> stages;
+            AllocationTracker::getStages(stages);
+            std::cout << "Heap allocations by stage:" << std::endl;
+            for (const auto& stage : stages) {
+                std::cout << "  " << stage.name << ": " << stage.counts.allocations << " (" << stage.counts.bytes
+                          << " bytes)" << std::endl;
+            }
         }
     }
 
-    const sf::Texture& getMeteorTexture1() const {
-        return meteorTexture1;
+    static double elapsedMicroseconds(std::chrono::steady_clock::time_point start,
+                                      std::chrono::steady_clock::time_point end) {
+        return std::chrono::duration<double, std::micro>(end - start).count();
     }
 
-    const sf::Texture& getMeteorTexture2() const {
-        return meteorTexture2;
+public:
+    // 0 lets the loop run as fast as it can, e.g. when vertical sync paces it.
+    void setFrameRateLimit(float framesPerSecond) {
+        frameRateLimit = framesPerSecond;
     }
 
-    const sf::Texture& getMeteorTexture3() const {
-        return meteorTexture3;
+    // Simulation steps per second. Projectile hits are swept over each step, so lower rates
+    // do not let shots pass through meteors.
+    void setTickRate(float ticksPerSecond) {
+        tickRate = std::max(1.0f, ticksPerSecond);
     }
 
+    // The autopilot plays instead of the mouse and keyboard.
+    void useAutopilot() {
+        player = Player::Autopilot;
+    }
 
-    void generate(const sf::RenderWindow& window) {
-        currentMeteorSpawnTime += 1.0f / 60;
-
-        if (currentMeteorSpawnTime >= meteorSpawnInterval) {
-            sf::Sprite meteor;
-            int randomMeteorType = std::rand() % 3 + 1;
-            switch (randomMeteorType) {
-                case 1:
-                    meteor.setTexture(meteorTexture1);
-                    break;
-                case 2:
-                    meteor.setTexture(meteorTexture2);
-                    break;
-                case 3:
-                    meteor.setTexture(meteorTexture3);
-                    break;
-            }
-
-            float spawnX, spawnY;
-            int side = std::rand() % 4;
-            switch (side) {
-                case 0:
-                    spawnX = static_cast<float>(std::rand() % window.getSize().x);
-                    spawnY = -static_cast<float>(meteor.getGlobalBounds().height);
-                    break;
-                case 1:
-                    spawnX = static_cast<float>(window.getSize().x);
-                    spawnY = static_cast<float>(std::rand() % window.getSize().y);
-                    break;
-                case 2:
-                    spawnX = static_cast<float>(std::rand() % window.getSize().x);
-                    spawnY = static_cast<float>(window.getSize().y);
-                    break;
-                case 3:
-                    spawnX = -static_cast<float>(meteor.getGlobalBounds().width);
-                    spawnY = static_cast<float>(std::rand() % window.getSize().y);
-                    break;
-            }
-
-            meteor.setPosition(spawnX, spawnY);
-
-            float directionX = static_cast<float>(std::rand() % 200 - 100);
-            float directionY = static_cast<float>(std::rand() % 200 - 100);
-
-            float length = std::sqrt(directionX * directionX + directionY * directionY);
-            if (length != 0) {
-                directionX /= length;
-                directionY /= length;
-            }
-
-            float meteorSpeed = static_cast<float>(std::rand() % 1 + 1) / 5.0f;
-            meteor.setScale(0.6f, 0.6f);
+    // The world is this many windows wide and high; beyond 1 the camera follows the ship, and
+    // meteors far from it are simulated coarsely.
+    void setWorldScreens(int screens) {
+        worldScreens = std::max(1, screens);
+    }
 
-            meteors.push_back(meteor);
-            meteorDirections.push_back(sf::Vector2f(directionX, directionY));
-            meteorSpeeds.push_back(meteorSpeed);
+    // Plays a recorded game back instead of taking input; every new game starts it over.
+    void watchRecording(const std::string& path) {
+        player = Player::Recording;
+        recordingPath = path;
+    }
 
-            currentMeteorSpawnTime = 0.0f;
-        }
+    // The cooked asset pack; a relative path is taken from the working directory.
+    void setPackPath(const std::string& path) {
+        packPath = path;
     }
 
-    void update(const sf::RenderWindow& window) {
-        for (size_t i = 0; i < meteors.size(); ++i) {
-            float meteorSpeed = meteorSpeeds[i];
-            sf::Vector2f direction = meteorDirections[i];
-            meteors[i].move(direction.x * meteorSpeed, direction.y * meteorSpeed);
-
-            if (meteors[i].getPosition().x < -meteors[i].getGlobalBounds().width ||
-                meteors[i].getPosition().y < -meteors[i].getGlobalBounds().height ||
-                meteors[i].getPosition().x > window.getSize().x ||
-                meteors[i].getPosition().y > window.getSize().y) {
-                meteors.erase(meteors.begin() + i);
-                meteorDirections.erase(meteorDirections.begin() + i);
-                meteorSpeeds.erase(meteorSpeeds.begin() + i);
-                --i;
-            }
-        }
+    // The HUD font file; a relative path is taken from the working directory.
+    void setFontPath(const std::string& path) {
+        fontPath = path;
     }
 
-    void draw(sf::RenderWindow& window) const {
-        for (const auto& meteor : meteors) {
-            window.draw(meteor);
+    void loadAssets() {
+        if (!assets.open(packPath)) {
+            throw std::runtime_error("Failed to open asset pack " + packPath);
         }
     }
+    void addCursor(sf::RenderWindow& window) {
+        const AssetPackTexture* cursorImage = assets.findTexture("cursor");
+        if (cursorImage == nullptr) {
+            throw std::runtime_error("Failed to load texture");
+        }
 
-    const std::vector<sf::Sprite>& getMeteors() const {
-        return meteors;
+        sf::Cursor cursor;
+        if (cursor.loadFromPixels(assets.getPixels(*cursorImage), sf::Vector2u(cursorImage->width, cursorImage->height),
+                                  sf::Vector2u(0, 0))) {
+            window.setMouseCursor(cursor);
+        } else {
+            throw std::runtime_error("Failed to load cursor");
+        }
     }
 
-    void removeMeteor(size_t index) {
-        if (index < meteors.size()) {
-            meteors.erase(meteors.begin() + index);
-            meteorDirections.erase(meteorDirections.begin() + index);
-            meteorSpeeds.erase(meteorSpeeds.begin() + index);
+    // Draws a scripted scene into an sf::RenderTexture instead of a window, so rendering can
+    // be measured without a display, e.g. on CI machines with only a software GL driver.
+    // The scene keeps `entities` meteors and projectiles in play with one fixed tick per
+    // frame and a fixed seed, so every run draws the same frames. Prints the CPU time of a
+    // frame and of its meteor, projectile and HUD parts, and the draw calls and vertices
+    // submitted per frame.
+    void runRenderBenchmark(const RenderBenchmarkOptions& options) {
+        const unsigned width = 1920;
+        const unsigned height = 1080;
+        const float dt = 1.0f / 60;
+        sf::RenderTexture target;
+        if (!target.create(width, height)) {
+            throw std::runtime_error("Failed to create render texture");
         }
-    }
 
-    std::vector<sf::Sprite> meteors;
-    std::vector<sf::Vector2f> meteorDirections;
-    std::vector<float> meteorSpeeds;
-    float currentMeteorSpawnTime;
-};
+        AssetManager assetManager(assets);
+        AssetManager::TextureHandle gameplayTexture = assetManager.requestTexture("gameplay");
+        AssetManager::TextureHandle backgroundTexture = assetManager.requestTexture("background");
+        AssetManager::FontHandle fontHandle = assetManager.requestFont(fontPath);
+        while (!assetManager.isAllReady()) {
+            assetManager.update();
+            sf::sleep(sf::milliseconds(1));
+        }
 
-class GameManager {
-    sf::Clock textureTimer;
-public:
-    void checkCollisions(Spaceship& spaceship, Asteroid& asteroid, ScoreManager& scoreManager) {
-        sf::Sprite shipSprite = spaceship.getSprite();
-        sf::FloatRect shipBounds = shipSprite.getGlobalBounds();
-
-        for (size_t i = 0; i < asteroid.getMeteors().size(); ++i) {
-            sf::Sprite meteor = asteroid.getMeteors()[i];
-            sf::FloatRect meteorBounds = meteor.getGlobalBounds();
-
-            if (shipBounds.intersects(meteorBounds)) {
-                spaceship.decreaseLives();
-                if (spaceship.getLives() <= 0){
-                    gameOver = true;
-                    break;
+        TextureAtlas atlas;
+        atlas.loadRegions(assets, "gameplay");
+        Spaceship spaceship(atlas);
+        Asteroid asteroid(atlas);
+        SpriteBatch batch;
+        Explosions explosions;
+        sf::Sprite background(assetManager.get(backgroundTexture));
+
+        SimConfig config;
+        config.fieldWidth = static_cast<float>(width);
+        config.fieldHeight = static_cast<float>(height);
+        config.startLives = 1 << 30;
+        config.meteorSpawnInterval = 1.0e9f;
+        config.projectileCapacity = std::max<size_t>(config.projectileCapacity, options.entities);
+        config.shipSize = spaceship.getSize();
+        config.projectileSize = spaceship.getProjectileSize();
+        for (int stage = 0; stage < Simulation::meteorStageCount; ++stage) {
+            config.meteorSizes[stage] = asteroid.getMeteorSize(stage);
+        }
+        Simulation simulation(config);
+        simulation.setSpriteMasks(loadSpriteMasks(assets));
+        StateInterpolator interpolator(simulation);
+        interpolator.setAlpha(1.0f);
+
+        Hud hud;
+        hud.setFont(assetManager.get(fontHandle));
+        hud.layout(sf::Vector2f(static_cast<float>(width), static_cast<float>(height)));
+        int scoreCounter = hud.addCounter("Your score: ", 24, sf::Color::White, Hud::Anchor::TopLeft, sf::Vector2f(0, 0));
+        int livesCounter = hud.addCounter("Lives: ", 24, sf::Color::White, Hud::Anchor::TopRight, sf::Vector2f(0, 0));
+
+        // Half the load is meteors drifting across the field, half projectiles fired from
+        // the ship in all directions; both are topped up as they are destroyed or leave.
+        Rng random(1);
+        size_t meteorTarget = static_cast<size_t>(options.entities) / 2;
+        size_t projectileTarget = static_cast<size_t>(options.entities) - meteorTarget;
+        TickInput input = {{0.0f, 0.0f}, false};
+
+        std::vector<double> frameMicroseconds;
+        double meteorMicroseconds = 0.0;
+        double projectileMicroseconds = 0.0;
+        double hudMicroseconds = 0.0;
+        double particles = 0.0;
+        RenderStats total;
+        for (int frame = 0; frame < options.frames; ++frame) {
+            while (simulation.getMeteors().size() < meteorTarget) {
+                int stage = random.nextInt(Simulation::meteorStageCount);
+                float angle = random.nextFloat() * 6.2831853f;
+                simulation.spawnMeteor({random.nextFloat() * config.fieldWidth, random.nextFloat() * config.fieldHeight},
+                                       {std::cos(angle) * 40.0f, std::sin(angle) * 40.0f}, stage);
+            }
+            while (simulation.getProjectiles().size() < projectileTarget) {
+                float angle = random.nextFloat() * 360.0f;
+                float radians = angle * 3.14159f / 180;
+                Vec2 direction = {std::cos(radians), std::sin(radians)};
+                simulation.spawnProjectile({simulation.getShip().position,
+                                            {direction.x * config.projectileSpeed, direction.y * config.projectileSpeed},
+                                            angle});
+            }
+            float pointerAngle = frame * 0.05f;
+            input.pointer = {config.fieldWidth / 2.0f + std::cos(pointerAngle) * 200.0f,
+                             config.fieldHeight / 2.0f + std::sin(pointerAngle) * 200.0f};
+            interpolator.capture();
+            simulation.step(dt, input);
+            explosions.handle(simulation.getEvents());
+            explosions.update(dt);
+
+            RenderStats stats;
+            auto start = std::chrono::steady_clock::now();
+            target.clear();
+            target.draw(background);
+            stats.add(4);
+            batch.clear();
+            spaceship.draw(batch, simulation, interpolator);
+            auto meteorsStart = std::chrono::steady_clock::now();
+            asteroid.draw(batch, simulation, interpolator);
+            auto projectilesStart = std::chrono::steady_clock::now();
+            spaceship.drawProjectiles(batch, simulation, interpolator);
+            auto projectilesEnd = std::chrono::steady_clock::now();
+            batch.draw(target, assetManager.get(gameplayTexture), &stats);
+            explosions.draw(target, &stats);
+            auto hudStart = std::chrono::steady_clock::now();
+            hud.setValue(scoreCounter, simulation.getScore());
+            hud.setValue(livesCounter, simulation.getShip().lives);
+            hud.draw(target, &stats);
+            auto hudEnd = std::chrono::steady_clock::now();
+            target.display();
+            auto end = std::chrono::steady_clock::now();
+
+            frameMicroseconds.push_back(elapsedMicroseconds(start, end));
+            meteorMicroseconds += elapsedMicroseconds(meteorsStart, projectilesStart);
+            projectileMicroseconds += elapsedMicroseconds(projectilesStart, projectilesEnd);
+            hudMicroseconds += elapsedMicroseconds(hudStart, hudEnd);
+            particles += explosions.getParticleCount();
+            total.drawCalls += stats.drawCalls;
+            total.vertices += stats.vertices;
+
+            if (!options.dumpDirectory.empty()) {
+                char name[32];
+                std::snprintf(name, sizeof(name), "/frame_%04d.png", frame);
+                if (!target.getTexture().copyToImage().saveToFile(options.dumpDirectory + name)) {
+                    throw std::runtime_error("Failed to write " + options.dumpDirectory + name);
                 }
-                spaceship.blinkTextureForDuration();
-                textureTimer.restart();
-                asteroid.removeMeteor(i);
             }
         }
-    }
 
-    void setTextureBack(Spaceship& spaceship){
-        if (textureTimer.getElapsedTime().asSeconds() >= 0.1f) {
-            spaceship.blinkReversed();
+        if (frameMicroseconds.empty()) {
+            return;
         }
+        double frames = static_cast<double>(frameMicroseconds.size());
+        double sum = 0.0;
+        for (double value : frameMicroseconds) {
+            sum += value;
+        }
+        std::sort(frameMicroseconds.begin(), frameMicroseconds.end());
+        auto percentile = [&frameMicroseconds](double fraction) {
+            return frameMicroseconds[static_cast<size_t>(fraction * (frameMicroseconds.size() - 1))];
+        };
+        std::printf("render benchmark: %d frames, %d entities, %.0f particles on average\n", options.frames,
+                    options.entities, particles / frames);
+        std::printf("frame CPU us: average %.1f, p50 %.1f, p99 %.1f, max %.1f\n", sum / frames, percentile(0.5),
+                    percentile(0.99), frameMicroseconds.back());
+        std::printf("per frame: meteors %.1f us, projectiles %.1f us, HUD %.1f us\n", meteorMicroseconds / frames,
+                    projectileMicroseconds / frames, hudMicroseconds / frames);
+        std::printf("per frame: %.1f draw calls, %.0f vertices\n", total.drawCalls / frames, total.vertices / frames);
     }
 
-    bool getGameStatus(){
-        return gameOver;
-    }
-
-    void checkProjectileCollisions(Spaceship& spaceship, Asteroid& asteroid, ScoreManager& scoreManager) {
-        for (size_t i = 0; i < spaceship.projectiles.size(); ) {
-            const sf::Sprite& projectile = spaceship.projectiles[i];
-            sf::FloatRect projectileBounds = projectile.getGlobalBounds();
+    // Joins a multiplayer game run by oop_game_server. The client only draws what the server
+    // sends: its own ship is predicted, everything else trails the server slightly; see
+    // GameClient. Effects are not shown, since the client does not get the game's events.
+    void playOnline(sf::RenderWindow& window, const sf::IpAddress& address, unsigned short port,
+                    const NetConditions& conditions) {
+        AssetManager assetManager(assets);
+        AssetManager::TextureHandle gameplayTexture = assetManager.requestTexture("gameplay");
+        AssetManager::TextureHandle backgroundTexture = assetManager.requestTexture("background");
+        AssetManager::FontHandle fontHandle = assetManager.requestFont(fontPath);
+        while (window.isOpen() && !assetManager.isAllReady()) {
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed) {
+                    window.close();
+                }
+            }
+            assetManager.update();
+            drawLoadingScreen(window, assetManager.getProgress());
+        }
+        if (!window.isOpen()) {
+            return;
+        }
 
-            bool hit = false;
-            for (size_t j = 0; j < asteroid.getMeteors().size() && !hit; ++j) {
-                sf::Sprite& meteor = const_cast<sf::Sprite &>(asteroid.getMeteors()[j]);
-                sf::FloatRect meteorBounds = meteor.getGlobalBounds();
+        TextureAtlas atlas;
+        atlas.loadRegions(assets, "gameplay");
+        Spaceship spaceship(atlas);
+        Asteroid asteroid(atlas);
+        SpriteBatch batch;
+        sf::Sprite background(assetManager.get(backgroundTexture));
+        GameClient client(address, port, conditions, newGameSeed());
+        GameClock gameClock(static_cast<float>(netTickRate));
+        gameClock.setFrameRateLimit(frameRateLimit);
+        NetView view;
+        LiveInput liveInput(window);
+        LatencyTracker latency;
+
+        Hud hud;
+        hud.setFont(assetManager.get(fontHandle));
+        hud.layout(window.getView().getSize());
+        int scoreCounter = hud.addCounter("Team score: ", 24, sf::Color::White, Hud::Anchor::TopLeft, sf::Vector2f(0, 0));
+        int livesCounter = hud.addCounter("Lives: ", 24, sf::Color::White, Hud::Anchor::TopRight, sf::Vector2f(0, 0));
+        int status = hud.addText("", 24, sf::Color::White, Hud::Anchor::TopLeft, sf::Vector2f(0, 30));
+        int pingCounter = hud.addCounter("Ping: ", 20, sf::Color::White, Hud::Anchor::TopRight, sf::Vector2f(0, 30));
+        std::string server = address.toString() + ":" + std::to_string(port);
+        int shownStatus = -1;
 
-                if (projectileBounds.intersects(meteorBounds)) {
-                    const sf::Texture* tex = meteor.getTexture();
-                    if (tex == &asteroid.getMeteorTexture1()) {
-                        meteor.setTexture(asteroid.getMeteorTexture2(), true);
-                        scoreManager.setScore(3);
-                    } else if (tex == &asteroid.getMeteorTexture2()) {
-                        meteor.setTexture(asteroid.getMeteorTexture3(), true);
-                        scoreManager.setScore(2);
-                    } else if (tex == &asteroid.getMeteorTexture3()) {
-                        asteroid.removeMeteor(j);
-                        scoreManager.setScore(1);
-                        hit = true;
-                    }
+        while (window.isOpen()) {
+            gameClock.beginFrame();
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                liveInput.handleEvent(event, LiveInput::Clock::now());
+                if (event.type == sf::Event::Closed) {
+                    window.close();
+                }
+            }
 
-                    spaceship.projectiles.erase(spaceship.projectiles.begin() + i);
+            client.poll();
+            while (gameClock.tick()) {
+                // Read right before each tick, so every input sent is as fresh as it can be.
+                TickInput input = liveInput.read();
+                LiveInput::Clock::time_point inputTime;
+                if (liveInput.getLastChange(inputTime)) {
+                    latency.inputApplied(inputTime);
                 }
+                client.tick(input);
             }
+            client.buildView(gameClock.getAlpha(), view);
 
-            if (!hit) {
-                ++i;
+            RenderStats frameStats;
+            window.clear();
+            window.draw(background);
+            batch.clear();
+            spaceship.draw(batch, view);
+            asteroid.draw(batch, view);
+            batch.draw(window, assetManager.get(gameplayTexture), &frameStats);
+
+            // Rebuilt only when it changes, so steady play does not allocate for it.
+            int statusKey = static_cast<int>(client.getState()) * 4 + (client.hasSnapshot() ? 1 : 0) +
+                            (view.gameOver ? 2 : 0);
+            if (statusKey != shownStatus) {
+                shownStatus = statusKey;
+                std::string text;
+                switch (client.getState()) {
+                    case GameClient::State::Connecting:
+                        text = "Connecting to " + server;
+                        break;
+                    case GameClient::State::Playing:
+                        if (!client.hasSnapshot()) {
+                            text = "Player " + std::to_string(client.getPlayerIndex() + 1) + ", waiting for the others";
+                        } else if (view.gameOver) {
+                            text = "Game over";
+                        } else {
+                            text = "Player " + std::to_string(client.getPlayerIndex() + 1);
+                        }
+                        break;
+                    case GameClient::State::Rejected:
+                        text = "The game on " + server + " is full";
+                        break;
+                    case GameClient::State::Disconnected:
+                        text = "Disconnected from " + server;
+                        break;
+                }
+                hud.setText(status, text);
             }
+            bool playing = client.hasSnapshot() && static_cast<size_t>(view.playerIndex) < view.ships.size();
+            hud.setValue(scoreCounter, view.score);
+            hud.setValue(livesCounter, playing ? view.ships[view.playerIndex].lives : 0);
+            hud.setValue(pingCounter, static_cast<int>(client.getRoundTripMilliseconds() + 0.5f));
+            hud.setVisible(scoreCounter, playing);
+            hud.setVisible(livesCounter, playing);
+            hud.setVisible(pingCounter, playing);
+            hud.draw(window, &frameStats);
+            window.display();
+            // The own ship is predicted, so the frame shows the input without a round trip.
+            latency.framePresented(LatencyTracker::Clock::now());
+            gameClock.endFrame();
+        }
+        client.disconnect();
+        LatencyTracker::Stats latencyStats = latency.getStats();
+        if (latencyStats.count > 0) {
+            std::printf("input to display latency over %zu frames: average %.1f ms, p50 %.1f, p95 %.1f, p99 %.1f, "
+                        "max %.1f\n", latencyStats.count, latencyStats.averageMilliseconds,
+                        latencyStats.p50Milliseconds, latencyStats.p95Milliseconds, latencyStats.p99Milliseconds,
+                        latencyStats.maximumMilliseconds);
         }
     }
 
-    bool gameOver = false;
-};
+    void renderGame(sf::RenderWindow& window) {
+        // The menu's assets are requested first so it can be shown while the gameplay ones
+        // are still streaming in.
+        AssetManager assetManager(assets);
+        AssetManager::TextureHandle mainMenuBackgroundTexture = assetManager.requestTexture("mainpage");
+        AssetManager::TextureHandle buttonTexture = assetManager.requestTexture("startgame");
+        AssetManager::FontHandle fontHandle = assetManager.requestFont(fontPath);
+        AssetManager::TextureHandle gameplayTexture = assetManager.requestTexture("gameplay");
+        AssetManager::TextureHandle gameBackgroundTexture = assetManager.requestTexture("background");
+        AssetManager::TextureHandle gameOverTexture = assetManager.requestTexture("gameover");
+
+        TextureAtlas atlas;
+        atlas.loadRegions(assets, "gameplay");
+        Spaceship spaceship(atlas);
+        Asteroid asteroid(atlas);
+        SpriteBatch batch;
+        Explosions explosions;
+
+        LiveInput liveInput(window);
+        LatencyTracker latency;
+        Autopilot autopilot;
+        RecordedInput recording;
+        InputSource* inputSource = &liveInput;
+        if (player == Player::Autopilot) {
+            inputSource = &autopilot;
+        } else if (player == Player::Recording) {
+            if (!recording.open(recordingPath)) {
+                throw std::runtime_error("Failed to open " + recordingPath);
+            }
+            inputSource = &recording;
+        }
 
-class GameRendering{
-private:
-    sf::Font font;
-public:
-    void setFont() {
-        if (!font.loadFromFile("C:\\KSE IT\\oop_game\\zh-cn.ttf")) {
-            throw std::runtime_error("Failed to load font");
+        SimConfig config = gameSimConfig();
+        config.fieldWidth = static_cast<float>(window.getSize().x);
+        config.fieldHeight = static_cast<float>(window.getSize().y);
+        config.shipSize = spaceship.getSize();
+        config.projectileSize = spaceship.getProjectileSize();
+        for (int stage = 0; stage < Simulation::meteorStageCount; ++stage) {
+            config.meteorSizes[stage] = asteroid.getMeteorSize(stage);
         }
-    }
-    void addCursor(sf::RenderWindow& window) {
-        sf::Image cursorImage;
-        if (!cursorImage.loadFromFile("C:\\KSE IT\\sfml\\cursor.png")) {
-            throw std::runtime_error("Failed to load texture");
+        if (worldScreens > 1) {
+            config.fieldWidth *= worldScreens;
+            config.fieldHeight *= worldScreens;
+            // The same number of meteors per screen.
+            config.meteorSpawnInterval /= static_cast<float>(worldScreens * worldScreens);
+            config.shipSpeed = worldShipSpeed;
+            config.awakeDistance = std::max(window.getSize().x, window.getSize().y) / 2.0f + awakeMargin;
         }
-
-        sf::Cursor cursor;
-        if (cursor.loadFromPixels(cursorImage.getPixelsPtr(), cursorImage.getSize(), sf::Vector2u(0, 0))) {
-            window.setMouseCursor(cursor);
-        } else {
-            throw std::runtime_error("Failed to load cursor");
+        if (player == Player::Recording) {
+            config = toSimConfig(recording.getHeader());
         }
-    }
-
-    void scoreText(sf::RenderWindow& window, ScoreManager& scoreManager) {
-        int score = scoreManager.getCurrentScore();
-        sf::Text scoreText;
-        scoreText.setFont(font);
-        scoreText.setString("Your score: " + std::to_string(score));
-        scoreText.setCharacterSize(24);
-        scoreText.setFillColor(sf::Color::White);
-        scoreText.setPosition(10, 10);
-        window.draw(scoreText);
-    }
-
-    void livesText(sf::RenderWindow& window, Spaceship& spaceship) {
-        int lives = spaceship.getLives();
-        sf::Text livesText;
-        livesText.setFont(font);
-        livesText.setString("Lives: " + std::to_string(lives));
-        livesText.setCharacterSize(24);
-        livesText.setFillColor(sf::Color::White);
-        livesText.setPosition(1800, 10);
-        window.draw(livesText);
-    }
-    void renderGame(sf::RenderWindow& window) {
-        GameManager gameInterface;
-        Spaceship spaceship;
-        Asteroid asteroid;
-        ScoreManager scoreManager;
-        GameRendering manager;
-
-        sf::Texture mainMenuBackgroundTexture, buttonTexture, gameBackgroundTexture;
-        if (!mainMenuBackgroundTexture.loadFromFile("C:\\KSE IT\\sfml\\mainpage.jpg") ||
-            !buttonTexture.loadFromFile("C:\\KSE IT\\sfml\\startgame.png") ||
-            !gameBackgroundTexture.loadFromFile("C:\\KSE IT\\oop_game\\background.jpg")){
-            throw std::runtime_error("Failed to load texture");
+        // A world larger than the window is seen through a camera centred on the ship.
+        sf::View camera = window.getDefaultView();
+        bool scrolling = config.fieldWidth > window.getSize().x || config.fieldHeight > window.getSize().y;
+        if (scrolling) {
+            liveInput.setCamera(&camera, {config.fieldWidth, config.fieldHeight});
         }
-        sf::Texture gameOverTexture;
-        sf::Sprite gameOverSprite;
-        if (!gameOverTexture.loadFromFile("C:\\KSE IT\\sfml\\gameover.jpg")) {
-            throw std::runtime_error("Failed to load texture");
+        JobSystem jobs;
+        Simulation simulation(config);
+        simulation.setJobSystem(&jobs);
+        simulation.setSpriteMasks(loadSpriteMasks(assets));
+        if (player == Player::Recording && recording.getHeader().maskHash != simulation.getSpriteMaskHash()) {
+            std::cout << "The recording was made with other sprites, it will not play back the same" << std::endl;
         }
+        StateInterpolator interpolator(simulation);
+        // A recording plays back at the tick rate it was made with.
+        GameClock gameClock(player == Player::Recording ? 1.0f / recording.getHeader().tickSeconds : tickRate);
+        gameClock.setFrameRateLimit(frameRateLimit);
+        InputRecorder recorder;
 
-        sf::RectangleShape playAgainButton;
-        playAgainButton.setSize(sf::Vector2f(115.0f, 75.0f)); // размер кнопки
-        playAgainButton.setFillColor(sf::Color::Transparent); // цвет кнопки
-        playAgainButton.setPosition(815.0f, 840.0f); // позиция кнопки
-
-        sf::RectangleShape exitButton;
-        exitButton.setSize(sf::Vector2f(115.0f, 75.0f));
-        exitButton.setFillColor(sf::Color::Transparent);
-        exitButton.setPosition(1000.0f, 840.0f);
+        sf::Sprite gameOverSprite;
 
-        gameOverSprite.setTexture(gameOverTexture);
         gameOverSprite.setColor(sf::Color(255, 255, 255, 0)); // Изначально спрайт полностью прозрачен
         gameOverSprite.setPosition(0, 0);
 
-        sf::Sprite mainMenuBackground(mainMenuBackgroundTexture);
-        sf::Sprite background(gameBackgroundTexture);
-        sf::Sprite button(buttonTexture);
-        button.setPosition(780.0f, 405.0f);
-        sf::Vector2u buttonTextureSize = buttonTexture.getSize();
-        float scaleX = 370.0f / buttonTextureSize.x;
-        float scaleY = 140.0f / buttonTextureSize.y;
-        button.setScale(scaleX, scaleY);
-
-        int highScore = scoreManager.loadHighScore();
-        sf::Text highestScore;
-        highestScore.setFont(font);
+        sf::Sprite mainMenuBackground;
+        sf::Sprite background;
+        sf::Sprite button;
+
+        // Loading reads a fixed-size file; saves after each game happen on the store's own thread.
+        ScoreStore scores("C:\\KSE IT\\oop_game\\scores.dat");
+        scores.importHighScore("C:\\KSE IT\\oop_game\\high_score.txt");
+        int highScore = scores.getHighScore();
+        bool scoreSubmitted = false;
+        bool newHighScore = false;
         std::string hexColor = "#25335a";
         unsigned int rgb = std::stoul(hexColor.erase(0, 1), nullptr, 16); // Convert hex to integer
         sf::Color customColor((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
-        highestScore.setString("Highest score\n         " + std::to_string(highScore));
-        highestScore.setCharacterSize(28);
-        highestScore.setFillColor(customColor);
-        highestScore.setPosition(865, 735);
+
+        // Menu and game-over positions are in the coordinates of the 1920x1080 artwork.
+        Hud hud;
+        hud.layout(window.getView().getSize());
+        int scoreCounter = hud.addCounter("Your score: ", 24, sf::Color::White, Hud::Anchor::TopLeft, sf::Vector2f(0, 0));
+        int livesCounter = hud.addCounter("Lives: ", 24, sf::Color::White, Hud::Anchor::TopRight, sf::Vector2f(0, 0));
+        int menuHighScore = hud.addCounter("Highest score\n         ", 28, customColor, Hud::Anchor::Artwork, sf::Vector2f(865, 735));
+        int finalScore = hud.addCounter("", 24, sf::Color::White, Hud::Anchor::Artwork, sf::Vector2f(880, 650));
+        int finalHighScore = hud.addCounter("", 24, sf::Color::White, Hud::Anchor::Artwork, sf::Vector2f(1025, 650));
+        int newRecord = hud.addText("New highest score!", 24, sf::Color::White, Hud::Anchor::Artwork, sf::Vector2f(850, 680));
+        int leaderboard = hud.addText(formatLeaderboard(scores), 20, sf::Color::White, Hud::Anchor::TopRight, sf::Vector2f(0, 0));
+        int sessionStats = hud.addText("", 20, sf::Color::White, Hud::Anchor::TopLeft, sf::Vector2f(0, 0));
+        int startButton = hud.addButton(sf::FloatRect(780, 405, 370, 140));
+        int playAgainButton = hud.addButton(sf::FloatRect(815, 840, 115, 75));
+        int exitButton = hud.addButton(sf::FloatRect(1000, 840, 115, 75));
+        ProfilerOverlay profilerOverlay;
 
         bool gameStarted = false;
         bool inTransition = false;
@@ -472,140 +791,312 @@ public:
         float currentTransitionTime = 0.0f;
         float gameOverFadeInTime = 3.0f;
         float gameOverFadeInTimer = 0.0f;
-        setFont();
+        bool menuReady = false;
+        bool gameplayReady = false;
+        // The input of the current game is logged so it can be replayed with oop_game_replay.
+        auto newGame = [&]() {
+            recorder.close(simulation);
+            if (player == Player::Recording) {
+                recording.open(recordingPath);
+                simulation.reset(recording.getHeader().seed);
+            } else {
+                simulation.reset(newGameSeed());
+                autopilot = Autopilot(simulation.getSeed());
+            }
+            interpolator.clear();
+            explosions.clear();
+            scoreSubmitted = false;
+            newHighScore = false;
+            if (player != Player::Recording &&
+                !recorder.open("C:\\KSE IT\\oop_game\\last_game.replay", simulation, gameClock.getTickSeconds())) {
+                std::cout << "Failed to open last_game.replay, the game is not recorded" << std::endl;
+            }
+        };
         auto restartGame = [&]() {
-            scoreManager.resetScore();
-            spaceship.setLives(3);
-            asteroid.meteors.clear();
-            spaceship.projectiles.clear();
-            asteroid.meteorDirections.clear();
-            asteroid.meteorSpeeds.clear();
+            newGame();
             gameStarted = true;
-            gameInterface.gameOver = false;
-            asteroid.currentMeteorSpawnTime = 0.0f;
             gameOverFadeInTime = 2.0f;
             gameOverFadeInTimer = 0.0f;
         };
 
         while (window.isOpen()) {
+            gameClock.beginFrame();
             sf::Event event;
             while (window.pollEvent(event)) {
+                liveInput.handleEvent(event, LiveInput::Clock::now());
                 if (event.type == sf::Event::Closed) {
                     window.close();
                 }
-                if (!gameStarted && !inTransition && event.type == sf::Event::MouseButtonPressed) {
-                    if (button.getGlobalBounds().contains(window.mapPixelToCoords(sf::Mouse::getPosition(window)))) {
+                // F3 shows the profiler overlay (and starts recording), F4 writes the recording out.
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                    profilerOverlay.setVisible(!profilerOverlay.isVisible());
+                    if (profilerOverlay.isVisible()) {
+                        Profiler::get().setEnabled(true);
+                    }
+                }
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4) {
+                    dumpProfile();
+                }
+                if (gameplayReady && !gameStarted && !inTransition && event.type == sf::Event::MouseButtonPressed) {
+                    sf::Vector2f point = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
+                    if (hud.isButtonAt(startButton, point)) {
                         inTransition = true;
+                        newGame();
+                    }
+                }
+                if (gameStarted && simulation.isGameOver() && event.type == sf::Event::MouseButtonPressed &&
+                    event.mouseButton.button == sf::Mouse::Left) {
+                    sf::Vector2f point = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
+                    if (hud.isButtonAt(playAgainButton, point)) {
+                        restartGame();
+                    } else if (hud.isButtonAt(exitButton, point)) {
+                        window.close();
                     }
                 }
             }
-            if (inTransition) {
-                currentTransitionTime += 1.0f / 60;
-                if (currentTransitionTime >= transitionTime) {
-                    inTransition = false;
-                    gameStarted = true;
-                    currentTransitionTime = transitionTime;
+            {
+                PROFILE_SCOPE("assets");
+                assetManager.update();
+            }
+            if (!menuReady && assetManager.isReady(mainMenuBackgroundTexture) &&
+                assetManager.isReady(buttonTexture) && assetManager.isReady(fontHandle)) {
+                mainMenuBackground.setTexture(assetManager.get(mainMenuBackgroundTexture));
+                button.setTexture(assetManager.get(buttonTexture));
+                const sf::FloatRect& buttonRect = hud.getButtonRect(startButton);
+                sf::Vector2u buttonTextureSize = assetManager.get(buttonTexture).getSize();
+                button.setPosition(buttonRect.left, buttonRect.top);
+                button.setScale(buttonRect.width / buttonTextureSize.x, buttonRect.height / buttonTextureSize.y);
+                hud.setFont(assetManager.get(fontHandle));
+                profilerOverlay.setFont(assetManager.get(fontHandle));
+                menuReady = true;
+            }
+            if (!gameplayReady && assetManager.isReady(gameplayTexture) &&
+                assetManager.isReady(gameBackgroundTexture) && assetManager.isReady(gameOverTexture)) {
+                background.setTexture(assetManager.get(gameBackgroundTexture));
+                gameOverSprite.setTexture(assetManager.get(gameOverTexture));
+                gameplayReady = true;
+            }
+            if (!menuReady) {
+                drawLoadingScreen(window, assetManager.getProgress());
+                gameClock.endFrame();
+                continue;
+            }
+
+            while (gameClock.tick()) {
+                float dt = gameClock.getTickSeconds();
+                if (inTransition) {
+                    currentTransitionTime += dt;
+                    if (currentTransitionTime >= transitionTime) {
+                        inTransition = false;
+                        gameStarted = true;
+                        currentTransitionTime = transitionTime;
+                    }
+                }
+                if (gameStarted || inTransition) {
+                    // The input source is asked once per tick, right before the step.
+                    TickInput input = inputSource->next(simulation);
+                    LiveInput::Clock::time_point inputTime;
+                    if (inputSource == &liveInput && liveInput.getLastChange(inputTime)) {
+                        latency.inputApplied(inputTime);
+                    }
+                    interpolator.capture();
+                    simulation.step(dt, input);
+                    recorder.record(input, simulation);
+                    explosions.handle(simulation.getEvents());
+                    explosions.update(dt);
+                    if (simulation.isGameOver()) {
+                        recorder.close(simulation);
+                        gameOverFadeInTimer += 0.5f * dt;
+                    }
+                    // Only games a person played go on the leaderboard.
+                    if (simulation.isGameOver() && !scoreSubmitted && player == Player::Person) {
+                        unsigned seconds = static_cast<unsigned>(simulation.getTickCount() * dt);
+                        newHighScore = scores.submit(simulation.getScore(), seconds) == 0;
+                        highScore = scores.getHighScore();
+                        hud.setText(leaderboard, formatLeaderboard(scores));
+                        hud.setText(sessionStats, formatSessionStats(scores));
+                        scoreSubmitted = true;
+                    }
                 }
             }
+            interpolator.setAlpha(gameClock.getAlpha());
+
             float alpha = currentTransitionTime / transitionTime;
             mainMenuBackground.setColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(255 * (1 - alpha))));
             background.setColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(255 * alpha)));
 
+            RenderStats frameStats;
             window.clear();
             if (!gameStarted || inTransition) {
                 window.draw(mainMenuBackground);
-                window.draw(highestScore);
                 if (!inTransition) {
+                    // Dimmed until the gameplay assets behind it have finished loading.
+                    button.setColor(gameplayReady ? sf::Color::White : sf::Color(255, 255, 255, 96));
                     window.draw(button);
                 }
             }
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
-                spaceship.shootProjectile();
-            }
             if (gameStarted || inTransition){
-                spaceship.move(window);
-                asteroid.update(window);
-                asteroid.generate(window);
-                gameInterface.checkCollisions(spaceship, asteroid, scoreManager);
-                gameInterface.setTextureBack(spaceship);
-                gameInterface.checkProjectileCollisions(spaceship, asteroid, scoreManager);
-                spaceship.updateProjectiles(window);
-
+                PROFILE_SCOPE("draw.world");
                 window.clear();
                 window.draw(background);
-                scoreText(window, scoreManager);
-                livesText(window, spaceship);
-                window.draw(spaceship.getSprite());
-                asteroid.draw(window);
-
-                for (const auto& projectile : spaceship.projectiles) {
-                    window.draw(projectile);
+                if (scrolling) {
+                    camera.setCenter(toVector(interpolator.getShipPosition()));
                 }
-                if (gameInterface.getGameStatus()){
-                    gameOverFadeInTimer += 0.5f / 60.0f;
+                sf::Vector2f cameraSize = camera.getSize();
+                Bounds visible = {camera.getCenter().x - cameraSize.x / 2.0f, camera.getCenter().y - cameraSize.y / 2.0f,
+                                  cameraSize.x, cameraSize.y};
+                window.setView(camera);
+                batch.clear();
+                spaceship.draw(batch, simulation, interpolator);
+                asteroid.draw(batch, simulation, interpolator, visible);
+                spaceship.drawProjectiles(batch, simulation, interpolator, visible);
+                batch.draw(window, assetManager.get(gameplayTexture), &frameStats);
+                PROFILE_COUNTER("sprites", batch.getSpriteCount());
+                explosions.draw(window, &frameStats);
+                PROFILE_COUNTER("particles", explosions.getParticleCount());
+                window.setView(window.getDefaultView());
+
+                if (simulation.isGameOver()){
                     float alpha = (gameOverFadeInTimer / gameOverFadeInTime) * 255.0f;
                     if (alpha > 255.0f) alpha = 255.0f;
                     gameOverSprite.setColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(alpha)));
                     window.clear();
-                    if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
-                        sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-
-                        if (playAgainButton.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos))) {
-                            restartGame();
-                        }
-                        if (exitButton.getGlobalBounds().contains(static_cast<sf::Vector2f>(mousePos))) {
-                            window.close();
-                        }
-                    }
-                    if (scoreManager.getCurrentScore() > highScore) {
-                        scoreManager.saveHighScore();
-                        highScore = scoreManager.getCurrentScore();
-                    }
                 }
             }
-            if (gameInterface.getGameStatus()) {
-                sf::Text scoreText;
-                scoreText.setFont(font);
-                scoreText.setString(std::to_string(scoreManager.getCurrentScore()));
-                scoreText.setCharacterSize(24);
-                scoreText.setFillColor(sf::Color::White);
-                scoreText.setPosition(880, 650);
-
-                sf::Text highestScore;
-                highestScore.setFont(font);
-                highestScore.setString(std::to_string(highScore));
-                highestScore.setCharacterSize(24);
-                highestScore.setFillColor(sf::Color::White);
-                highestScore.setPosition(1025, 650);
-
-                sf::Text newRec;
-                newRec.setFont(font);
-                newRec.setString("New highest score!");
-                newRec.setCharacterSize(24);
-                newRec.setFillColor(sf::Color::White);
-                newRec.setPosition(850, 680);
-
-
-
-                window.draw(playAgainButton);
-                window.draw(exitButton);
+            if (simulation.isGameOver()) {
                 window.draw(gameOverSprite);
-                window.draw(scoreText);
-                window.draw(highestScore);
-                if (scoreManager.getCurrentScore() == highScore) {
-                    window.draw(newRec);
-                }
             }
-            window.display();
+
+            bool playing = gameStarted || inTransition;
+            bool gameOver = playing && simulation.isGameOver();
+            hud.setValue(scoreCounter, simulation.getScore());
+            hud.setValue(livesCounter, simulation.getShip().lives);
+            hud.setValue(menuHighScore, highScore);
+            hud.setValue(finalScore, simulation.getScore());
+            hud.setValue(finalHighScore, highScore);
+            hud.setVisible(menuHighScore, !gameStarted || inTransition);
+            hud.setVisible(scoreCounter, playing && !gameOver);
+            hud.setVisible(livesCounter, playing && !gameOver);
+            hud.setVisible(finalScore, gameOver);
+            hud.setVisible(finalHighScore, gameOver);
+            hud.setVisible(newRecord, gameOver && newHighScore);
+            hud.setVisible(leaderboard, (!gameStarted && !inTransition) || gameOver);
+            hud.setVisible(sessionStats, gameOver);
+            {
+                PROFILE_SCOPE("draw.hud");
+                hud.draw(window, &frameStats);
+                profilerOverlay.draw(window);
+            }
+            PROFILE_COUNTER("drawCalls", frameStats.drawCalls);
+            PROFILE_COUNTER("vertices", frameStats.vertices);
+            {
+                PROFILE_SCOPE("display");
+                window.display();
+            }
+            latency.framePresented(LatencyTracker::Clock::now());
+            PROFILE_COUNTER("inputLatencyUs", latency.getLastMilliseconds() * 1000.0f);
+            gameClock.endFrame();
+            if (AllocationTracker::isInstalled()) {
+                PROFILE_COUNTER("allocations", AllocationTracker::endFrame().allocations);
+            }
+            Profiler::get().endFrame();
+            profilerOverlay.update(window.getView().getSize());
+        }
+        recorder.close(simulation);
+        LatencyTracker::Stats latencyStats = latency.getStats();
+        if (latencyStats.count > 0) {
+            std::printf("input to display latency over %zu frames: average %.1f ms, p50 %.1f, p95 %.1f, p99 %.1f, "
+                        "max %.1f\n", latencyStats.count, latencyStats.averageMilliseconds,
+                        latencyStats.p50Milliseconds, latencyStats.p95Milliseconds, latencyStats.p99Milliseconds,
+                        latencyStats.maximumMilliseconds);
+        }
+        if (Profiler::get().isEnabled()) {
+            dumpProfile();
         }
     }
 
 };
 
-int main() {
-    sf::RenderWindow window(sf::VideoMode(1920, 1080), "Asteroid");
+int main(int argc, char* argv[]) {
+    // --profile records from the first frame and writes the profile when the game closes.
+    // --fps <n> caps the frame rate (0 = uncapped, default 60); --vsync paces by the display instead.
+    // --render-bench <frames> draws a scripted scene offscreen instead of opening a window, with
+    // --entities <n> meteors and projectiles (default 200); --dump-frames <dir> saves each frame.
+    // --connect <host>[:<port>] joins an oop_game_server game; --latency <ms>, --jitter <ms> and
+    // --loss <percent> delay and drop the packets this client sends.
+    // --bot lets the autopilot play; --watch <log> plays a recorded game back.
+    // --world <n> makes the world n windows wide and high, scrolled with the ship.
+    // --tick-rate <hz> sets the simulation steps per second (default 60).
+    // --pack <file> and --font <file> read the assets from another pack than assets.pack and the
+    // font from another file than zh-cn.ttf, both in the working directory by default.
     GameRendering gameManager;
+    bool verticalSync = false;
+    bool renderBenchmark = false;
+    RenderBenchmarkOptions benchmarkOptions;
+    std::string serverAddress;
+    NetConditions conditions;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--profile") {
+            Profiler::get().setEnabled(true);
+        } else if (argument == "--fps" && i + 1 < argc) {
+            gameManager.setFrameRateLimit(std::stof(argv[++i]));
+        } else if (argument == "--vsync") {
+            verticalSync = true;
+            gameManager.setFrameRateLimit(0.0f);
+        } else if (argument == "--render-bench" && i + 1 < argc) {
+            renderBenchmark = true;
+            benchmarkOptions.frames = std::stoi(argv[++i]);
+        } else if (argument == "--entities" && i + 1 < argc) {
+            benchmarkOptions.entities = std::stoi(argv[++i]);
+        } else if (argument == "--dump-frames" && i + 1 < argc) {
+            benchmarkOptions.dumpDirectory = argv[++i];
+        } else if (argument == "--bot") {
+            gameManager.useAutopilot();
+        } else if (argument == "--tick-rate" && i + 1 < argc) {
+            gameManager.setTickRate(std::stof(argv[++i]));
+        } else if (argument == "--world" && i + 1 < argc) {
+            gameManager.setWorldScreens(std::stoi(argv[++i]));
+        } else if (argument == "--watch" && i + 1 < argc) {
+            gameManager.watchRecording(argv[++i]);
+        } else if (argument == "--pack" && i + 1 < argc) {
+            gameManager.setPackPath(argv[++i]);
+        } else if (argument == "--font" && i + 1 < argc) {
+            gameManager.setFontPath(argv[++i]);
+        } else if (argument == "--connect" && i + 1 < argc) {
+            serverAddress = argv[++i];
+        } else if (argument == "--latency" && i + 1 < argc) {
+            conditions.latencyMilliseconds = std::stof(argv[++i]);
+        } else if (argument == "--jitter" && i + 1 < argc) {
+            conditions.jitterMilliseconds = std::stof(argv[++i]);
+        } else if (argument == "--loss" && i + 1 < argc) {
+            conditions.lossRate = std::stof(argv[++i]) / 100.0f;
+        }
+    }
+    if (renderBenchmark) {
+        gameManager.loadAssets();
+        gameManager.runRenderBenchmark(benchmarkOptions);
+        return 0;
+    }
+    sf::RenderWindow window(sf::VideoMode(1920, 1080), "Asteroid");
+    window.setVerticalSyncEnabled(verticalSync);
+    gameManager.loadAssets();
     gameManager.addCursor(window);
+    if (!serverAddress.empty()) {
+        unsigned short port = netDefaultPort;
+        size_t colon = serverAddress.find(':');
+        if (colon != std::string::npos) {
+            port = static_cast<unsigned short>(std::stoi(serverAddress.substr(colon + 1)));
+            serverAddress.erase(colon);
+        }
+        sf::IpAddress address(serverAddress);
+        if (address == sf::IpAddress::None) {
+            std::cout << "Failed to resolve " << serverAddress << std::endl;
+            return 1;
+        }
+        gameManager.playOnline(window, address, port, conditions);
+        return 0;
+    }
     gameManager.renderGame(window);
     return 0;
 }
@@ -0,0 +1,154 @@
+#include "meteor_field.h"
+
+#include <utility>
+
+void MeteorField::reserve(size_t capacity) {
+    positionX.reserve(capacity);
+    positionY.reserve(capacity);
+    velocityX.reserve(capacity);
+    velocityY.reserve(capacity);
+    scale.reserve(capacity);
+    width.reserve(capacity);
+    height.reserve(capacity);
+    stage.reserve(capacity);
+    movedTick.reserve(capacity);
+    indexToSlot.reserve(capacity);
+    slotToIndex.reserve(capacity);
+    slotGenerations.reserve(capacity);
+    freeSlots.reserve(capacity);
+}
+
+void MeteorField::clear() {
+    while (!empty()) {
+        remove(size() - 1);
+    }
+}
+
+MeteorHandle MeteorField::add(Vec2 position, Vec2 velocity, float meteorScale, int meteorStage, Vec2 size) {
+    std::uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<std::uint32_t>(slotToIndex.size());
+        slotToIndex.push_back(0);
+        slotGenerations.push_back(0);
+    }
+
+    slotToIndex[slot] = static_cast<std::uint32_t>(positionX.size());
+    indexToSlot.push_back(slot);
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    velocityX.push_back(velocity.x);
+    velocityY.push_back(velocity.y);
+    scale.push_back(meteorScale);
+    width.push_back(size.x * meteorScale);
+    height.push_back(size.y * meteorScale);
+    stage.push_back(meteorStage);
+    movedTick.push_back(0);
+
+    return {slot, slotGenerations[slot]};
+}
+
+void MeteorField::remove(size_t index) {
+    if (index >= size()) {
+        return;
+    }
+    std::uint32_t removedSlot = indexToSlot[index];
+    size_t last = size() - 1;
+    if (index != last) {
+        positionX[index] = positionX[last];
+        positionY[index] = positionY[last];
+        velocityX[index] = velocityX[last];
+        velocityY[index] = velocityY[last];
+        scale[index] = scale[last];
+        width[index] = width[last];
+        height[index] = height[last];
+        stage[index] = stage[last];
+        movedTick[index] = movedTick[last];
+        indexToSlot[index] = indexToSlot[last];
+        slotToIndex[indexToSlot[index]] = static_cast<std::uint32_t>(index);
+    }
+    positionX.pop_back();
+    positionY.pop_back();
+    velocityX.pop_back();
+    velocityY.pop_back();
+    scale.pop_back();
+    width.pop_back();
+    height.pop_back();
+    stage.pop_back();
+    movedTick.pop_back();
+    indexToSlot.pop_back();
+
+    ++slotGenerations[removedSlot];
+    freeSlots.push_back(removedSlot);
+}
+
+bool MeteorField::remove(MeteorHandle handle) {
+    if (!isAlive(handle)) {
+        return false;
+    }
+    remove(slotToIndex[handle.slot]);
+    return true;
+}
+
+void MeteorField::swap(size_t a, size_t b) {
+    if (a == b) {
+        return;
+    }
+    std::swap(positionX[a], positionX[b]);
+    std::swap(positionY[a], positionY[b]);
+    std::swap(velocityX[a], velocityX[b]);
+    std::swap(velocityY[a], velocityY[b]);
+    std::swap(scale[a], scale[b]);
+    std::swap(width[a], width[b]);
+    std::swap(height[a], height[b]);
+    std::swap(stage[a], stage[b]);
+    std::swap(movedTick[a], movedTick[b]);
+    std::swap(indexToSlot[a], indexToSlot[b]);
+    slotToIndex[indexToSlot[a]] = static_cast<std::uint32_t>(a);
+    slotToIndex[indexToSlot[b]] = static_cast<std::uint32_t>(b);
+}
+
+MeteorHandle MeteorField::getHandle(size_t index) const {
+    std::uint32_t slot = indexToSlot[index];
+    return {slot, slotGenerations[slot]};
+}
+
+bool MeteorField::isAlive(MeteorHandle handle) const {
+    return handle.slot < slotGenerations.size() && slotGenerations[handle.slot] == handle.generation;
+}
+
+size_t MeteorField::indexOf(MeteorHandle handle) const {
+    return isAlive(handle) ? slotToIndex[handle.slot] : size();
+}
+
+void MeteorField::integrate(float dt) {
+    integrate(dt, 0, size());
+}
+
+void MeteorField::integrate(float dt, size_t begin, size_t end) {
+    float* x = positionX.data();
+    float* y = positionY.data();
+    const float* vx = velocityX.data();
+    const float* vy = velocityY.data();
+    for (size_t i = begin; i < end; ++i) {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+void MeteorField::removeOutside(float fieldWidth, float fieldHeight) {
+    // Walk backwards so the meteor swapped into a hole has already been tested.
+    for (size_t i = size(); i-- > 0; ) {
+        if (isOutside(i, fieldWidth, fieldHeight)) {
+            remove(i);
+        }
+    }
+}
+
+void MeteorField::setStage(size_t index, int meteorStage, Vec2 size) {
+    stage[index] = meteorStage;
+    width[index] = size.x * scale[index];
+    height[index] = size.y * scale[index];
+}
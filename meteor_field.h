@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+// Handle that stays valid while its meteor is alive, even as other meteors are removed
+// and the packed arrays are reshuffled. A stale handle is detected by its generation.
+struct MeteorHandle {
+    std::uint32_t slot;
+    std::uint32_t generation;
+};
+
+// Packed structure-of-arrays meteor storage. Live meteors occupy indices [0, size()) of
+// every array; removal moves the last meteor into the hole, so it is O(1).
+class MeteorField {
+private:
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> scale;
+    std::vector<float> width;
+    std::vector<float> height;
+    std::vector<int> stage;
+    // Tick a meteor was last moved on, for meteors that are not moved every tick.
+    std::vector<std::uint32_t> movedTick;
+
+    std::vector<std::uint32_t> indexToSlot;
+    std::vector<std::uint32_t> slotToIndex;
+    std::vector<std::uint32_t> slotGenerations;
+    std::vector<std::uint32_t> freeSlots;
+
+public:
+    void reserve(size_t capacity);
+    void clear();
+
+    MeteorHandle add(Vec2 position, Vec2 velocity, float meteorScale, int meteorStage, Vec2 size);
+    void remove(size_t index);
+    bool remove(MeteorHandle handle);
+    // Exchanges two meteors' places in the arrays; their handles stay valid.
+    void swap(size_t a, size_t b);
+
+    MeteorHandle getHandle(size_t index) const;
+    bool isAlive(MeteorHandle handle) const;
+    size_t indexOf(MeteorHandle handle) const;
+
+    // Moves every meteor by its velocity; a flat loop over the arrays so it vectorises.
+    void integrate(float dt);
+    // Moves the meteors with indices in [begin, end), so disjoint ranges can run in parallel.
+    void integrate(float dt, size_t begin, size_t end);
+    // Moves one meteor by dt seconds of its velocity.
+    void advance(size_t index, float dt) {
+        positionX[index] += velocityX[index] * dt;
+        positionY[index] += velocityY[index] * dt;
+    }
+    // Removes meteors that have left the field completely.
+    void removeOutside(float fieldWidth, float fieldHeight);
+
+    void setStage(size_t index, int meteorStage, Vec2 size);
+
+    std::uint32_t getMovedTick(size_t index) const {
+        return movedTick[index];
+    }
+
+    void setMovedTick(size_t index, std::uint32_t tick) {
+        movedTick[index] = tick;
+    }
+
+    // True if the meteor has left a field of that size completely.
+    bool isOutside(size_t index, float fieldWidth, float fieldHeight) const {
+        return positionX[index] < -width[index] || positionY[index] < -height[index] ||
+               positionX[index] > fieldWidth || positionY[index] > fieldHeight;
+    }
+
+    size_t size() const {
+        return positionX.size();
+    }
+
+    bool empty() const {
+        return positionX.empty();
+    }
+
+    // Meteors that fit before the arrays have to grow.
+    size_t capacity() const {
+        return positionX.capacity();
+    }
+
+    Vec2 getPosition(size_t index) const {
+        return {positionX[index], positionY[index]};
+    }
+
+    Vec2 getVelocity(size_t index) const {
+        return {velocityX[index], velocityY[index]};
+    }
+
+    float getScale(size_t index) const {
+        return scale[index];
+    }
+
+    int getStage(size_t index) const {
+        return stage[index];
+    }
+
+    Bounds getBounds(size_t index) const {
+        return {positionX[index], positionY[index], width[index], height[index]};
+    }
+
+    const std::vector<float>& getPositionsX() const {
+        return positionX;
+    }
+
+    const std::vector<float>& getPositionsY() const {
+        return positionY;
+    }
+
+    const std::vector<float>& getWidths() const {
+        return width;
+    }
+
+    const std::vector<float>& getHeights() const {
+        return height;
+    }
+
+    const std::vector<int>& getStages() const {
+        return stage;
+    }
+};
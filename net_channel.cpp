@@ -0,0 +1,63 @@
+#include "net_channel.h"
+
+NetChannel::NetChannel(const NetConditions& conditions, std::uint64_t seed)
+        : conditions(conditions), random(seed), receiveBuffer(sf::UdpSocket::MaxDatagramSize) {
+    socket.setBlocking(false);
+}
+
+bool NetChannel::bind(unsigned short port) {
+    return socket.bind(port) == sf::Socket::Done;
+}
+
+void NetChannel::send(const std::vector<std::uint8_t>& packet, const sf::IpAddress& address, unsigned short port) {
+    if (conditions.lossRate > 0.0f && random.nextFloat() < conditions.lossRate) {
+        ++traffic.packetsDropped;
+        return;
+    }
+    float delay = conditions.latencyMilliseconds + random.nextFloat() * conditions.jitterMilliseconds;
+    if (delay <= 0.0f) {
+        sendNow(packet, address, port);
+        return;
+    }
+    auto due = std::chrono::steady_clock::now() +
+               std::chrono::microseconds(static_cast<long long>(delay * 1000.0f));
+    delayed.push_back({due, address, port, packet});
+}
+
+void NetChannel::flush() {
+    if (delayed.empty()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    size_t kept = 0;
+    for (size_t i = 0; i < delayed.size(); ++i) {
+        if (delayed[i].due <= now) {
+            sendNow(delayed[i].data, delayed[i].address, delayed[i].port);
+        } else {
+            if (kept != i) {
+                delayed[kept] = std::move(delayed[i]);
+            }
+            ++kept;
+        }
+    }
+    delayed.resize(kept);
+}
+
+void NetChannel::sendNow(const std::vector<std::uint8_t>& packet, const sf::IpAddress& address, unsigned short port) {
+    // A full send buffer drops the packet, which the protocol treats like any other loss.
+    if (socket.send(packet.data(), packet.size(), address, port) == sf::Socket::Done) {
+        ++traffic.packetsSent;
+        traffic.bytesSent += packet.size();
+    }
+}
+
+bool NetChannel::receive(std::vector<std::uint8_t>& packet, sf::IpAddress& address, unsigned short& port) {
+    std::size_t received = 0;
+    if (socket.receive(receiveBuffer.data(), receiveBuffer.size(), received, address, port) != sf::Socket::Done) {
+        return false;
+    }
+    packet.assign(receiveBuffer.begin(), receiveBuffer.begin() + received);
+    ++traffic.packetsReceived;
+    traffic.bytesReceived += received;
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "rng.h"
+
+// Simulated network trouble for testing on one machine, applied to the packets a channel
+// sends. With the same conditions on both ends the round trip grows by twice the latency.
+struct NetConditions {
+    float latencyMilliseconds = 0.0f;  // one way
+    float jitterMilliseconds = 0.0f;   // up to this much extra delay, so packets can arrive out of order
+    float lossRate = 0.0f;             // share of packets dropped, 0 to 1
+};
+
+struct NetTraffic {
+    std::uint64_t packetsSent = 0;
+    std::uint64_t bytesSent = 0;       // payload only, see udpHeaderBytes
+    std::uint64_t packetsDropped = 0;  // by the simulated loss
+    std::uint64_t packetsReceived = 0;
+    std::uint64_t bytesReceived = 0;
+};
+
+// IPv4 and UDP headers that every datagram adds on the wire.
+const std::uint64_t udpHeaderBytes = 28;
+
+// Non-blocking UDP socket that can delay and drop outgoing packets.
+class NetChannel {
+private:
+    struct DelayedPacket {
+        std::chrono::steady_clock::time_point due;
+        sf::IpAddress address;
+        unsigned short port;
+        std::vector<std::uint8_t> data;
+    };
+
+    sf::UdpSocket socket;
+    NetConditions conditions;
+    Rng random;
+    std::vector<DelayedPacket> delayed;
+    std::vector<std::uint8_t> receiveBuffer;
+    NetTraffic traffic;
+
+    void sendNow(const std::vector<std::uint8_t>& packet, const sf::IpAddress& address, unsigned short port);
+
+public:
+    explicit NetChannel(const NetConditions& conditions = NetConditions(), std::uint64_t seed = 1);
+
+    // Port 0 picks any free port.
+    bool bind(unsigned short port);
+    void send(const std::vector<std::uint8_t>& packet, const sf::IpAddress& address, unsigned short port);
+    // Sends the delayed packets that are due; call at least once per tick.
+    void flush();
+    // False when no packet is waiting.
+    bool receive(std::vector<std::uint8_t>& packet, sf::IpAddress& address, unsigned short& port);
+
+    unsigned short getLocalPort() const {
+        return socket.getLocalPort();
+    }
+
+    const NetTraffic& getTraffic() const {
+        return traffic;
+    }
+};
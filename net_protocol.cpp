@@ -0,0 +1,561 @@
+#include "net_protocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const float positionScale = 8.0f;
+    const float velocityScale = 16.0f;
+    // Velocity units per tick that make one position unit: velocityScale * netTickRate / positionScale.
+    const std::int64_t velocityTicksPerUnit = 120;
+
+    const std::uint8_t entityNew = 1;
+    const std::uint8_t entityPosition = 2;
+    const std::uint8_t entityVelocity = 4;
+    const std::uint8_t entityStage = 8;
+
+    std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    std::int64_t unzigzag(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    // Rounds half away from zero, so positive and negative velocities behave alike.
+    std::int64_t divideRounded(std::int64_t value, std::int64_t divisor) {
+        return value >= 0 ? (value + divisor / 2) / divisor : -((-value + divisor / 2) / divisor);
+    }
+
+    std::uint32_t entityId(std::uint32_t slot, std::uint32_t generation) {
+        return slot << 8 | (generation & 0xFF);
+    }
+
+    bool byId(const NetEntity& a, const NetEntity& b) {
+        return a.id < b.id;
+    }
+
+    NetEntity predict(const NetEntity& entity, std::uint32_t ticks) {
+        NetEntity result = entity;
+        result.x = predictPosition(entity.x, entity.velocityX, ticks);
+        result.y = predictPosition(entity.y, entity.velocityY, ticks);
+        return result;
+    }
+
+    // Removed ids first, then the new and changed entities; both lists are in id order and
+    // store each id as the difference to the one before.
+    void writeEntities(PacketWriter& out, const std::vector<NetEntity>& current, const std::vector<NetEntity>* baseline,
+                       std::uint32_t ticks, std::vector<NetEntity>& sent) {
+        static const std::vector<NetEntity> empty;
+        const std::vector<NetEntity>& base = baseline != nullptr ? *baseline : empty;
+        std::vector<std::uint32_t> removed;
+        size_t j = 0;
+        for (const auto& entity : current) {
+            while (j < base.size() && base[j].id < entity.id) {
+                removed.push_back(base[j++].id);
+            }
+            if (j < base.size() && base[j].id == entity.id) {
+                ++j;
+            }
+        }
+        while (j < base.size()) {
+            removed.push_back(base[j++].id);
+        }
+        out.writeVarint(removed.size());
+        std::uint32_t previous = 0;
+        for (std::uint32_t id : removed) {
+            out.writeVarint(id - previous);
+            previous = id;
+        }
+
+        std::vector<std::uint8_t> updates;
+        PacketWriter updateWriter(updates);
+        size_t updateCount = 0;
+        previous = 0;
+        sent.clear();
+        j = 0;
+        for (const auto& entity : current) {
+            while (j < base.size() && base[j].id < entity.id) {
+                ++j;
+            }
+            std::uint8_t flags = 0;
+            NetEntity result = entity;
+            if (j < base.size() && base[j].id == entity.id) {
+                NetEntity predicted = predict(base[j], ticks);
+                if (std::abs(entity.x - predicted.x) > netPositionTolerance ||
+                    std::abs(entity.y - predicted.y) > netPositionTolerance) {
+                    flags |= entityPosition;
+                } else {
+                    result.x = predicted.x;
+                    result.y = predicted.y;
+                }
+                if (entity.velocityX != predicted.velocityX || entity.velocityY != predicted.velocityY) {
+                    flags |= entityVelocity;
+                }
+                if (entity.stage != predicted.stage) {
+                    flags |= entityStage;
+                }
+                if (flags != 0) {
+                    updateWriter.writeVarint(entity.id - previous);
+                    updateWriter.writeByte(flags);
+                    if (flags & entityPosition) {
+                        updateWriter.writeSigned(entity.x - predicted.x);
+                        updateWriter.writeSigned(entity.y - predicted.y);
+                    }
+                    if (flags & entityVelocity) {
+                        updateWriter.writeSigned(entity.velocityX - predicted.velocityX);
+                        updateWriter.writeSigned(entity.velocityY - predicted.velocityY);
+                    }
+                    if (flags & entityStage) {
+                        updateWriter.writeByte(entity.stage);
+                    }
+                }
+            } else {
+                flags = entityNew;
+                updateWriter.writeVarint(entity.id - previous);
+                updateWriter.writeByte(flags);
+                updateWriter.writeSigned(entity.x);
+                updateWriter.writeSigned(entity.y);
+                updateWriter.writeSigned(entity.velocityX);
+                updateWriter.writeSigned(entity.velocityY);
+                updateWriter.writeByte(entity.stage);
+            }
+            if (flags != 0) {
+                ++updateCount;
+                previous = entity.id;
+            }
+            sent.push_back(result);
+        }
+        out.writeVarint(updateCount);
+        for (std::uint8_t byte : updates) {
+            out.writeByte(byte);
+        }
+    }
+
+    bool readEntities(PacketReader& in, const std::vector<NetEntity>* baseline, std::uint32_t ticks,
+                      std::vector<NetEntity>& result) {
+        static const std::vector<NetEntity> empty;
+        const std::vector<NetEntity>& base = baseline != nullptr ? *baseline : empty;
+        std::uint64_t removedCount;
+        if (!in.readVarint(removedCount) || removedCount > base.size()) {
+            return false;
+        }
+        std::vector<NetEntity> kept;
+        kept.reserve(base.size());
+        std::uint64_t removedId = 0;
+        std::uint64_t removedLeft = removedCount;
+        bool haveRemoved = false;
+        auto nextRemoved = [&]() {
+            std::uint64_t delta;
+            if (removedLeft == 0 || !in.readVarint(delta)) {
+                return false;
+            }
+            --removedLeft;
+            removedId += delta;
+            return true;
+        };
+        haveRemoved = nextRemoved();
+        for (const auto& entity : base) {
+            if (haveRemoved && removedId == entity.id) {
+                haveRemoved = nextRemoved();
+                continue;
+            }
+            kept.push_back(predict(entity, ticks));
+        }
+        if (haveRemoved || removedLeft != 0) {
+            return false;
+        }
+
+        std::uint64_t updateCount;
+        if (!in.readVarint(updateCount)) {
+            return false;
+        }
+        result.clear();
+        size_t j = 0;
+        std::uint64_t id = 0;
+        for (std::uint64_t k = 0; k < updateCount; ++k) {
+            std::uint64_t delta;
+            std::uint8_t flags;
+            if (!in.readVarint(delta) || !in.readByte(flags)) {
+                return false;
+            }
+            id += delta;
+            while (j < kept.size() && kept[j].id < id) {
+                result.push_back(kept[j++]);
+            }
+            NetEntity entity = {static_cast<std::uint32_t>(id), 0, 0, 0, 0, 0};
+            std::int64_t values[4];
+            if (flags & entityNew) {
+                for (auto& value : values) {
+                    if (!in.readSigned(value)) {
+                        return false;
+                    }
+                }
+                if (!in.readByte(entity.stage)) {
+                    return false;
+                }
+                entity.x = static_cast<std::int32_t>(values[0]);
+                entity.y = static_cast<std::int32_t>(values[1]);
+                entity.velocityX = static_cast<std::int32_t>(values[2]);
+                entity.velocityY = static_cast<std::int32_t>(values[3]);
+            } else {
+                if (j >= kept.size() || kept[j].id != id) {
+                    return false;
+                }
+                entity = kept[j++];
+                if (flags & entityPosition) {
+                    if (!in.readSigned(values[0]) || !in.readSigned(values[1])) {
+                        return false;
+                    }
+                    entity.x += static_cast<std::int32_t>(values[0]);
+                    entity.y += static_cast<std::int32_t>(values[1]);
+                }
+                if (flags & entityVelocity) {
+                    if (!in.readSigned(values[2]) || !in.readSigned(values[3])) {
+                        return false;
+                    }
+                    entity.velocityX += static_cast<std::int32_t>(values[2]);
+                    entity.velocityY += static_cast<std::int32_t>(values[3]);
+                }
+                if ((flags & entityStage) && !in.readByte(entity.stage)) {
+                    return false;
+                }
+            }
+            result.push_back(entity);
+        }
+        while (j < kept.size()) {
+            result.push_back(kept[j++]);
+        }
+        return true;
+    }
+}
+
+PacketWriter::PacketWriter(std::vector<std::uint8_t>& data) : data(data) {
+    data.clear();
+}
+
+void PacketWriter::writeByte(std::uint8_t value) {
+    data.push_back(value);
+}
+
+void PacketWriter::writeU16(std::uint16_t value) {
+    writeByte(static_cast<std::uint8_t>(value));
+    writeByte(static_cast<std::uint8_t>(value >> 8));
+}
+
+void PacketWriter::writeU32(std::uint32_t value) {
+    writeU16(static_cast<std::uint16_t>(value));
+    writeU16(static_cast<std::uint16_t>(value >> 16));
+}
+
+void PacketWriter::writeFloat(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeU32(bits);
+}
+
+void PacketWriter::writeVarint(std::uint64_t value) {
+    while (value >= 0x80) {
+        writeByte(static_cast<std::uint8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    writeByte(static_cast<std::uint8_t>(value));
+}
+
+void PacketWriter::writeSigned(std::int64_t value) {
+    writeVarint(zigzag(value));
+}
+
+PacketReader::PacketReader(const std::uint8_t* data, size_t size) : data(data), size(size), cursor(0) {}
+
+bool PacketReader::readByte(std::uint8_t& value) {
+    if (cursor >= size) {
+        return false;
+    }
+    value = data[cursor++];
+    return true;
+}
+
+bool PacketReader::readU16(std::uint16_t& value) {
+    std::uint8_t low, high;
+    if (!readByte(low) || !readByte(high)) {
+        return false;
+    }
+    value = static_cast<std::uint16_t>(low | high << 8);
+    return true;
+}
+
+bool PacketReader::readU32(std::uint32_t& value) {
+    std::uint16_t low, high;
+    if (!readU16(low) || !readU16(high)) {
+        return false;
+    }
+    value = low | static_cast<std::uint32_t>(high) << 16;
+    return true;
+}
+
+bool PacketReader::readFloat(float& value) {
+    std::uint32_t bits;
+    if (!readU32(bits)) {
+        return false;
+    }
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+bool PacketReader::readVarint(std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        std::uint8_t byte;
+        if (!readByte(byte)) {
+            return false;
+        }
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PacketReader::readSigned(std::int64_t& value) {
+    std::uint64_t encoded;
+    if (!readVarint(encoded)) {
+        return false;
+    }
+    value = unzigzag(encoded);
+    return true;
+}
+
+std::int32_t quantisePosition(float value) {
+    return static_cast<std::int32_t>(std::lround(value * positionScale));
+}
+
+float dequantisePosition(std::int32_t value) {
+    return value / positionScale;
+}
+
+std::int32_t quantiseVelocity(float value) {
+    return static_cast<std::int32_t>(std::lround(value * velocityScale));
+}
+
+float dequantiseVelocity(std::int32_t value) {
+    return value / velocityScale;
+}
+
+std::uint16_t quantiseRotation(float degrees) {
+    float turns = degrees / 360.0f;
+    return static_cast<std::uint16_t>(static_cast<std::int64_t>(std::lround((turns - std::floor(turns)) * 65536.0f)) & 0xFFFF);
+}
+
+float dequantiseRotation(std::uint16_t value) {
+    return value * (360.0f / 65536.0f);
+}
+
+std::int32_t predictPosition(std::int32_t position, std::int32_t velocity, std::uint32_t ticks) {
+    return position + static_cast<std::int32_t>(divideRounded(static_cast<std::int64_t>(velocity) * ticks,
+                                                              velocityTicksPerUnit));
+}
+
+void captureSnapshot(const Simulation& simulation, std::uint32_t tick, NetSnapshot& snapshot) {
+    snapshot.tick = tick;
+    snapshot.score = simulation.getScore();
+    snapshot.gameOver = simulation.isGameOver();
+    snapshot.ships.resize(simulation.getShipCount());
+    for (size_t i = 0; i < simulation.getShipCount(); ++i) {
+        const ShipState& ship = simulation.getShip(i);
+        snapshot.ships[i] = {quantisePosition(ship.position.x), quantisePosition(ship.position.y),
+                             quantiseRotation(ship.rotation),
+                             static_cast<std::uint8_t>(std::max(0, std::min(ship.lives, 255))),
+                             static_cast<std::uint8_t>(simulation.isShipHit(i))};
+    }
+
+    const MeteorField& meteors = simulation.getMeteors();
+    snapshot.meteors.resize(meteors.size());
+    for (size_t i = 0; i < meteors.size(); ++i) {
+        MeteorHandle handle = meteors.getHandle(i);
+        Vec2 position = meteors.getPosition(i);
+        Vec2 velocity = meteors.getVelocity(i);
+        snapshot.meteors[i] = {entityId(handle.slot, handle.generation), quantisePosition(position.x),
+                               quantisePosition(position.y), quantiseVelocity(velocity.x), quantiseVelocity(velocity.y),
+                               static_cast<std::uint8_t>(meteors.getStage(i))};
+    }
+    std::sort(snapshot.meteors.begin(), snapshot.meteors.end(), byId);
+
+    const ProjectilePool& projectiles = simulation.getProjectiles();
+    snapshot.projectiles.resize(projectiles.size());
+    for (size_t i = 0; i < projectiles.size(); ++i) {
+        ProjectileHandle handle = projectiles.getHandle(i);
+        const Projectile& projectile = projectiles[i];
+        snapshot.projectiles[i] = {entityId(handle.slot, handle.generation), quantisePosition(projectile.position.x),
+                                   quantisePosition(projectile.position.y), quantiseVelocity(projectile.velocity.x),
+                                   quantiseVelocity(projectile.velocity.y), 0};
+    }
+    std::sort(snapshot.projectiles.begin(), snapshot.projectiles.end(), byId);
+}
+
+void writeHello(std::vector<std::uint8_t>& packet) {
+    PacketWriter out(packet);
+    out.writeByte(static_cast<std::uint8_t>(NetPacketType::Hello));
+    out.writeU32(netProtocolMagic);
+    out.writeU16(netProtocolVersion);
+}
+
+void writeWelcome(std::vector<std::uint8_t>& packet, const NetWelcome& welcome) {
+    PacketWriter out(packet);
+    out.writeByte(static_cast<std::uint8_t>(NetPacketType::Welcome));
+    out.writeByte(welcome.playerIndex);
+    out.writeByte(welcome.playerCount);
+    out.writeFloat(welcome.fieldWidth);
+    out.writeFloat(welcome.fieldHeight);
+    out.writeFloat(welcome.rotationSmoothing);
+}
+
+void writeFull(std::vector<std::uint8_t>& packet) {
+    PacketWriter out(packet);
+    out.writeByte(static_cast<std::uint8_t>(NetPacketType::Full));
+}
+
+void writeBye(std::vector<std::uint8_t>& packet) {
+    PacketWriter out(packet);
+    out.writeByte(static_cast<std::uint8_t>(NetPacketType::Bye));
+}
+
+// Pointers are sent in whole pixels, the first one as it is and the rest as differences;
+// the fire buttons share one byte.
+void writeInput(std::vector<std::uint8_t>& packet, const NetInputHeader& header, const TickInput* inputs) {
+    PacketWriter out(packet);
+    out.writeByte(static_cast<std::uint8_t>(NetPacketType::Input));
+    out.writeU32(header.ackedTick);
+    out.writeU32(header.lastSequence);
+    out.writeByte(header.count);
+    std::uint8_t fire = 0;
+    std::int64_t previousX = 0;
+    std::int64_t previousY = 0;
+    for (int i = 0; i < header.count; ++i) {
+        std::int64_t x = std::lround(inputs[i].pointer.x);
+        std::int64_t y = std::lround(inputs[i].pointer.y);
+        out.writeSigned(x - previousX);
+        out.writeSigned(y - previousY);
+        previousX = x;
+        previousY = y;
+        fire |= static_cast<std::uint8_t>(inputs[i].fire) << i;
+    }
+    out.writeByte(fire);
+}
+
+void writeSnapshot(std::vector<std::uint8_t>& packet, const NetSnapshotHeader& header, const NetSnapshot& current,
+                   const NetSnapshot* baseline, NetSnapshot& sent) {
+    PacketWriter out(packet);
+    out.writeByte(static_cast<std::uint8_t>(NetPacketType::Snapshot));
+    out.writeU32(header.tick);
+    out.writeU32(baseline != nullptr ? baseline->tick : netNoTick);
+    out.writeU32(header.lastInput);
+    out.writeByte(header.playerIndex);
+
+    std::uint32_t ticks = baseline != nullptr ? current.tick - baseline->tick : 0;
+    out.writeSigned(current.score - (baseline != nullptr ? baseline->score : 0));
+    out.writeByte(current.gameOver);
+    out.writeByte(static_cast<std::uint8_t>(current.ships.size()));
+    for (size_t i = 0; i < current.ships.size(); ++i) {
+        NetShip base = baseline != nullptr && i < baseline->ships.size() ? baseline->ships[i] : NetShip{0, 0, 0, 0, 0};
+        const NetShip& ship = current.ships[i];
+        out.writeSigned(ship.x - base.x);
+        out.writeSigned(ship.y - base.y);
+        out.writeSigned(static_cast<std::int16_t>(ship.rotation - base.rotation));
+        out.writeByte(ship.lives);
+        out.writeByte(ship.hit);
+    }
+
+    sent.tick = current.tick;
+    sent.score = current.score;
+    sent.gameOver = current.gameOver;
+    sent.ships = current.ships;
+    writeEntities(out, current.meteors, baseline != nullptr ? &baseline->meteors : nullptr, ticks, sent.meteors);
+    writeEntities(out, current.projectiles, baseline != nullptr ? &baseline->projectiles : nullptr, ticks,
+                  sent.projectiles);
+}
+
+bool readPacketType(PacketReader& reader, NetPacketType& type) {
+    std::uint8_t value;
+    if (!reader.readByte(value)) {
+        return false;
+    }
+    type = static_cast<NetPacketType>(value);
+    return true;
+}
+
+bool readHello(PacketReader& reader) {
+    std::uint32_t magic;
+    std::uint16_t version;
+    return reader.readU32(magic) && reader.readU16(version) && magic == netProtocolMagic &&
+           version == netProtocolVersion;
+}
+
+bool readWelcome(PacketReader& reader, NetWelcome& welcome) {
+    return reader.readByte(welcome.playerIndex) && reader.readByte(welcome.playerCount) &&
+           reader.readFloat(welcome.fieldWidth) && reader.readFloat(welcome.fieldHeight) &&
+           reader.readFloat(welcome.rotationSmoothing) && welcome.playerIndex < welcome.playerCount;
+}
+
+bool readInput(PacketReader& reader, NetInputHeader& header, TickInput* inputs) {
+    if (!reader.readU32(header.ackedTick) || !reader.readU32(header.lastSequence) || !reader.readByte(header.count) ||
+        header.count == 0 || header.count > netInputRedundancy) {
+        return false;
+    }
+    std::int64_t x = 0;
+    std::int64_t y = 0;
+    for (int i = 0; i < header.count; ++i) {
+        std::int64_t deltaX, deltaY;
+        if (!reader.readSigned(deltaX) || !reader.readSigned(deltaY)) {
+            return false;
+        }
+        x += deltaX;
+        y += deltaY;
+        inputs[i].pointer = {static_cast<float>(x), static_cast<float>(y)};
+    }
+    std::uint8_t fire;
+    if (!reader.readByte(fire)) {
+        return false;
+    }
+    for (int i = 0; i < header.count; ++i) {
+        inputs[i].fire = (fire >> i & 1) != 0;
+    }
+    return true;
+}
+
+bool readSnapshotHeader(PacketReader& reader, NetSnapshotHeader& header) {
+    return reader.readU32(header.tick) && reader.readU32(header.baselineTick) && reader.readU32(header.lastInput) &&
+           reader.readByte(header.playerIndex);
+}
+
+bool readSnapshotBody(PacketReader& reader, const NetSnapshotHeader& header, const NetSnapshot* baseline,
+                      NetSnapshot& snapshot) {
+    std::uint32_t ticks = baseline != nullptr ? header.tick - baseline->tick : 0;
+    std::int64_t score;
+    std::uint8_t gameOver, shipCount;
+    if (!reader.readSigned(score) || !reader.readByte(gameOver) || !reader.readByte(shipCount) ||
+        shipCount > Simulation::maxShips) {
+        return false;
+    }
+    snapshot.tick = header.tick;
+    snapshot.score = static_cast<std::int32_t>(score + (baseline != nullptr ? baseline->score : 0));
+    snapshot.gameOver = gameOver != 0;
+    snapshot.ships.resize(shipCount);
+    for (size_t i = 0; i < shipCount; ++i) {
+        NetShip base = baseline != nullptr && i < baseline->ships.size() ? baseline->ships[i] : NetShip{0, 0, 0, 0, 0};
+        std::int64_t x, y, rotation;
+        NetShip& ship = snapshot.ships[i];
+        if (!reader.readSigned(x) || !reader.readSigned(y) || !reader.readSigned(rotation) ||
+            !reader.readByte(ship.lives) || !reader.readByte(ship.hit)) {
+            return false;
+        }
+        ship.x = static_cast<std::int32_t>(base.x + x);
+        ship.y = static_cast<std::int32_t>(base.y + y);
+        ship.rotation = static_cast<std::uint16_t>(base.rotation + rotation);
+    }
+    return readEntities(reader, baseline != nullptr ? &baseline->meteors : nullptr, ticks, snapshot.meteors) &&
+           readEntities(reader, baseline != nullptr ? &baseline->projectiles : nullptr, ticks, snapshot.projectiles) &&
+           reader.atEnd();
+}
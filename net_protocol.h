@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "simulation.h"
+
+// Wire format of the multiplayer mode. Kept free of SFML like the simulation, so packets can
+// be built and parsed without sockets; net_channel, game_server and game_client send them.
+//
+// The server sends every client a snapshot each tick. Snapshots are quantised (positions to
+// 1/8 px, velocities to 1/16 px/s, ship rotations to 1/65536 of a turn) and encoded against
+// the newest snapshot the client has acknowledged. Meteors and projectiles fly in straight
+// lines, so both ends advance the baseline entities by their velocity, and an entity whose
+// true position is within netPositionTolerance of that prediction is not sent at all. The
+// server keeps what it sent (the prediction, not the true state) as the next baseline, so
+// both ends always hold identical snapshots and errors never build up.
+//
+// Clients send their input for every tick with the last few inputs repeated, so a lost
+// packet is covered by the next one.
+
+const std::uint32_t netProtocolMagic = 0x4147504eu;  // "AGPN"
+const std::uint16_t netProtocolVersion = 1;
+const unsigned short netDefaultPort = 50505;
+const int netTickRate = 60;
+const std::uint32_t netNoTick = 0xffffffffu;
+// Inputs repeated in each input packet.
+const int netInputRedundancy = 8;
+// Prediction error, in 1/8 px, below which an entity is left out of a snapshot.
+const std::int32_t netPositionTolerance = 2;
+
+enum class NetPacketType : std::uint8_t {
+    Hello = 1,     // client -> server: magic, version
+    Welcome = 2,   // server -> client: player index and game settings
+    Full = 3,      // server -> client: every player slot is taken
+    Input = 4,     // client -> server: recent inputs and the newest snapshot received
+    Snapshot = 5,  // server -> client: game state
+    Bye = 6        // either way: leaving
+};
+
+struct NetShip {
+    std::int32_t x;
+    std::int32_t y;
+    std::uint16_t rotation;
+    std::uint8_t lives;
+    std::uint8_t hit;
+};
+
+// A meteor or projectile. The id combines the storage slot with the low bits of its
+// generation, so a slot reused within the baseline window reads as a new entity.
+struct NetEntity {
+    std::uint32_t id;
+    std::int32_t x;
+    std::int32_t y;
+    std::int32_t velocityX;
+    std::int32_t velocityY;
+    std::uint8_t stage;
+};
+
+// Quantised game state of one tick, entities sorted by id.
+struct NetSnapshot {
+    std::uint32_t tick = netNoTick;
+    std::int32_t score = 0;
+    bool gameOver = false;
+    std::vector<NetShip> ships;
+    std::vector<NetEntity> meteors;
+    std::vector<NetEntity> projectiles;
+};
+
+struct NetWelcome {
+    std::uint8_t playerIndex;
+    std::uint8_t playerCount;
+    float fieldWidth;
+    float fieldHeight;
+    float rotationSmoothing;
+};
+
+struct NetInputHeader {
+    std::uint32_t ackedTick;      // newest snapshot received, netNoTick before the first
+    std::uint32_t lastSequence;   // sequence number of the newest input in the packet
+    std::uint8_t count;
+};
+
+struct NetSnapshotHeader {
+    std::uint32_t tick;
+    std::uint32_t baselineTick;   // netNoTick for a snapshot encoded against an empty state
+    std::uint32_t lastInput;      // sequence of the client's newest input applied, 0 if none
+    std::uint8_t playerIndex;
+};
+
+class PacketWriter {
+private:
+    std::vector<std::uint8_t>& data;
+
+public:
+    // Appends to data, which is cleared first.
+    explicit PacketWriter(std::vector<std::uint8_t>& data);
+
+    void writeByte(std::uint8_t value);
+    void writeU16(std::uint16_t value);
+    void writeU32(std::uint32_t value);
+    void writeFloat(float value);
+    void writeVarint(std::uint64_t value);
+    void writeSigned(std::int64_t value);
+};
+
+// Reads fail (return false) instead of reading past the end of a short or damaged packet.
+class PacketReader {
+private:
+    const std::uint8_t* data;
+    size_t size;
+    size_t cursor;
+
+public:
+    PacketReader(const std::uint8_t* data, size_t size);
+
+    bool readByte(std::uint8_t& value);
+    bool readU16(std::uint16_t& value);
+    bool readU32(std::uint32_t& value);
+    bool readFloat(float& value);
+    bool readVarint(std::uint64_t& value);
+    bool readSigned(std::int64_t& value);
+
+    bool atEnd() const {
+        return cursor == size;
+    }
+};
+
+// Quantisation. Positions are in 1/8 px, velocities in 1/16 px/s and rotations in 1/65536 of
+// a turn.
+std::int32_t quantisePosition(float value);
+float dequantisePosition(std::int32_t value);
+std::int32_t quantiseVelocity(float value);
+float dequantiseVelocity(std::int32_t value);
+std::uint16_t quantiseRotation(float degrees);
+float dequantiseRotation(std::uint16_t value);
+// Position of an entity ticks after it was at position, in exact integer arithmetic so the
+// server and every client agree on it.
+std::int32_t predictPosition(std::int32_t position, std::int32_t velocity, std::uint32_t ticks);
+
+void captureSnapshot(const Simulation& simulation, std::uint32_t tick, NetSnapshot& snapshot);
+
+void writeHello(std::vector<std::uint8_t>& packet);
+void writeWelcome(std::vector<std::uint8_t>& packet, const NetWelcome& welcome);
+void writeFull(std::vector<std::uint8_t>& packet);
+void writeBye(std::vector<std::uint8_t>& packet);
+// inputs holds header.count inputs, oldest first, ending with number header.lastSequence.
+void writeInput(std::vector<std::uint8_t>& packet, const NetInputHeader& header, const TickInput* inputs);
+// Encodes current against baseline (nullptr for none) and stores in sent what the client
+// will decode, which is the baseline to use for later snapshots.
+void writeSnapshot(std::vector<std::uint8_t>& packet, const NetSnapshotHeader& header, const NetSnapshot& current,
+                   const NetSnapshot* baseline, NetSnapshot& sent);
+
+// The first byte of every packet.
+bool readPacketType(PacketReader& reader, NetPacketType& type);
+bool readHello(PacketReader& reader);
+bool readWelcome(PacketReader& reader, NetWelcome& welcome);
+bool readInput(PacketReader& reader, NetInputHeader& header, TickInput* inputs);
+bool readSnapshotHeader(PacketReader& reader, NetSnapshotHeader& header);
+// baseline must be the snapshot of header.baselineTick, or nullptr if that is netNoTick.
+bool readSnapshotBody(PacketReader& reader, const NetSnapshotHeader& header, const NetSnapshot* baseline,
+                      NetSnapshot& snapshot);
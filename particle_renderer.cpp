@@ -0,0 +1,39 @@
+#include "particle_renderer.h"
+
+#include "particle_system.h"
+
+ParticleRenderer::ParticleRenderer(const ParticleSystem& system, const sf::BlendMode& blendMode)
+        : vertices(sf::Triangles, system.getCapacity() * 6), blendMode(blendMode) {}
+
+void ParticleRenderer::draw(sf::RenderTarget& target, const ParticleSystem& system, RenderStats* stats) {
+    size_t count = system.getCount();
+    if (count == 0) {
+        return;
+    }
+    const float* x = system.getPositionsX();
+    const float* y = system.getPositionsY();
+    const float* sizes = system.getSizes();
+    const std::uint32_t* colors = system.getColors();
+    sf::Vertex* vertex = &vertices[0];
+    for (size_t i = 0; i < count; ++i, vertex += 6) {
+        // Particles shrink to half their size and fade out over their life.
+        float life = system.getLife(i);
+        float half = sizes[i] * (0.5f - 0.25f * life);
+        sf::Color color(colors[i]);
+        color.a = static_cast<sf::Uint8>(color.a * (1.0f - life));
+        float left = x[i] - half;
+        float top = y[i] - half;
+        float right = x[i] + half;
+        float bottom = y[i] + half;
+        vertex[0] = sf::Vertex(sf::Vector2f(left, top), color);
+        vertex[1] = sf::Vertex(sf::Vector2f(right, top), color);
+        vertex[2] = sf::Vertex(sf::Vector2f(right, bottom), color);
+        vertex[3] = vertex[0];
+        vertex[4] = vertex[2];
+        vertex[5] = sf::Vertex(sf::Vector2f(left, bottom), color);
+    }
+    target.draw(&vertices[0], count * 6, sf::Triangles, sf::RenderStates(blendMode));
+    if (stats != nullptr) {
+        stats->add(count * 6);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "render_stats.h"
+
+class ParticleSystem;
+
+// Draws every particle of one ParticleSystem as an untextured square, all in a single
+// draw call with the renderer's blend mode. The vertex array is sized for the system's
+// capacity up front, so drawing never allocates.
+class ParticleRenderer {
+private:
+    sf::VertexArray vertices;
+    sf::BlendMode blendMode;
+
+public:
+    ParticleRenderer(const ParticleSystem& system, const sf::BlendMode& blendMode);
+
+    void draw(sf::RenderTarget& target, const ParticleSystem& system, RenderStats* stats = nullptr);
+};
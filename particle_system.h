@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "rng.h"
+
+// One emission: count particles thrown out of a disc around position, in random directions,
+// on top of the emitter's own velocity.
+struct ParticleBurst {
+    Vec2 position;
+    Vec2 velocity;
+    int count;
+    float radius;
+    float minSpeed;
+    float maxSpeed;
+    float minLifetime;  // seconds
+    float maxLifetime;
+    float minSize;      // pixels
+    float maxSize;
+    std::uint32_t color;  // 0xRRGGBBAA at birth; the alpha fades to 0 over the lifetime
+};
+
+// Fixed-capacity structure-of-arrays particle pool for visual effects. Every array is
+// allocated once by the constructor; a burst that does not fit is cut short instead of
+// growing the pool, so emitting and updating never allocate. Live particles occupy indices
+// [0, size()), and a dead particle is replaced by the last one.
+//
+// Particles are purely cosmetic: they have their own random generator and never feed back
+// into the simulation, so they do not affect replays.
+class ParticleSystem {
+private:
+    size_t capacity;
+    size_t count;
+    float drag;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    // Fraction of the lifetime that has passed, and how much of it passes per second.
+    std::vector<float> life;
+    std::vector<float> lifeRate;
+    std::vector<float> size;
+    std::vector<std::uint32_t> color;
+    Rng random;
+
+public:
+    // drag is the fraction of its speed a particle loses per second.
+    explicit ParticleSystem(size_t capacity, float drag = 0.0f, std::uint64_t seed = 1);
+
+    // Returns how many particles of the burst were emitted.
+    size_t emit(const ParticleBurst& burst);
+    // Ages and moves every particle, then drops those past their lifetime.
+    void update(float dt);
+    void clear();
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    size_t getCount() const {
+        return count;
+    }
+
+    const float* getPositionsX() const {
+        return positionX.data();
+    }
+
+    const float* getPositionsY() const {
+        return positionY.data();
+    }
+
+    const float* getSizes() const {
+        return size.data();
+    }
+
+    const std::uint32_t* getColors() const {
+        return color.data();
+    }
+
+    // How far each particle is through its life, in [0, 1).
+    float getLife(size_t index) const {
+        return life[index];
+    }
+};
@@ -0,0 +1,189 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+    const char* kindName(Profiler::EventKind kind) {
+        switch (kind) {
+            case Profiler::EventKind::Counter:
+                return "counter";
+            case Profiler::EventKind::Frame:
+                return "frame";
+            default:
+                return "span";
+        }
+    }
+
+    std::uint32_t currentThreadId() {
+        static std::atomic<std::uint32_t> nextId(0);
+        thread_local std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    void writeJsonString(std::ofstream& file, const char* text) {
+        file << '"';
+        for (const char* c = text; *c != '\0'; ++c) {
+            if (*c == '"' || *c == '\\') {
+                file << '\\';
+            }
+            file << *c;
+        }
+        file << '"';
+    }
+
+    double percentile(std::vector<double> values, double fraction) {
+        size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+}
+
+const size_t Profiler::eventCapacity;
+const size_t Profiler::frameHistory;
+
+Profiler::Profiler()
+        : enabled(false), head(0), slots(eventCapacity), epoch(std::chrono::steady_clock::now()),
+          frameMilliseconds(frameHistory, 0.0), frameCursor(0), frameCount(0), frameStart(0) {}
+
+Profiler& Profiler::get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::setEnabled(bool value) {
+    if (value && !isEnabled()) {
+        frameStart = now();
+    }
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+void Profiler::record(const char* name, EventKind kind, std::uint64_t start, std::int64_t value) {
+    std::uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[index & (eventCapacity - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(reinterpret_cast<std::uintptr_t>(name), std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.threadAndKind.store(currentThreadId() << 8 | static_cast<std::uint32_t>(kind), std::memory_order_relaxed);
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+void Profiler::recordSpan(const char* name, std::uint64_t start, std::uint64_t end) {
+    record(name, EventKind::Span, start, static_cast<std::int64_t>(end - start));
+}
+
+void Profiler::recordCounter(const char* name, std::int64_t value) {
+    record(name, EventKind::Counter, now(), value);
+}
+
+void Profiler::endFrame() {
+    if (!isEnabled()) {
+        return;
+    }
+    std::uint64_t end = now();
+    record("frame", EventKind::Frame, frameStart, static_cast<std::int64_t>(end - frameStart));
+    frameMilliseconds[frameCursor] = (end - frameStart) / 1.0e6;
+    frameCursor = (frameCursor + 1) % frameHistory;
+    frameCount = std::min(frameCount + 1, frameHistory);
+    frameStart = end;
+}
+
+void Profiler::snapshot(std::vector<Event>& result) const {
+    result.clear();
+    std::uint64_t end = head.load(std::memory_order_acquire);
+    std::uint64_t begin = end > eventCapacity ? end - eventCapacity : 0;
+    for (std::uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = slots[index & (eventCapacity - 1)];
+        std::uint64_t expected = 2 * (index + 1);
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            continue;
+        }
+        Event event;
+        event.name = reinterpret_cast<const char*>(slot.name.load(std::memory_order_relaxed));
+        event.start = slot.start.load(std::memory_order_relaxed);
+        event.value = slot.value.load(std::memory_order_relaxed);
+        std::uint32_t threadAndKind = slot.threadAndKind.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+            continue;
+        }
+        event.thread = threadAndKind >> 8;
+        event.kind = static_cast<EventKind>(threadAndKind & 0xFF);
+        result.push_back(event);
+    }
+}
+
+void Profiler::getFrameTimes(std::vector<double>& result) const {
+    result.clear();
+    for (size_t i = 0; i < frameCount; ++i) {
+        result.push_back(frameMilliseconds[(frameCursor + frameHistory - frameCount + i) % frameHistory]);
+    }
+}
+
+Profiler::FrameStats Profiler::getFrameStats() const {
+    FrameStats stats = {0, 0.0, 0.0, 0.0, 0.0};
+    std::vector<double> times;
+    getFrameTimes(times);
+    if (times.empty()) {
+        return stats;
+    }
+    stats.frameCount = times.size();
+    for (double time : times) {
+        stats.averageMilliseconds += time;
+        stats.maximumMilliseconds = std::max(stats.maximumMilliseconds, time);
+    }
+    stats.averageMilliseconds /= times.size();
+    stats.p50Milliseconds = percentile(times, 0.50);
+    stats.p99Milliseconds = percentile(times, 0.99);
+    return stats;
+}
+
+// Chrome trace_event format, loadable in chrome://tracing or Perfetto: "X" complete events
+// for spans and frames, "C" events for counters, timestamps in microseconds.
+bool Profiler::writeChromeTrace(const std::string& path) const {
+    std::vector<Event> events;
+    snapshot(events);
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& event = events[i];
+        file << "{\"name\":";
+        writeJsonString(file, event.name);
+        file << ",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start / 1000.0;
+        if (event.kind == EventKind::Counter) {
+            file << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+        } else {
+            file << ",\"ph\":\"X\",\"dur\":" << event.value / 1000.0 << "}";
+        }
+        file << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    file << "]}\n";
+    return static_cast<bool>(file);
+}
+
+bool Profiler::writeCsv(const std::string& path) const {
+    std::vector<Event> events;
+    snapshot(events);
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << std::fixed << std::setprecision(3);
+    file << "kind,name,thread,start_us,duration_us,value\n";
+    for (const auto& event : events) {
+        file << kindName(event.kind) << ',' << event.name << ',' << event.thread << ',' << event.start / 1000.0 << ',';
+        if (event.kind == EventKind::Counter) {
+            file << ',' << event.value << '\n';
+        } else {
+            file << event.value / 1000.0 << ",\n";
+        }
+    }
+    return static_cast<bool>(file);
+}
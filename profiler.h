@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "alloc_tracker.h"
+
+// Scoped-timer profiler for the game loop and the simulation stages.
+//
+// Spans and counters go into a fixed ring of events that any thread can write without a
+// lock; when the ring is full the oldest events are overwritten, so a session keeps the
+// last few seconds. While disabled a PROFILE_SCOPE still names the allocation stage, so
+// it costs a thread-local write on entry and on exit besides one relaxed load and a branch.
+// The main thread calls endFrame() once per frame for the frame-time statistics.
+class Profiler {
+public:
+    enum class EventKind : std::uint8_t {
+        Span,
+        Counter,
+        Frame
+    };
+
+    struct Event {
+        const char* name;
+        EventKind kind;
+        std::uint32_t thread;
+        std::uint64_t start;
+        // Duration in nanoseconds for spans and frames, the value for counters.
+        std::int64_t value;
+    };
+
+    struct FrameStats {
+        size_t frameCount;
+        double averageMilliseconds;
+        double p50Milliseconds;
+        double p99Milliseconds;
+        double maximumMilliseconds;
+    };
+
+    static const size_t eventCapacity = 1 << 16;
+    static const size_t frameHistory = 240;
+
+private:
+    // Seqlock slot: the sequence is odd while a writer is filling it and 2 * (index + 1)
+    // once event number `index` is complete, so readers can skip torn or stale slots.
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        std::atomic<std::uintptr_t> name;
+        std::atomic<std::uint64_t> start;
+        std::atomic<std::int64_t> value;
+        std::atomic<std::uint32_t> threadAndKind;
+    };
+
+    std::atomic<bool> enabled;
+    std::atomic<std::uint64_t> head;
+    std::vector<Slot> slots;
+    std::chrono::steady_clock::time_point epoch;
+
+    std::vector<double> frameMilliseconds;
+    size_t frameCursor;
+    size_t frameCount;
+    std::uint64_t frameStart;
+
+    Profiler();
+
+    void record(const char* name, EventKind kind, std::uint64_t start, std::int64_t value);
+
+public:
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    static Profiler& get();
+
+    void setEnabled(bool value);
+
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Nanoseconds since the profiler was created.
+    std::uint64_t now() const {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    // `name` must outlive the profiler; string literals are the intended use.
+    void recordSpan(const char* name, std::uint64_t start, std::uint64_t end);
+    void recordCounter(const char* name, std::int64_t value);
+    // Main thread only: closes the current frame and starts the next one.
+    void endFrame();
+
+    // Copies the complete events still in the ring, oldest first.
+    void snapshot(std::vector<Event>& result) const;
+    // Main thread only: the last frameHistory frame times in milliseconds, oldest first.
+    void getFrameTimes(std::vector<double>& result) const;
+    FrameStats getFrameStats() const;
+
+    bool writeChromeTrace(const std::string& path) const;
+    bool writeCsv(const std::string& path) const;
+};
+
+// Also makes the scope the allocation stage of its thread, enabled or not, so the
+// allocation counts break down by the same names as the profile.
+class ScopedTimer {
+private:
+    const char* name;
+    bool active;
+    std::uint64_t start;
+    AllocationStage stage;
+
+public:
+    explicit ScopedTimer(const char* name)
+            : name(name), active(Profiler::get().isEnabled()), start(0), stage(name) {
+        if (active) {
+            start = Profiler::get().now();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (active) {
+            Profiler& profiler = Profiler::get();
+            profiler.recordSpan(name, start, profiler.now());
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNTER(name, value)                                                   \
+    do {                                                                               \
+        if (Profiler::get().isEnabled()) {                                             \
+            Profiler::get().recordCounter(name, static_cast<std::int64_t>(value));     \
+        }                                                                              \
+    } while (false)
@@ -0,0 +1,120 @@
+#include "profiler_overlay.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+    const float barWidth = 2.0f;
+    const float graphHeight = 120.0f;
+    const float graphMargin = 10.0f;
+    // The top of the graph is two 60 Hz frames; anything above it is clipped.
+    const double graphMilliseconds = 1000.0 / 30.0;
+    const double budgetMilliseconds = 1000.0 / 60.0;
+    const int refreshInterval = 15;
+    const size_t statsFrames = 60;
+
+    void addQuad(sf::VertexArray& vertices, float left, float top, float width, float height, sf::Color color) {
+        vertices.append(sf::Vertex(sf::Vector2f(left, top), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left + width, top), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left + width, top + height), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left, top), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left + width, top + height), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left, top + height), color));
+    }
+}
+
+ProfilerOverlay::ProfilerOverlay() : font(nullptr), visible(false), framesUntilRefresh(0), graph(sf::Triangles) {
+    text.setCharacterSize(16);
+    text.setFillColor(sf::Color::White);
+}
+
+void ProfilerOverlay::setFont(const sf::Font& value) {
+    font = &value;
+    text.setFont(value);
+}
+
+void ProfilerOverlay::update(sf::Vector2f viewSize) {
+    if (!visible) {
+        return;
+    }
+    rebuildGraph(viewSize);
+    if (--framesUntilRefresh <= 0) {
+        rebuildText(viewSize);
+        framesUntilRefresh = refreshInterval;
+    }
+}
+
+void ProfilerOverlay::rebuildGraph(sf::Vector2f viewSize) {
+    Profiler::get().getFrameTimes(frameTimes);
+    float width = barWidth * Profiler::frameHistory;
+    float left = graphMargin;
+    float top = viewSize.y - graphMargin - graphHeight;
+
+    graph.clear();
+    addQuad(graph, left, top, width, graphHeight, sf::Color(0, 0, 0, 160));
+    // Bars are right-aligned so the newest frame is always at the same place.
+    float barLeft = left + width - barWidth * frameTimes.size();
+    for (double milliseconds : frameTimes) {
+        float height = static_cast<float>(std::min(milliseconds, graphMilliseconds) / graphMilliseconds * graphHeight);
+        sf::Color color = milliseconds <= budgetMilliseconds ? sf::Color(80, 220, 80)
+                          : milliseconds <= graphMilliseconds ? sf::Color(230, 200, 60) : sf::Color(230, 70, 60);
+        addQuad(graph, barLeft, top + graphHeight - height, barWidth, height, color);
+        barLeft += barWidth;
+    }
+    float budgetTop = top + graphHeight - static_cast<float>(budgetMilliseconds / graphMilliseconds * graphHeight);
+    addQuad(graph, left, budgetTop, width, 1.0f, sf::Color(255, 255, 255, 128));
+}
+
+void ProfilerOverlay::rebuildText(sf::Vector2f viewSize) {
+    Profiler& profiler = Profiler::get();
+    Profiler::FrameStats stats = profiler.getFrameStats();
+    profiler.snapshot(events);
+
+    // Stage costs are averaged over the span of the last statsFrames frame events.
+    std::uint64_t windowStart = 0;
+    size_t windowFrames = 0;
+    for (auto it = events.rbegin(); it != events.rend() && windowFrames < statsFrames; ++it) {
+        if (it->kind == Profiler::EventKind::Frame) {
+            windowStart = it->start;
+            ++windowFrames;
+        }
+    }
+
+    std::map<std::string, std::int64_t> stageNanoseconds;
+    std::map<std::string, std::int64_t> counters;
+    for (const auto& event : events) {
+        if (event.kind == Profiler::EventKind::Counter) {
+            counters[event.name] = event.value;
+        } else if (event.kind == Profiler::EventKind::Span && event.start >= windowStart) {
+            stageNanoseconds[event.name] += event.value;
+        }
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "frame  avg " << stats.averageMilliseconds << "  p50 " << stats.p50Milliseconds << "  p99 "
+        << stats.p99Milliseconds << "  max " << stats.maximumMilliseconds << " ms\n";
+    for (const auto& stage : stageNanoseconds) {
+        out << stage.first << "  " << stage.second / 1.0e6 / std::max<size_t>(1, windowFrames) << " ms\n";
+    }
+    for (const auto& counter : counters) {
+        out << counter.first << "  " << counter.second << "\n";
+    }
+    text.setString(out.str());
+
+    sf::FloatRect bounds = text.getLocalBounds();
+    text.setPosition(graphMargin, viewSize.y - 2 * graphMargin - graphHeight - bounds.top - bounds.height);
+}
+
+void ProfilerOverlay::draw(sf::RenderTarget& target) const {
+    if (!visible) {
+        return;
+    }
+    target.draw(graph);
+    if (font != nullptr) {
+        target.draw(text);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+#include "profiler.h"
+
+// Debug overlay for the profiler: a bar graph of the recent frame times against the 60 Hz
+// budget, the frame-time percentiles, the average cost of each stage over the last second
+// and the latest entity counts. The text is only rebuilt a few times per second.
+class ProfilerOverlay {
+private:
+    const sf::Font* font;
+    bool visible;
+    int framesUntilRefresh;
+    sf::VertexArray graph;
+    sf::Text text;
+    std::vector<Profiler::Event> events;
+    std::vector<double> frameTimes;
+
+    void rebuildGraph(sf::Vector2f viewSize);
+    void rebuildText(sf::Vector2f viewSize);
+
+public:
+    ProfilerOverlay();
+
+    void setFont(const sf::Font& value);
+
+    void setVisible(bool value) {
+        visible = value;
+        framesUntilRefresh = 0;
+    }
+
+    bool isVisible() const {
+        return visible;
+    }
+
+    // Call once per frame after Profiler::endFrame().
+    void update(sf::Vector2f viewSize);
+    void draw(sf::RenderTarget& target) const;
+};
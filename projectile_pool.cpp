@@ -0,0 +1,90 @@
+#include "projectile_pool.h"
+
+const std::uint32_t ProjectilePool::invalidSlot;
+
+ProjectilePool::ProjectilePool(size_t capacity) {
+    setCapacity(capacity);
+}
+
+void ProjectilePool::setCapacity(size_t capacity) {
+    slots.assign(capacity, Projectile());
+    generations.assign(capacity, 0);
+    slotToLive.assign(capacity, invalidSlot);
+    liveSlots.clear();
+    liveSlots.reserve(capacity);
+    freeSlots.clear();
+    freeSlots.reserve(capacity);
+    // Hand out low slots first.
+    for (size_t slot = capacity; slot-- > 0; ) {
+        freeSlots.push_back(static_cast<std::uint32_t>(slot));
+    }
+}
+
+void ProjectilePool::clear() {
+    while (!liveSlots.empty()) {
+        releaseAt(liveSlots.size() - 1);
+    }
+}
+
+ProjectileHandle ProjectilePool::spawn(const Projectile& projectile) {
+    if (freeSlots.empty()) {
+        return {invalidSlot, 0};
+    }
+    std::uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    slots[slot] = projectile;
+    slotToLive[slot] = static_cast<std::uint32_t>(liveSlots.size());
+    liveSlots.push_back(slot);
+    return {slot, generations[slot]};
+}
+
+bool ProjectilePool::release(ProjectileHandle handle) {
+    if (!isAlive(handle)) {
+        return false;
+    }
+    releaseAt(slotToLive[handle.slot]);
+    return true;
+}
+
+void ProjectilePool::releaseAt(size_t index) {
+    std::uint32_t slot = liveSlots[index];
+    std::uint32_t lastSlot = liveSlots.back();
+    liveSlots[index] = lastSlot;
+    slotToLive[lastSlot] = static_cast<std::uint32_t>(index);
+    liveSlots.pop_back();
+
+    slotToLive[slot] = invalidSlot;
+    ++generations[slot];
+    freeSlots.push_back(slot);
+}
+
+bool ProjectilePool::isAlive(ProjectileHandle handle) const {
+    return handle.slot < slots.size() && slotToLive[handle.slot] != invalidSlot &&
+           generations[handle.slot] == handle.generation;
+}
+
+ProjectileHandle ProjectilePool::getHandle(size_t index) const {
+    std::uint32_t slot = liveSlots[index];
+    return {slot, generations[slot]};
+}
+
+void ProjectilePool::integrate(float dt) {
+    integrate(dt, 0, liveSlots.size());
+}
+
+void ProjectilePool::integrate(float dt, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        Projectile& projectile = slots[liveSlots[i]];
+        projectile.position.x += projectile.velocity.x * dt;
+        projectile.position.y += projectile.velocity.y * dt;
+    }
+}
+
+void ProjectilePool::removeOutside(float left, float top, float right, float bottom) {
+    for (size_t i = liveSlots.size(); i-- > 0; ) {
+        const Vec2& position = slots[liveSlots[i]].position;
+        if (position.x < left || position.y < top || position.x > right || position.y > bottom) {
+            releaseAt(i);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+struct Projectile {
+    Vec2 position;
+    Vec2 velocity;   // pixels per second, fixed when the projectile is fired
+    float rotation;  // degrees, only used for drawing
+};
+
+struct ProjectileHandle {
+    std::uint32_t slot;
+    std::uint32_t generation;
+};
+
+// Fixed-capacity slab of projectiles. All storage is allocated up front, so spawning
+// and releasing never touch the heap; live projectiles are also listed densely so
+// updates only visit slots that are in use.
+class ProjectilePool {
+private:
+    std::vector<Projectile> slots;
+    std::vector<std::uint32_t> generations;
+    std::vector<std::uint32_t> freeSlots;
+    std::vector<std::uint32_t> liveSlots;
+    std::vector<std::uint32_t> slotToLive;
+
+public:
+    static const std::uint32_t invalidSlot = 0xFFFFFFFFu;
+
+    explicit ProjectilePool(size_t capacity = 0);
+
+    void setCapacity(size_t capacity);
+    void clear();
+
+    // Returns a handle with slot == invalidSlot when the pool is full.
+    ProjectileHandle spawn(const Projectile& projectile);
+    bool release(ProjectileHandle handle);
+    // Releases the projectile at a live index; the last live projectile takes its place.
+    void releaseAt(size_t index);
+
+    bool isAlive(ProjectileHandle handle) const;
+    ProjectileHandle getHandle(size_t index) const;
+
+    void integrate(float dt);
+    // Moves the live projectiles with indices in [begin, end).
+    void integrate(float dt, size_t begin, size_t end);
+    void removeOutside(float left, float top, float right, float bottom);
+
+    size_t size() const {
+        return liveSlots.size();
+    }
+
+    size_t capacity() const {
+        return slots.size();
+    }
+
+    bool full() const {
+        return freeSlots.empty();
+    }
+
+    const Projectile& operator[](size_t index) const {
+        return slots[liveSlots[index]];
+    }
+
+    Projectile& operator[](size_t index) {
+        return slots[liveSlots[index]];
+    }
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+// Draw calls and vertices submitted during one frame. The drawing classes add to it when
+// they are given one, so a frame's cost can be reported without a GPU profiler.
+struct RenderStats {
+    size_t drawCalls = 0;
+    size_t vertices = 0;
+
+    void add(size_t vertexCount) {
+        ++drawCalls;
+        vertices += vertexCount;
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+// PCG32 random number generator (pcg-random.org). Unlike std::rand or the standard
+// distributions, its output is fully specified and the same everywhere. A game replays
+// exactly only with the same build and standard library, though: the simulation's
+// std::sin, std::cos and std::atan2 come from the C library, whose results may differ in the
+// last bit from one to the next.
+class Rng {
+private:
+    std::uint64_t state;
+    std::uint64_t increment;
+
+public:
+    explicit Rng(std::uint64_t seed = 0, std::uint64_t sequence = 0) {
+        this->seed(seed, sequence);
+    }
+
+    void seed(std::uint64_t seed, std::uint64_t sequence = 0) {
+        state = 0;
+        increment = sequence << 1 | 1;
+        next();
+        state += seed;
+        next();
+    }
+
+    std::uint32_t next() {
+        std::uint64_t previous = state;
+        state = previous * 6364136223846793005ull + increment;
+        std::uint32_t shifted = static_cast<std::uint32_t>(((previous >> 18) ^ previous) >> 27);
+        std::uint32_t rotation = static_cast<std::uint32_t>(previous >> 59);
+        return shifted >> rotation | shifted << ((32 - rotation) & 31);
+    }
+
+    // Uniform enough in [0, bound) for the small bounds the game uses.
+    int nextInt(int bound) {
+        return static_cast<int>(next() % static_cast<std::uint32_t>(bound));
+    }
+
+    // Uniform in [0, 1), from the top 24 bits so every value is exact in a float.
+    float nextFloat() {
+        return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    std::uint64_t getState() const {
+        return state;
+    }
+};
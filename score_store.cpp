@@ -0,0 +1,208 @@
+#include "score_store.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(ScoreFileHeader) == 16, "score file header must have no padding");
+static_assert(sizeof(ScoreFileStats) == 24, "score file stats must have no padding");
+static_assert(sizeof(ScoreEntry) == 16, "score entry must have no padding");
+
+namespace {
+    struct Crc32Table {
+        std::uint32_t values[256];
+
+        Crc32Table() {
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                }
+                values[i] = value;
+            }
+        }
+    };
+
+    std::uint32_t crc32(const std::uint8_t* data, size_t size) {
+        static const Crc32Table table;
+        std::uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    // Writes the data to a temporary file, forces it to disk and renames it over the target.
+    bool writeAtomically(const std::string& path, const std::vector<std::uint8_t>& data) {
+        std::string temporaryPath = path + ".tmp";
+        std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+#ifdef _WIN32
+        written = written && _commit(_fileno(file)) == 0;
+#else
+        written = written && fsync(fileno(file)) == 0;
+#endif
+        written = std::fclose(file) == 0 && written;
+        if (!written) {
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+#ifdef _WIN32
+        return MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+    }
+}
+
+ScoreStore::ScoreStore(const std::string& path)
+        : path(path), lifetime{0, 0, 0}, session{0, 0, 0}, loaded(false), hasPending(false), writing(false),
+          stopping(false) {
+    loaded = load();
+    if (!loaded) {
+        leaderboard.clear();
+        lifetime = {0, 0, 0};
+    }
+    writer = std::thread(&ScoreStore::writerLoop, this);
+}
+
+ScoreStore::~ScoreStore() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+bool ScoreStore::load() {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ScoreFileHeader header;
+    if (data.size() < sizeof(header) + sizeof(ScoreFileStats)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, scoreFileMagic, sizeof(header.magic)) != 0 || header.version != scoreFileVersion ||
+        header.entryCount > leaderboardSize ||
+        data.size() != sizeof(header) + sizeof(ScoreFileStats) + header.entryCount * sizeof(ScoreEntry) ||
+        crc32(data.data() + sizeof(header), data.size() - sizeof(header)) != header.checksum) {
+        std::cout << "Ignoring damaged score file " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&lifetime, data.data() + sizeof(header), sizeof(lifetime));
+    leaderboard.resize(header.entryCount);
+    if (header.entryCount > 0) {
+        std::memcpy(leaderboard.data(), data.data() + sizeof(header) + sizeof(lifetime),
+                    header.entryCount * sizeof(ScoreEntry));
+    }
+    return true;
+}
+
+void ScoreStore::importHighScore(const std::string& textPath) {
+    if (loaded || !leaderboard.empty()) {
+        return;
+    }
+    std::ifstream file(textPath);
+    int score = 0;
+    if (file >> score && score > 0) {
+        leaderboard.push_back({0, score, 0});
+        save();
+    }
+}
+
+int ScoreStore::submit(int score, unsigned seconds) {
+    ++session.games;
+    session.bestScore = std::max(session.bestScore, score);
+    session.totalScore += score;
+    ++lifetime.games;
+    lifetime.totalScore += static_cast<std::uint64_t>(std::max(0, score));
+    lifetime.totalSeconds += seconds;
+
+    // Ties go below the older entries.
+    ScoreEntry entry = {static_cast<std::int64_t>(std::time(nullptr)), score, seconds};
+    auto position = std::upper_bound(leaderboard.begin(), leaderboard.end(), entry,
+                                     [](const ScoreEntry& a, const ScoreEntry& b) { return a.score > b.score; });
+    int rank = static_cast<int>(position - leaderboard.begin());
+    if (rank < static_cast<int>(leaderboardSize)) {
+        leaderboard.insert(position, entry);
+        if (leaderboard.size() > leaderboardSize) {
+            leaderboard.pop_back();
+        }
+    } else {
+        rank = -1;
+    }
+    save();
+    return rank;
+}
+
+std::vector<std::uint8_t> ScoreStore::serialize() const {
+    ScoreFileHeader header;
+    std::memcpy(header.magic, scoreFileMagic, sizeof(header.magic));
+    header.version = scoreFileVersion;
+    header.entryCount = static_cast<std::uint32_t>(leaderboard.size());
+    std::vector<std::uint8_t> data(sizeof(header) + sizeof(lifetime) + leaderboard.size() * sizeof(ScoreEntry));
+    std::memcpy(data.data() + sizeof(header), &lifetime, sizeof(lifetime));
+    if (!leaderboard.empty()) {
+        std::memcpy(data.data() + sizeof(header) + sizeof(lifetime), leaderboard.data(),
+                    leaderboard.size() * sizeof(ScoreEntry));
+    }
+    header.checksum = crc32(data.data() + sizeof(header), data.size() - sizeof(header));
+    std::memcpy(data.data(), &header, sizeof(header));
+    return data;
+}
+
+void ScoreStore::save() {
+    std::vector<std::uint8_t> data = serialize();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(data);
+        hasPending = true;
+    }
+    wake.notify_one();
+}
+
+void ScoreStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return !hasPending && !writing; });
+}
+
+void ScoreStore::writerLoop() {
+    std::vector<std::uint8_t> data;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return hasPending || stopping; });
+        if (!hasPending) {
+            return;
+        }
+        data.swap(pending);
+        hasPending = false;
+        writing = true;
+        lock.unlock();
+        if (!writeAtomically(path, data)) {
+            std::cout << "Failed to save scores to " << path << std::endl;
+        }
+        lock.lock();
+        writing = false;
+        done.notify_all();
+    }
+}
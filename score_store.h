@@ -0,0 +1,110 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Persistent leaderboard and play statistics. The file keeps only the best games and running
+// totals, never the whole history, so loading it takes the same time however many games
+// have been played.
+//
+// Layout (little-endian): ScoreFileHeader, ScoreFileStats, then entryCount ScoreEntry
+// records, best first. The header's checksum is the CRC-32 of everything after it. Saves
+// are handed to a writer thread, which writes a temporary file next to the store and renames
+// it over the old one, so a crash leaves the old file or the new one, never a torn one, and
+// the frame loop never waits for the disk.
+
+const char scoreFileMagic[4] = {'A', 'G', 'H', 'S'};
+const std::uint32_t scoreFileVersion = 1;
+
+struct ScoreFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t checksum;
+};
+
+struct ScoreFileStats {
+    std::uint64_t games;
+    std::uint64_t totalScore;
+    std::uint64_t totalSeconds;
+};
+
+struct ScoreEntry {
+    std::int64_t timestamp;  // seconds since the Unix epoch
+    std::int32_t score;
+    std::uint32_t seconds;   // length of the game
+};
+
+class ScoreStore {
+public:
+    static const size_t leaderboardSize = 10;
+
+    struct SessionStats {
+        int games;
+        int bestScore;
+        long long totalScore;
+    };
+
+private:
+    std::string path;
+    std::vector<ScoreEntry> leaderboard;
+    ScoreFileStats lifetime;
+    SessionStats session;
+    bool loaded;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    // The newest unsaved contents; older ones are dropped, as each save holds everything.
+    std::vector<std::uint8_t> pending;
+    bool hasPending;
+    bool writing;
+    bool stopping;
+
+    bool load();
+    std::vector<std::uint8_t> serialize() const;
+    void save();
+    void writerLoop();
+
+public:
+    // Reads the store synchronously; a missing or damaged file starts an empty one.
+    explicit ScoreStore(const std::string& path);
+    // Finishes the last save before returning.
+    ~ScoreStore();
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+
+    // Seeds a store that could not be loaded with the single score of the old text file.
+    void importHighScore(const std::string& textPath);
+
+    // Records a finished game and saves in the background. Returns its place on the
+    // leaderboard (0 = best), or -1 if it did not make it.
+    int submit(int score, unsigned seconds);
+    // Blocks until everything submitted so far is on disk.
+    void flush();
+
+    bool isLoaded() const {
+        return loaded;
+    }
+
+    int getHighScore() const {
+        return leaderboard.empty() ? 0 : leaderboard.front().score;
+    }
+
+    const std::vector<ScoreEntry>& getLeaderboard() const {
+        return leaderboard;
+    }
+
+    const ScoreFileStats& getLifetimeStats() const {
+        return lifetime;
+    }
+
+    const SessionStats& getSessionStats() const {
+        return session;
+    }
+};
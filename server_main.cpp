@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_pack.h"
+#include "game_client.h"
+#include "game_server.h"
+
+// Dedicated multiplayer server: runs the only simulation of the game, with one ship per
+// player, at netTickRate ticks per second. Players join with oop_game --connect <host>.
+//
+// Usage: oop_game_server [--players <n>] [--port <p>] [--seed <s>] [--pack <assets.pack>]
+//                        [--latency <ms>] [--jitter <ms>] [--loss <percent>]
+//                        [--loopback <clients> [--seconds <s>]]
+//
+// --pack turns on pixel collisions with the sprites of the pack, which should be the one the
+// players use. --latency, --jitter and --loss delay and drop the packets the server sends.
+// --loopback runs the server and that many scripted clients in this process on 127.0.0.1,
+// with the same simulated conditions on the clients' packets, for --seconds (default 30),
+// and prints the bandwidth, round trip and prediction report of every client.
+
+namespace {
+    const char* usage = " [--players <n>] [--port <p>] [--seed <s>] [--pack <assets.pack>] [--latency <ms>]"
+                        " [--jitter <ms>] [--loss <percent>] [--loopback <clients> [--seconds <s>]]";
+
+    // A scripted player: the pointer sweeps the field on its own curve, firing in bursts.
+    TickInput botInput(int index, double seconds, const SimConfig& config) {
+        double phase = index * 1.7;
+        TickInput input;
+        input.pointer = {static_cast<float>(config.fieldWidth * (0.5 + 0.35 * std::sin(seconds * 0.7 + phase))),
+                         static_cast<float>(config.fieldHeight * (0.5 + 0.35 * std::sin(seconds * 1.1 + phase * 2)))};
+        input.fire = std::fmod(seconds + index * 0.5, 2.0) < 1.0;
+        return input;
+    }
+}
+
+int main(int argc, char** argv) {
+    GameServer::Options options;
+    std::string packPath;
+    int loopbackClients = 0;
+    double loopbackSeconds = 30.0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            options.playerCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            options.port = static_cast<unsigned short>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            packPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            options.conditions.latencyMilliseconds = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            options.conditions.jitterMilliseconds = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            options.conditions.lossRate = static_cast<float>(std::atof(argv[++i]) / 100.0);
+        } else if (std::strcmp(argv[i], "--loopback") == 0 && i + 1 < argc) {
+            loopbackClients = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            loopbackSeconds = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << usage << std::endl;
+            return 2;
+        }
+    }
+    if (loopbackClients > 0) {
+        options.playerCount = loopbackClients;
+    }
+
+    try {
+        // The settings the game plays with offline, so shots hit online as they do there.
+        SimConfig config = gameSimConfig();
+        std::unique_ptr<SpriteMasks> masks;
+        if (!packPath.empty()) {
+            AssetPack pack;
+            if (!pack.open(packPath)) {
+                std::cerr << "Failed to open " << packPath << std::endl;
+                return 1;
+            }
+            masks.reset(new SpriteMasks(loadSpriteMasks(pack)));
+            // The masks are at the sprites' on-screen size, which the collision boxes must match.
+            auto size = [](const CollisionMask& mask) {
+                return Vec2{static_cast<float>(mask.getSpriteWidth()), static_cast<float>(mask.getSpriteHeight())};
+            };
+            config.shipSize = size(masks->ship);
+            config.projectileSize = size(masks->projectile);
+            for (int stage = 0; stage < Simulation::meteorStageCount; ++stage) {
+                config.meteorSizes[stage] = size(masks->meteors[stage]);
+            }
+        }
+
+        GameServer server(config, options, masks.get());
+        std::cout << "Listening on UDP port " << server.getPort() << " for " << options.playerCount << " players"
+                  << std::endl;
+
+        std::vector<std::unique_ptr<GameClient>> clients;
+        for (int i = 0; i < loopbackClients; ++i) {
+            clients.emplace_back(new GameClient(sf::IpAddress::LocalHost, server.getPort(), options.conditions,
+                                                options.seed + 1 + i));
+        }
+
+        const float dt = 1.0f / netTickRate;
+        const auto tickLength = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(dt));
+        auto nextTick = std::chrono::steady_clock::now();
+        auto startTime = nextTick;
+        auto gameOverTime = nextTick;
+        bool wasStarted = false;
+        bool wasGameOver = false;
+        long long ticks = 0;
+        while (true) {
+            for (size_t i = 0; i < clients.size(); ++i) {
+                clients[i]->poll();
+                clients[i]->tick(botInput(static_cast<int>(i), ticks * dt, config));
+            }
+            server.poll();
+            server.tick(dt);
+
+            auto now = std::chrono::steady_clock::now();
+            if (server.isStarted() && !wasStarted) {
+                wasStarted = true;
+                startTime = now;
+            }
+            if (wasStarted) {
+                ++ticks;
+            }
+            if (server.isGameOver() && !wasGameOver) {
+                wasGameOver = true;
+                gameOverTime = now;
+                std::cout << "Game over, score " << server.getSimulation().getScore() << std::endl;
+            }
+            // Snapshots keep going out for a moment after the game ends, so clients see the end.
+            if (wasGameOver && now - gameOverTime > std::chrono::seconds(2)) {
+                break;
+            }
+            if (!clients.empty() && wasStarted && now - startTime > std::chrono::duration<double>(loopbackSeconds)) {
+                break;
+            }
+            if (!clients.empty() && !wasStarted && now - startTime > std::chrono::seconds(10)) {
+                std::cerr << "Failed to connect the loopback clients" << std::endl;
+                return 1;
+            }
+
+            nextTick += tickLength;
+            if (nextTick < now) {
+                nextTick = now;
+            }
+            std::this_thread::sleep_until(nextTick);
+        }
+
+        server.shutdown();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        server.printReport(seconds);
+        for (size_t i = 0; i < clients.size(); ++i) {
+            clients[i]->poll();
+            std::string name = "client " + std::to_string(i + 1);
+            clients[i]->printReport(name.c_str(), seconds);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,740 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "job_system.h"
+#include "profiler.h"
+
+namespace {
+    const float degreesToRadians = 3.14159f / 180;
+
+    const char meteorIntact = 0;
+    const char meteorDestroyed = 1;
+    const char meteorStageChanged = 2;
+
+    // Chunk sizes for the parallel passes; smaller loops stay on the calling thread.
+    const size_t meteorChunk = 4096;
+    const size_t projectileChunk = 64;
+
+    const size_t initialMeteorCapacity = 256;
+    const size_t initialEventCapacity = 64;
+    const size_t initialHitCapacity = 64;
+
+    // Pixels of relative movement between the mask tests along a swept projectile's path.
+    const float maskSampleSpacing = 4.0f;
+
+    // The step length config.rotationSmoothing is given for.
+    const float smoothingStep = 1.0f / 60;
+
+    // Share of the remaining turn made in a step of dt seconds. At 60 Hz it is the configured
+    // share itself, bit for bit, so recorded games still replay exactly.
+    float turnShare(float smoothing, float dt) {
+        if (std::fabs(dt - smoothingStep) < 1.0e-6f) {
+            return smoothing;
+        }
+        return 1.0f - std::pow(1.0f - smoothing, dt / smoothingStep);
+    }
+
+    static_assert(sizeof(SpriteMasks::meteors) / sizeof(CollisionMask) == Simulation::meteorStageCount,
+                  "one meteor mask per stage");
+
+    template <typename Body>
+    void parallelFor(JobSystem* jobs, size_t count, size_t grain, Body& body) {
+        if (jobs != nullptr) {
+            jobs->parallelFor(count, grain, body);
+        } else if (count > 0) {
+            body(size_t(0), count, 0u);
+        }
+    }
+}
+
+Simulation::Simulation(const SimConfig& config)
+        : config(config), awakeMeteors(0), stepSeconds(smoothingStep), projectiles(config.projectileCapacity), meteorHits(nullptr), meteorHitCount(0),
+          projectileHits(nullptr), projectileHitStart(nullptr), projectileOrder(nullptr), jobs(nullptr),
+          workerCandidates(1), workerHits(1), maskHash(0) {
+    // Meteors are the largest entities, so one cell per meteor keeps each in at most four cells.
+    float cellSize = 0.0f;
+    for (const auto& size : config.meteorSizes) {
+        cellSize = std::max(cellSize, std::max(size.x, size.y));
+    }
+    meteorGrid.configure(0.0f, 0.0f, config.fieldWidth, config.fieldHeight, cellSize);
+    // Room for a busy regular game up front, so the storage does not grow during play.
+    meteors.reserve(initialMeteorCapacity);
+    meteorGrid.reserve(initialMeteorCapacity * 4);
+    candidates.reserve(initialMeteorCapacity);
+    events.reserve(initialEventCapacity);
+    reserveWorkerScratch();
+    reset();
+}
+
+void Simulation::reset() {
+    reset(config.seed);
+}
+
+void Simulation::reset(std::uint64_t gameSeed) {
+    seed = gameSeed;
+    random.seed(seed);
+    ships.resize(std::max(1, std::min(config.shipCount, maxShips)));
+    for (auto& ship : ships) {
+        ship.position = {config.fieldWidth / 2.0f, config.fieldHeight / 2.0f};
+        ship.rotation = 0.0f;
+        ship.lives = config.startLives;
+        ship.hitTimer = 0.0f;
+        ship.timeSinceShot = config.fireInterval;
+        ship.lastPointer = ship.position;
+        ship.hasPointer = false;
+    }
+    meteors.clear();
+    awakeMeteors = 0;
+    meteorGrid.build(0, nullptr, nullptr, nullptr, nullptr);
+    projectiles.clear();
+    events.clear();
+    meteorSpawnTimer = 0.0f;
+    score = 0;
+    gameOver = false;
+    tickCount = 0;
+}
+
+void Simulation::step(float dt, const TickInput& input) {
+    step(dt, &input);
+}
+
+void Simulation::step(float dt, const TickInput* inputs) {
+    if (gameOver) {
+        return;
+    }
+    PROFILE_SCOPE("sim.step");
+    stepSeconds = dt;
+    scratch.reset();
+    events.clear();
+    for (size_t i = 0; i < ships.size(); ++i) {
+        ShipState& ship = ships[i];
+        if (ship.lives <= 0) {
+            continue;
+        }
+        ship.timeSinceShot += dt;
+        if (inputs[i].fire) {
+            shoot(ship);
+        }
+        PROFILE_SCOPE("sim.moveShip");
+        steerShip(ship, inputs[i], config, dt);
+    }
+    {
+        PROFILE_SCOPE("sim.updateMeteors");
+        updateMeteors(dt);
+        generateMeteors(dt);
+    }
+    {
+        PROFILE_SCOPE("sim.broadphase");
+        rebuildBroadphase();
+    }
+    {
+        PROFILE_SCOPE("sim.shipCollisions");
+        checkCollisions();
+    }
+    for (auto& ship : ships) {
+        if (ship.hitTimer > 0.0f) {
+            ship.hitTimer = std::max(0.0f, ship.hitTimer - dt);
+        }
+    }
+    {
+        PROFILE_SCOPE("sim.projectileCollisions");
+        checkProjectileCollisions(dt);
+        removeDestroyedMeteors();
+    }
+    {
+        PROFILE_SCOPE("sim.updateProjectiles");
+        updateProjectiles(dt);
+    }
+    PROFILE_COUNTER("meteors", meteors.size());
+    PROFILE_COUNTER("projectiles", projectiles.size());
+    ++tickCount;
+}
+
+void Simulation::setJobSystem(JobSystem* value) {
+    jobs = value;
+    size_t threadCount = jobs != nullptr ? jobs->getThreadCount() : 1;
+    workerCandidates.resize(threadCount);
+    workerHits.resize(threadCount);
+    reserveWorkerScratch();
+}
+
+void Simulation::reserveWorkerScratch() {
+    for (auto& found : workerCandidates) {
+        found.reserve(initialMeteorCapacity);
+    }
+    for (auto& hits : workerHits) {
+        hits.reserve(initialHitCapacity);
+    }
+}
+
+// Without awakeDistance the next broadphase wakes every new meteor.
+MeteorHandle Simulation::spawnMeteor(Vec2 position, Vec2 velocity, int stage) {
+    MeteorHandle handle = meteors.add(position, velocity, 1.0f, stage, config.meteorSizes[stage]);
+    size_t index = meteors.size() - 1;
+    meteors.setMovedTick(index, static_cast<std::uint32_t>(tickCount));
+    if (config.awakeDistance > 0.0f && isNearShip(index)) {
+        meteors.swap(index, awakeMeteors);
+        ++awakeMeteors;
+    }
+    return handle;
+}
+
+ProjectileHandle Simulation::spawnProjectile(const Projectile& projectile) {
+    return projectiles.spawn(projectile);
+}
+
+SimConfig gameSimConfig() {
+    SimConfig config;
+    config.sweptProjectiles = true;
+    return config;
+}
+
+void Simulation::setSpriteMasks(const SpriteMasks& masks) {
+    setSpriteMasks(prepareSpriteMasks(masks));
+}
+
+void Simulation::setSpriteMasks(std::shared_ptr<const PreparedSpriteMasks> prepared) {
+    masks = std::move(prepared);
+    maskHash = masks ? masks->hash : 0;
+}
+
+std::shared_ptr<const PreparedSpriteMasks> Simulation::prepareSpriteMasks(const SpriteMasks& masks) {
+    std::shared_ptr<PreparedSpriteMasks> prepared = std::make_shared<PreparedSpriteMasks>();
+    std::uint64_t& hash = prepared->hash;
+    hash = 14695981039346656037ull;
+    auto mix = [&hash](std::uint64_t value) {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+    prepared->ship.resize(shipMaskRotations);
+    for (int step = 0; step < shipMaskRotations; ++step) {
+        prepared->ship[step] = masks.ship.rotated(step * 360.0f / shipMaskRotations);
+        mix(prepared->ship[step].hash());
+    }
+    prepared->projectile = masks.projectile;
+    mix(prepared->projectile.hash());
+    for (int stage = 0; stage < meteorStageCount; ++stage) {
+        prepared->meteors[stage] = masks.meteors[stage];
+        mix(prepared->meteors[stage].hash());
+    }
+    if (hash == 0) {
+        hash = 1;
+    }
+    return prepared;
+}
+
+std::uint64_t Simulation::computeStateHash() const {
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            hash = (hash ^ static_cast<const unsigned char*>(data)[i]) * 1099511628211ull;
+        }
+    };
+    auto mixValue = [&mix](auto value) {
+        mix(&value, sizeof(value));
+    };
+
+    mixValue(tickCount);
+    mixValue(score);
+    mixValue(gameOver);
+    mixValue(meteorSpawnTimer);
+    mixValue(random.getState());
+    for (const auto& ship : ships) {
+        mixValue(ship.position);
+        mixValue(ship.rotation);
+        mixValue(ship.lives);
+        mixValue(ship.hitTimer);
+        mixValue(ship.timeSinceShot);
+        mixValue(ship.lastPointer);
+        mixValue(ship.hasPointer);
+    }
+    // Which meteors sleep and when each last moved decide when they move next.
+    mixValue(static_cast<std::uint32_t>(awakeMeteors));
+    for (size_t i = 0; i < meteors.size(); ++i) {
+        mixValue(meteors.getPosition(i));
+        mixValue(meteors.getVelocity(i));
+        mixValue(meteors.getStage(i));
+        mixValue(meteors.getMovedTick(i));
+    }
+    for (size_t i = 0; i < projectiles.size(); ++i) {
+        mixValue(projectiles[i].position);
+        mixValue(projectiles[i].velocity);
+    }
+    return hash;
+}
+
+Bounds Simulation::getShipBounds(const ShipState& ship) const {
+    // Axis-aligned box of the rotated ship sprite, which is centred on its position.
+    float angle = ship.rotation * degreesToRadians;
+    float cosine = std::fabs(std::cos(angle));
+    float sine = std::fabs(std::sin(angle));
+    float width = config.shipSize.x * cosine + config.shipSize.y * sine;
+    float height = config.shipSize.x * sine + config.shipSize.y * cosine;
+    return {ship.position.x - width / 2.0f, ship.position.y - height / 2.0f, width, height};
+}
+
+Bounds Simulation::getProjectileBounds(const Projectile& projectile) const {
+    const Vec2& size = config.projectileSize;
+    return {projectile.position.x - size.x / 2.0f, projectile.position.y - size.y / 2.0f, size.x, size.y};
+}
+
+void Simulation::shoot(ShipState& ship) {
+    if (ship.timeSinceShot < config.fireInterval) {
+        return;
+    }
+    float angle = ship.rotation * degreesToRadians;
+    float noseDistance = getShipBounds(ship).height * 0.1f;
+    Vec2 direction = {std::sin(angle), -std::cos(angle)};
+    Projectile projectile;
+    projectile.position = {ship.position.x + direction.x * noseDistance,
+                           ship.position.y + direction.y * noseDistance};
+    projectile.velocity = {direction.x * config.projectileSpeed, direction.y * config.projectileSpeed};
+    projectile.rotation = ship.rotation;
+    if (spawnProjectile(projectile).slot != ProjectilePool::invalidSlot) {
+        ship.timeSinceShot = 0.0f;
+    }
+}
+
+void Simulation::steerShip(ShipState& ship, const TickInput& input, const SimConfig& config, float dt) {
+    float reach = config.shipSpeed * dt;
+    float offsetX = input.pointer.x - ship.position.x;
+    float offsetY = input.pointer.y - ship.position.y;
+    float distance = std::sqrt(offsetX * offsetX + offsetY * offsetY);
+    if (config.shipSpeed > 0.0f && distance > reach) {
+        ship.position.x += offsetX / distance * reach;
+        ship.position.y += offsetY / distance * reach;
+    } else {
+        ship.position = input.pointer;
+    }
+    if (!ship.hasPointer) {
+        ship.lastPointer = input.pointer;
+        ship.hasPointer = true;
+    }
+
+    Vec2 direction = {input.pointer.x - ship.lastPointer.x, input.pointer.y - ship.lastPointer.y};
+    if (direction.x != 0 || direction.y != 0) {
+        float targetAngle = std::atan2(direction.y, direction.x) * 180 / 3.14159f + 90;
+        float angleDifference = targetAngle - ship.rotation;
+        angleDifference -= std::floor((angleDifference + 180) / 360) * 360;
+        ship.rotation += angleDifference * turnShare(config.rotationSmoothing, dt);
+    }
+    ship.lastPointer = input.pointer;
+}
+
+void Simulation::updateMeteors(float dt) {
+    if (config.awakeDistance > 0.0f) {
+        updateMeteorSleep(dt);
+        return;
+    }
+    auto move = [this, dt](size_t begin, size_t end, unsigned) {
+        meteors.integrate(dt, begin, end);
+    };
+    parallelFor(jobs, meteors.size(), meteorChunk, move);
+    meteors.removeOutside(config.fieldWidth, config.fieldHeight);
+}
+
+// Awake meteors move every tick and fall asleep once no ship is near. A sleeping meteor is
+// brought up to date every sleepInterval ticks, by all the ticks it missed, and wakes up if a
+// ship has come near; so the cost of a tick grows with the meteors near the ships, not with
+// all of them. Finding the sleepers that are due is one flat pass over their tick stamps.
+void Simulation::updateMeteorSleep(float dt) {
+    auto move = [this, dt](size_t begin, size_t end, unsigned) {
+        meteors.integrate(dt, begin, end);
+    };
+    parallelFor(jobs, awakeMeteors, meteorChunk, move);
+
+    std::uint32_t tick = static_cast<std::uint32_t>(tickCount);
+    // Highest index first, so every meteor moved into a hole has been looked at already.
+    for (size_t i = awakeMeteors; i-- > 0; ) {
+        if (meteors.isOutside(i, config.fieldWidth, config.fieldHeight)) {
+            removeMeteor(i);
+        } else if (!isNearShip(i)) {
+            meteors.setMovedTick(i, tick);
+            --awakeMeteors;
+            meteors.swap(i, awakeMeteors);
+        }
+    }
+
+    std::uint32_t interval = static_cast<std::uint32_t>(std::max(1, config.sleepInterval));
+    for (size_t i = awakeMeteors; i < meteors.size(); ) {
+        std::uint32_t missed = tick - meteors.getMovedTick(i);
+        if (missed < interval) {
+            ++i;
+            continue;
+        }
+        meteors.advance(i, static_cast<float>(missed) * dt);
+        meteors.setMovedTick(i, tick);
+        if (meteors.isOutside(i, config.fieldWidth, config.fieldHeight)) {
+            // The last meteor takes its place and has not been looked at yet.
+            meteors.remove(i);
+        } else if (isNearShip(i)) {
+            // The sleeper swapped in from awakeMeteors has been looked at already.
+            meteors.swap(i, awakeMeteors);
+            ++awakeMeteors;
+            ++i;
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Near means within awakeDistance plus how far the ship and the meteor can close in before
+// the meteor is looked at again, sleepInterval ticks later; so no sleeping meteor ever comes
+// within awakeDistance of a ship that keeps to shipSpeed.
+bool Simulation::isNearShip(size_t meteor) const {
+    Bounds bounds = meteors.getBounds(meteor);
+    Vec2 velocity = meteors.getVelocity(meteor);
+    float closing = config.shipSpeed + std::max(std::abs(velocity.x), std::abs(velocity.y));
+    float distance = config.awakeDistance + closing * static_cast<float>(std::max(1, config.sleepInterval)) * stepSeconds;
+    for (const auto& ship : ships) {
+        if (ship.lives > 0 && bounds.left + bounds.width > ship.position.x - distance &&
+            bounds.left < ship.position.x + distance &&
+            bounds.top + bounds.height > ship.position.y - distance &&
+            bounds.top < ship.position.y + distance) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Keeps the awake meteors in front: the last awake meteor fills the hole, and the last
+// meteor of all fills its place.
+void Simulation::removeMeteor(size_t index) {
+    if (index < awakeMeteors) {
+        --awakeMeteors;
+        meteors.swap(index, awakeMeteors);
+        index = awakeMeteors;
+    }
+    meteors.remove(index);
+}
+
+void Simulation::generateMeteors(float dt) {
+    meteorSpawnTimer += dt;
+    if (meteorSpawnTimer < config.meteorSpawnInterval) {
+        return;
+    }
+
+    int stage = random.nextInt(meteorStageCount);
+    const Vec2& size = config.meteorSizes[stage];
+    Vec2 position;
+    int fieldWidth = static_cast<int>(config.fieldWidth);
+    int fieldHeight = static_cast<int>(config.fieldHeight);
+
+    switch (random.nextInt(4)) {
+        case 0:
+            position = {static_cast<float>(random.nextInt(fieldWidth)), -size.y};
+            break;
+        case 1:
+            position = {config.fieldWidth, static_cast<float>(random.nextInt(fieldHeight))};
+            break;
+        case 2:
+            position = {static_cast<float>(random.nextInt(fieldWidth)), config.fieldHeight};
+            break;
+        default:
+            position = {-size.x, static_cast<float>(random.nextInt(fieldHeight))};
+            break;
+    }
+
+    float directionX = static_cast<float>(random.nextInt(200) - 100);
+    float directionY = static_cast<float>(random.nextInt(200) - 100);
+    float length = std::sqrt(directionX * directionX + directionY * directionY);
+    if (length != 0) {
+        directionX /= length;
+        directionY /= length;
+    }
+    Vec2 velocity = {directionX * config.meteorSpeed, directionY * config.meteorSpeed};
+
+    spawnMeteor(position, velocity, stage);
+    meteorSpawnTimer = 0.0f;
+}
+
+void Simulation::rebuildBroadphase() {
+    if (config.awakeDistance <= 0.0f) {
+        awakeMeteors = meteors.size();
+    }
+    meteorGrid.build(awakeMeteors, meteors.getPositionsX().data(), meteors.getPositionsY().data(),
+                     meteors.getWidths().data(), meteors.getHeights().data());
+    meteorHitCount = awakeMeteors;
+    meteorHits = scratch.allocate<char>(meteorHitCount);
+    std::fill(meteorHits, meteorHits + meteorHitCount, meteorIntact);
+}
+
+// Both collision passes only mark meteors as destroyed; removal is deferred to
+// removeDestroyedMeteors so the indices stored in the grid stay valid.
+void Simulation::checkCollisions() {
+    int shipsLeft = 0;
+    for (size_t i = 0; i < ships.size(); ++i) {
+        ShipState& ship = ships[i];
+        if (ship.lives <= 0) {
+            continue;
+        }
+        Bounds shipBounds = getShipBounds(ship);
+        meteorGrid.query(shipBounds, candidates);
+
+        for (std::uint32_t index : candidates) {
+            if (meteorHits[index] != meteorIntact || !shipTouchesMeteor(ship, shipBounds, index)) {
+                continue;
+            }
+            --ship.lives;
+            events.push_back({SimEvent::Type::ShipHit, ship.position, {0.0f, 0.0f}, 0, static_cast<int>(i)});
+            if (ship.lives <= 0) {
+                break;
+            }
+            ship.hitTimer = config.hitFlashDuration;
+            addMeteorEvent(SimEvent::Type::MeteorDestroyed, index);
+            meteorHits[index] = meteorDestroyed;
+        }
+        shipsLeft += ship.lives > 0;
+    }
+    if (shipsLeft == 0) {
+        gameOver = true;
+    }
+}
+
+// Runs in two phases so the search can be split across threads and still give the same
+// result for any thread count. First every projectile collects the meteors it overlaps
+// into the buffer of the thread that handles it. Then the hits are applied on this thread,
+// in the order a plain loop over the projectiles with swap-and-pop removal visits them.
+void Simulation::checkProjectileCollisions(float dt) {
+    for (auto& hits : workerHits) {
+        hits.clear();
+    }
+    // A swept search covers the projectile's path, widened by the farthest any meteor moves.
+    Vec2 meteorStep = {0.0f, 0.0f};
+    if (config.sweptProjectiles) {
+        for (size_t i = 0; i < meteorHitCount; ++i) {
+            Vec2 velocity = meteors.getVelocity(i);
+            meteorStep.x = std::max(meteorStep.x, std::abs(velocity.x) * dt);
+            meteorStep.y = std::max(meteorStep.y, std::abs(velocity.y) * dt);
+        }
+    }
+    auto findHits = [this, dt, meteorStep](size_t begin, size_t end, unsigned worker) {
+        std::vector<std::uint32_t>& found = workerCandidates[worker];
+        std::vector<ProjectileHit>& hits = workerHits[worker];
+        for (size_t i = begin; i < end; ++i) {
+            Bounds projectileBounds = getProjectileBounds(projectiles[i]);
+            Bounds area = projectileBounds;
+            if (config.sweptProjectiles) {
+                Vec2 travel = {projectiles[i].velocity.x * dt, projectiles[i].velocity.y * dt};
+                area.left += std::min(travel.x, 0.0f) - meteorStep.x;
+                area.top += std::min(travel.y, 0.0f) - meteorStep.y;
+                area.width += std::abs(travel.x) + meteorStep.x * 2.0f;
+                area.height += std::abs(travel.y) + meteorStep.y * 2.0f;
+            }
+            meteorGrid.query(area, found);
+            float time = 0.0f;
+            for (std::uint32_t index : found) {
+                if (meteorHits[index] == meteorIntact &&
+                    projectileHitsMeteor(projectiles[i], projectileBounds, index, dt, time)) {
+                    hits.push_back({static_cast<std::uint32_t>(i), index, time});
+                }
+            }
+        }
+    };
+    size_t count = projectiles.size();
+    parallelFor(jobs, count, projectileChunk, findHits);
+
+    // Merge into one list ordered by projectile, time of impact and meteor, whichever thread
+    // found them.
+    size_t hitCount = 0;
+    for (const auto& hits : workerHits) {
+        hitCount += hits.size();
+    }
+    projectileHits = scratch.allocate<ProjectileHit>(hitCount);
+    ProjectileHit* merged = projectileHits;
+    for (const auto& hits : workerHits) {
+        merged = std::copy(hits.begin(), hits.end(), merged);
+    }
+    std::sort(projectileHits, projectileHits + hitCount, [](const ProjectileHit& a, const ProjectileHit& b) {
+        if (a.projectile != b.projectile) {
+            return a.projectile < b.projectile;
+        }
+        return a.time != b.time ? a.time < b.time : a.meteor < b.meteor;
+    });
+    projectileHitStart = scratch.allocate<std::uint32_t>(count + 1);
+    std::fill(projectileHitStart, projectileHitStart + count + 1, 0u);
+    for (size_t i = 0; i < hitCount; ++i) {
+        ++projectileHitStart[projectileHits[i].projectile + 1];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        projectileHitStart[i + 1] += projectileHitStart[i];
+    }
+
+    // projectileOrder maps the current pool index back to the index the hits were found under.
+    projectileOrder = scratch.allocate<std::uint32_t>(count);
+    for (size_t i = 0; i < count; ++i) {
+        projectileOrder[i] = static_cast<std::uint32_t>(i);
+    }
+    for (size_t i = 0; i < projectiles.size(); ) {
+        if (applyProjectileHits(projectileOrder[i], i, dt)) {
+            projectiles.releaseAt(i);
+            projectileOrder[i] = projectileOrder[projectiles.size()];
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Applies the first hit of one projectile that is still valid. A meteor already moved to a
+// smaller stage this tick is tested again against its new bounds and mask. As long as the
+// stages never grow, no overlap can appear that the first phase missed.
+bool Simulation::applyProjectileHits(std::uint32_t projectile, size_t index, float dt) {
+    std::uint32_t first = projectileHitStart[projectile];
+    std::uint32_t last = projectileHitStart[projectile + 1];
+    if (first == last) {
+        return false;
+    }
+    const Projectile& shot = projectiles[index];
+    Bounds projectileBounds = getProjectileBounds(shot);
+    float time = 0.0f;
+    for (std::uint32_t k = first; k < last; ++k) {
+        std::uint32_t meteor = projectileHits[k].meteor;
+        if (meteorHits[meteor] == meteorDestroyed ||
+            (meteorHits[meteor] == meteorStageChanged &&
+             !projectileHitsMeteor(shot, projectileBounds, meteor, dt, time))) {
+            continue;
+        }
+        int stage = meteors.getStage(meteor);
+        score += meteorStageCount - stage;
+        if (stage + 1 < meteorStageCount) {
+            addMeteorEvent(SimEvent::Type::MeteorHit, meteor);
+            meteors.setStage(meteor, stage + 1, config.meteorSizes[stage + 1]);
+            meteorHits[meteor] = meteorStageChanged;
+        } else {
+            addMeteorEvent(SimEvent::Type::MeteorDestroyed, meteor);
+            meteorHits[meteor] = meteorDestroyed;
+        }
+        return true;
+    }
+    return false;
+}
+
+void Simulation::addMeteorEvent(SimEvent::Type type, size_t meteor) {
+    Bounds bounds = meteors.getBounds(meteor);
+    Vec2 center = {bounds.left + bounds.width / 2.0f, bounds.top + bounds.height / 2.0f};
+    events.push_back({type, center, meteors.getVelocity(meteor), meteors.getStage(meteor), 0});
+}
+
+// Box test first; the masks are only compared for pairs whose boxes overlap.
+bool Simulation::shipTouchesMeteor(const ShipState& ship, const Bounds& shipBounds, size_t meteor) const {
+    if (!shipBounds.intersects(meteors.getBounds(meteor))) {
+        return false;
+    }
+    if (maskHash == 0) {
+        return true;
+    }
+    float turns = ship.rotation / 360.0f;
+    int step = static_cast<int>(std::floor((turns - std::floor(turns)) * shipMaskRotations + 0.5f)) % shipMaskRotations;
+    const CollisionMask& mask = masks->ship[step];
+    Vec2 position = meteors.getPosition(meteor);
+    float left = ship.position.x - mask.getSpriteWidth() / 2.0f;
+    float top = ship.position.y - mask.getSpriteHeight() / 2.0f;
+    return mask.overlaps(masks->meteors[meteors.getStage(meteor)], static_cast<int>(std::lround(position.x - left)),
+                         static_cast<int>(std::lround(position.y - top)));
+}
+
+bool Simulation::projectileTouchesMeteor(const Projectile& projectile, const Bounds& projectileBounds,
+                                         size_t meteor) const {
+    if (!projectileBounds.intersects(meteors.getBounds(meteor))) {
+        return false;
+    }
+    return maskHash == 0 ||
+           projectileMaskTouches(projectile.position, meteors.getPosition(meteor), meteors.getStage(meteor));
+}
+
+bool Simulation::projectileMaskTouches(Vec2 projectilePosition, Vec2 meteorPosition, int stage) const {
+    const CollisionMask& mask = masks->projectile;
+    float left = projectilePosition.x - mask.getSpriteWidth() / 2.0f;
+    float top = projectilePosition.y - mask.getSpriteHeight() / 2.0f;
+    return mask.overlaps(masks->meteors[stage], static_cast<int>(std::lround(meteorPosition.x - left)),
+                         static_cast<int>(std::lround(meteorPosition.y - top)));
+}
+
+// The projectile moves by its velocity over the tick and the meteor by its own, so relative
+// to the meteor the projectile's box slides along one segment. Per axis that gives the
+// fraction of the tick during which the boxes overlap; the boxes meet where all of them do.
+// With masks that time span is sampled a few pixels of relative movement apart, and the
+// first sample where the masks touch is the time of impact.
+bool Simulation::projectileSweepsMeteor(const Projectile& projectile, const Bounds& projectileBounds, size_t meteor,
+                                        float dt, float& time) const {
+    Bounds bounds = meteors.getBounds(meteor);
+    Vec2 meteorVelocity = meteors.getVelocity(meteor);
+    float moveX = (projectile.velocity.x - meteorVelocity.x) * dt;
+    float moveY = (projectile.velocity.y - meteorVelocity.y) * dt;
+    float enter = 0.0f;
+    float exit = 1.0f;
+    auto clip = [&enter, &exit](float start, float size, float otherStart, float otherSize, float move) {
+        if (move == 0.0f) {
+            return start < otherStart + otherSize && otherStart < start + size;
+        }
+        float first = (otherStart - start - size) / move;
+        float last = (otherStart + otherSize - start) / move;
+        if (first > last) {
+            std::swap(first, last);
+        }
+        enter = std::max(enter, first);
+        exit = std::min(exit, last);
+        return enter < exit;
+    };
+    if (!clip(projectileBounds.left, projectileBounds.width, bounds.left, bounds.width, moveX) ||
+        !clip(projectileBounds.top, projectileBounds.height, bounds.top, bounds.height, moveY)) {
+        return false;
+    }
+    if (maskHash == 0) {
+        time = enter;
+        return true;
+    }
+
+    float distance = std::sqrt(moveX * moveX + moveY * moveY);
+    int samples = 1 + static_cast<int>((exit - enter) * distance / maskSampleSpacing);
+    int stage = meteors.getStage(meteor);
+    for (int sample = 0; sample <= samples; ++sample) {
+        float at = std::min(enter + (exit - enter) * sample / samples, exit);
+        Vec2 projectilePosition = {projectile.position.x + projectile.velocity.x * dt * at,
+                                   projectile.position.y + projectile.velocity.y * dt * at};
+        Vec2 meteorPosition = {bounds.left + meteorVelocity.x * dt * at, bounds.top + meteorVelocity.y * dt * at};
+        if (projectileMaskTouches(projectilePosition, meteorPosition, stage)) {
+            time = at;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Simulation::projectileHitsMeteor(const Projectile& projectile, const Bounds& projectileBounds, size_t meteor,
+                                      float dt, float& time) const {
+    if (config.sweptProjectiles) {
+        return projectileSweepsMeteor(projectile, projectileBounds, meteor, dt, time);
+    }
+    time = 0.0f;
+    return projectileTouchesMeteor(projectile, projectileBounds, meteor);
+}
+
+void Simulation::removeDestroyedMeteors() {
+    // Highest index first, so every swap-and-pop moves in a meteor that is kept.
+    bool removed = false;
+    for (size_t i = meteorHitCount; i-- > 0; ) {
+        if (meteorHits[i] == meteorDestroyed) {
+            removeMeteor(i);
+            removed = true;
+        }
+    }
+    // Brought up to date for queryMeteors; the meteors do not move again this step.
+    if (removed) {
+        meteorGrid.build(awakeMeteors, meteors.getPositionsX().data(), meteors.getPositionsY().data(),
+                         meteors.getWidths().data(), meteors.getHeights().data());
+    }
+}
+
+void Simulation::updateProjectiles(float dt) {
+    auto move = [this, dt](size_t begin, size_t end, unsigned) {
+        projectiles.integrate(dt, begin, end);
+    };
+    parallelFor(jobs, projectiles.size(), projectileChunk * 16, move);
+
+    // A projectile is dropped once its sprite is entirely outside the field.
+    const Vec2& size = config.projectileSize;
+    projectiles.removeOutside(-size.x / 2.0f, -size.y / 2.0f,
+                              config.fieldWidth + size.x / 2.0f, config.fieldHeight + size.y / 2.0f);
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "collision_mask.h"
+#include "frame_arena.h"
+#include "geometry.h"
+#include "meteor_field.h"
+#include "projectile_pool.h"
+#include "rng.h"
+#include "spatial_grid.h"
+
+class JobSystem;
+
+// Window-independent game state. Nothing in here touches SFML, so the simulation
+// can be stepped on machines without a display or GPU.
+
+struct TickInput {
+    Vec2 pointer;
+    bool fire;
+};
+
+struct SimConfig {
+    float fieldWidth = 1920.0f;
+    float fieldHeight = 1080.0f;
+    int shipCount = 1;                // 1 to Simulation::maxShips, one per player
+    int startLives = 3;
+    float meteorSpawnInterval = 3.5f;
+    float meteorSpeed = 12.0f;        // pixels per second
+    float projectileSpeed = 120.0f;   // pixels per second
+    float fireInterval = 0.3f;        // seconds between shots while fire is held
+    size_t projectileCapacity = 512;  // shots are dropped while the pool is full
+    float hitFlashDuration = 0.1f;
+    // Share of the remaining turn towards the pointer's heading made per 1/60 s. Steps of
+    // another length turn at the same rate per second.
+    float rotationSmoothing = 0.05f;
+    // Ships move towards the pointer at up to this many pixels per second; 0 puts them on it
+    // at once. A camera that follows the ship needs a limit.
+    float shipSpeed = 0.0f;
+    // Meteors farther than this from every ship, in x or y, sleep: they skip the collision
+    // passes and only move every sleepInterval ticks. 0 keeps every meteor awake. Meant for
+    // fields much larger than the screen, with a distance that covers the view. Meteors are
+    // woken early enough to never come closer while asleep, as long as the ships keep to
+    // shipSpeed; with shipSpeed 0 a ship that jumps can land next to sleeping meteors.
+    float awakeDistance = 0.0f;
+    int sleepInterval = 8;
+    // Tests the whole path a projectile and a meteor cover in a tick instead of where they
+    // are at its start, so fast projectiles or long ticks cannot pass through a meteor; a
+    // projectile takes the meteor it reaches first.
+    bool sweptProjectiles = false;
+    // Seed used by reset(); a game can pass its own to reset(seed).
+    std::uint64_t seed = 1;
+    // On-screen sizes of the sprites; defaults match the shipped textures at their draw scale.
+    Vec2 shipSize = {152.7f, 107.8f};
+    Vec2 projectileSize = {65.36f, 65.52f};
+    Vec2 meteorSizes[3] = {{300.0f, 300.0f}, {300.0f, 300.0f}, {300.0f, 221.4f}};
+};
+
+// The settings the game itself plays with, for tools whose games should play the same: the
+// defaults with swept projectile collisions.
+SimConfig gameSimConfig();
+
+// Sprite masks as the simulation tests them, with the ship's rotations already made. They
+// do not change once built, so any number of simulations can share one set.
+struct PreparedSpriteMasks {
+    std::vector<CollisionMask> ship;
+    CollisionMask projectile;
+    CollisionMask meteors[3];
+    // Never 0, so it also tells that masks are in use.
+    std::uint64_t hash;
+};
+
+// Something that happened during a tick, for effects and sounds. Events are not part of the
+// game state: they are rebuilt every tick and do not affect later ones.
+struct SimEvent {
+    enum class Type {
+        MeteorHit,        // a projectile moved a meteor to its next stage
+        MeteorDestroyed,  // a projectile or the ship destroyed a meteor
+        ShipHit           // a ship lost a life
+    };
+
+    Type type;
+    Vec2 position;  // centre of the meteor or the ship
+    Vec2 velocity;
+    int stage;      // the meteor's stage before the hit; 0 for a ship
+    int ship;       // index of the ship that was hit; 0 for a meteor
+};
+
+struct ShipState {
+    Vec2 position;
+    float rotation;
+    int lives;
+    float hitTimer;
+    float timeSinceShot;
+    Vec2 lastPointer;
+    bool hasPointer;
+};
+
+class Simulation {
+private:
+    struct ProjectileHit {
+        std::uint32_t projectile;
+        std::uint32_t meteor;
+        // Fraction of the tick at which they meet; always 0 unless sweptProjectiles is set.
+        float time;
+    };
+
+    SimConfig config;
+    // A ship without lives is out of the game: it no longer moves, shoots or collides.
+    std::vector<ShipState> ships;
+    MeteorField meteors;
+    // Meteors [0, awakeMeteors) are simulated every tick; the rest sleep.
+    size_t awakeMeteors;
+    // Length of the current or last step, for how far things can move until the next one.
+    float stepSeconds;
+    SpatialGrid meteorGrid;
+    std::vector<std::uint32_t> candidates;
+    ProjectilePool projectiles;
+
+    // Scratch that lives for one step, reset at the start of the next.
+    FrameArena scratch;
+    // Per meteor, whether a collision this tick destroyed it or moved it to the next stage.
+    char* meteorHits;
+    size_t meteorHitCount;
+    ProjectileHit* projectileHits;
+    std::uint32_t* projectileHitStart;
+    std::uint32_t* projectileOrder;
+
+    JobSystem* jobs;
+    // Scratch for the parallel passes, one buffer per job system thread.
+    std::vector<std::vector<std::uint32_t>> workerCandidates;
+    std::vector<std::vector<ProjectileHit>> workerHits;
+    float meteorSpawnTimer;
+    std::uint64_t seed;
+    Rng random;
+    // Pixel masks for the narrow phase; without them (maskHash 0) the boxes decide alone.
+    std::shared_ptr<const PreparedSpriteMasks> masks;
+    std::uint64_t maskHash;
+    std::vector<SimEvent> events;
+    int score;
+    bool gameOver;
+    unsigned long long tickCount;
+
+    void reserveWorkerScratch();
+    void shoot(ShipState& ship);
+    void updateMeteors(float dt);
+    void updateMeteorSleep(float dt);
+    bool isNearShip(size_t meteor) const;
+    void removeMeteor(size_t index);
+    void generateMeteors(float dt);
+    void rebuildBroadphase();
+    void checkCollisions();
+    void checkProjectileCollisions(float dt);
+    void removeDestroyedMeteors();
+    void updateProjectiles(float dt);
+    bool applyProjectileHits(std::uint32_t projectile, size_t index, float dt);
+    void addMeteorEvent(SimEvent::Type type, size_t meteor);
+    bool shipTouchesMeteor(const ShipState& ship, const Bounds& shipBounds, size_t meteor) const;
+    bool projectileTouchesMeteor(const Projectile& projectile, const Bounds& projectileBounds, size_t meteor) const;
+    bool projectileMaskTouches(Vec2 projectilePosition, Vec2 meteorPosition, int stage) const;
+    bool projectileSweepsMeteor(const Projectile& projectile, const Bounds& projectileBounds, size_t meteor, float dt,
+                                float& time) const;
+    bool projectileHitsMeteor(const Projectile& projectile, const Bounds& projectileBounds, size_t meteor, float dt,
+                              float& time) const;
+
+public:
+    // Meteors start at a random stage and advance one stage per projectile hit; a hit on
+    // the last stage destroys the meteor.
+    static const int meteorStageCount = 3;
+    // The ship's mask is pre-rotated in this many steps, which puts its tips at most a
+    // couple of pixels off.
+    static const int shipMaskRotations = 128;
+    static const int maxShips = 8;
+
+    explicit Simulation(const SimConfig& config = SimConfig());
+
+    void reset();
+    void reset(std::uint64_t seed);
+    // Steps a game with one ship.
+    void step(float dt, const TickInput& input);
+    // Steps with one input per ship. The game is over once every ship has lost its lives.
+    void step(float dt, const TickInput* inputs);
+    // Moves a ship to the pointer and turns it towards the way the pointer moved, over a
+    // step of dt seconds. Used by step and by network clients predicting their own ship.
+    static void steerShip(ShipState& ship, const TickInput& input, const SimConfig& config, float dt);
+    // Spreads movement and projectile collision detection over the job system's threads;
+    // nullptr (the default) runs everything on the calling thread. The outcome of a tick
+    // does not depend on the thread count. The job system must outlive the simulation.
+    void setJobSystem(JobSystem* value);
+    // Add entities outside the spawn timer and the fire button, for scripted scenarios.
+    MeteorHandle spawnMeteor(Vec2 position, Vec2 velocity, int stage);
+    ProjectileHandle spawnProjectile(const Projectile& projectile);
+    // Collisions whose boxes overlap only count where the sprites' opaque pixels overlap.
+    // The masks must match the sprite sizes in SimConfig. Meteors are tested unscaled and
+    // projectiles unrotated, which fits the round projectile sprite.
+    void setSpriteMasks(const SpriteMasks& masks);
+    // Shares masks made once by prepareSpriteMasks, e.g. among many simulations at once.
+    void setSpriteMasks(std::shared_ptr<const PreparedSpriteMasks> prepared);
+    static std::shared_ptr<const PreparedSpriteMasks> prepareSpriteMasks(const SpriteMasks& masks);
+
+    Bounds getShipBounds(const ShipState& ship) const;
+    Bounds getProjectileBounds(const Projectile& projectile) const;
+
+    const SimConfig& getConfig() const {
+        return config;
+    }
+
+    size_t getShipCount() const {
+        return ships.size();
+    }
+
+    const ShipState& getShip(size_t index = 0) const {
+        return ships[index];
+    }
+
+    bool isShipHit(size_t index = 0) const {
+        return ships[index].hitTimer > 0.0f;
+    }
+
+    const MeteorField& getMeteors() const {
+        return meteors;
+    }
+
+    // The meteors with indices below this are awake; all of them without awakeDistance.
+    size_t getAwakeMeteorCount() const {
+        return awakeMeteors;
+    }
+
+    // Replaces result with the indices of the awake meteors in the broadphase cells that
+    // overlap area, e.g. for culling what is off screen. Valid until the next step or spawn;
+    // the candidates still need a bounds test.
+    void queryMeteors(const Bounds& area, std::vector<std::uint32_t>& result) const {
+        meteorGrid.query(area, result);
+    }
+
+    const ProjectilePool& getProjectiles() const {
+        return projectiles;
+    }
+
+    // Events of the last step, in the order they happened.
+    const std::vector<SimEvent>& getEvents() const {
+        return events;
+    }
+
+    int getScore() const {
+        return score;
+    }
+
+    bool isGameOver() const {
+        return gameOver;
+    }
+
+    unsigned long long getTickCount() const {
+        return tickCount;
+    }
+
+    std::uint64_t getSeed() const {
+        return seed;
+    }
+
+    // Identifies the sprite masks in use, 0 without masks. A replay needs the same masks.
+    std::uint64_t getSpriteMaskHash() const {
+        return maskHash;
+    }
+
+    // FNV-1a hash of everything that affects later ticks: ships with the pointer they steer
+    // by, score, timers, random state, every meteor with its sleep schedule and every
+    // projectile. Two runs that agree on it will keep agreeing.
+    std::uint64_t computeStateHash() const;
+};
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "alloc_tracker.h"
+#include "asset_pack.h"
+#include "input_source.h"
+#include "job_system.h"
+
+// Headless soak test: the autopilot plays game after game without a window, for hours of
+// game time, faster than real time. Every report interval it prints the games played, the
+// step time (average, p99 and maximum), the heap allocations made and blocks alive, the
+// resident memory and the storage reserved for meteors, projectiles and events, so leaks,
+// slowdowns and containers that keep growing show up long before a player would notice them.
+//
+// Usage: oop_game_soak [--hours <h>] [--speed <x>] [--report-minutes <m>] [--threads <n>]
+//                      [--seed <s>] [--pack <assets.pack>] [--max-drift <ratio>]
+//
+// --hours is game time (default 1). --speed runs that many times faster than real time;
+// 0 (the default) runs as fast as the CPU allows. --report-minutes is in game time
+// (default 10). Exits with 1 if more heap blocks are alive at the end than after the first
+// interval, or if the median step time of the last interval is more than --max-drift
+// (default 1.5) times that of the first.
+
+namespace {
+    const char* usage = " [--hours <h>] [--speed <x>] [--report-minutes <m>] [--threads <n>] [--seed <s>]"
+                        " [--pack <assets.pack>] [--max-drift <ratio>]";
+
+    // Resident set size of the process in bytes, 0 where it is not known.
+    std::uint64_t residentBytes() {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.WorkingSetSize;
+        }
+        return 0;
+#elif defined(__linux__)
+        unsigned long long pages = 0;
+        unsigned long long resident = 0;
+        if (FILE* file = std::fopen("/proc/self/statm", "r")) {
+            if (std::fscanf(file, "%llu %llu", &pages, &resident) != 2) {
+                resident = 0;
+            }
+            std::fclose(file);
+        }
+        return resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    struct Interval {
+        double gameHours;
+        int games;
+        double averageScore;
+        double averageMicroseconds;
+        double medianMicroseconds;
+        double p99Microseconds;
+        double maxMicroseconds;
+        std::uint64_t allocations;
+        std::int64_t liveBlocks;
+        std::uint64_t residentBytes;
+        size_t meteorCapacity;
+        size_t projectileCapacity;
+        size_t eventCapacity;
+    };
+
+    void printInterval(const Interval& interval, double wallSeconds) {
+        std::printf("%8.2f %8.1f %6d %8.1f %9.2f %9.2f %9.2f %9.2f %8llu %8lld %9.1f %7zu %7zu %7zu\n",
+                    interval.gameHours, wallSeconds, interval.games, interval.averageScore,
+                    interval.averageMicroseconds, interval.medianMicroseconds, interval.p99Microseconds,
+                    interval.maxMicroseconds, static_cast<unsigned long long>(interval.allocations),
+                    static_cast<long long>(interval.liveBlocks), interval.residentBytes / (1024.0 * 1024.0),
+                    interval.meteorCapacity, interval.projectileCapacity, interval.eventCapacity);
+        std::fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv) {
+    double hours = 1.0;
+    double speed = 0.0;
+    double reportMinutes = 10.0;
+    int threads = 0;
+    std::uint64_t seed = 1;
+    std::string packPath;
+    double maxDrift = 1.5;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+            hours = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--report-minutes") == 0 && i + 1 < argc) {
+            reportMinutes = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            packPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--max-drift") == 0 && i + 1 < argc) {
+            maxDrift = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s%s\n", argv[0], usage);
+            return 2;
+        }
+    }
+
+    try {
+        // The settings the game plays with, so the soak runs the collision paths it uses.
+        SimConfig config = gameSimConfig();
+        std::unique_ptr<SpriteMasks> masks;
+        if (!packPath.empty()) {
+            AssetPack pack;
+            if (!pack.open(packPath)) {
+                std::fprintf(stderr, "Failed to open %s\n", packPath.c_str());
+                return 1;
+            }
+            masks.reset(new SpriteMasks(loadSpriteMasks(pack)));
+            // The masks are at the sprites' on-screen size, which the collision boxes must match.
+            auto size = [](const CollisionMask& mask) {
+                return Vec2{static_cast<float>(mask.getSpriteWidth()), static_cast<float>(mask.getSpriteHeight())};
+            };
+            config.shipSize = size(masks->ship);
+            config.projectileSize = size(masks->projectile);
+            for (int stage = 0; stage < Simulation::meteorStageCount; ++stage) {
+                config.meteorSizes[stage] = size(masks->meteors[stage]);
+            }
+        }
+        std::unique_ptr<JobSystem> jobs;
+        if (threads > 0) {
+            jobs.reset(new JobSystem(static_cast<unsigned>(threads)));
+        }
+        Simulation simulation(config);
+        simulation.setJobSystem(jobs.get());
+        if (masks) {
+            simulation.setSpriteMasks(*masks);
+        }
+        simulation.reset(seed);
+        Autopilot autopilot(seed);
+
+        const float dt = 1.0f / 60;
+        const long long totalTicks = static_cast<long long>(hours * 3600.0 * 60.0);
+        const long long reportTicks = std::max(1LL, static_cast<long long>(reportMinutes * 60.0 * 60.0));
+        // Reused every interval, so the measurement itself does not allocate.
+        std::vector<float> stepMicroseconds(static_cast<size_t>(reportTicks));
+        std::vector<float> sorted(stepMicroseconds.size());
+        std::vector<Interval> intervals;
+        intervals.reserve(static_cast<size_t>(totalTicks / reportTicks + 1));
+
+        std::printf("%8s %8s %6s %8s %9s %9s %9s %9s %8s %8s %9s %7s %7s %7s\n", "game h", "wall s", "games",
+                    "score", "avg us", "p50 us", "p99 us", "max us", "allocs", "blocks", "RSS MB", "meteors", "shots", "events");
+        auto start = std::chrono::steady_clock::now();
+        int games = 0;
+        long long scoreSum = 0;
+        long long intervalTicks = 0;
+        std::uint64_t intervalAllocations = AllocationTracker::getTotals().allocations;
+        for (long long tick = 0; tick < totalTicks; ++tick) {
+            auto before = std::chrono::steady_clock::now();
+            TickInput input = autopilot.next(simulation);
+            simulation.step(dt, input);
+            auto after = std::chrono::steady_clock::now();
+            stepMicroseconds[static_cast<size_t>(intervalTicks++)] =
+                    std::chrono::duration<float, std::micro>(after - before).count();
+
+            if (simulation.isGameOver()) {
+                ++games;
+                scoreSum += simulation.getScore();
+                ++seed;
+                simulation.reset(seed);
+                autopilot = Autopilot(seed);
+            }
+            if (speed > 0.0) {
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>((tick + 1) * dt / speed)));
+            }
+
+            if (intervalTicks == reportTicks || tick + 1 == totalTicks) {
+                std::copy(stepMicroseconds.begin(), stepMicroseconds.begin() + intervalTicks, sorted.begin());
+                std::sort(sorted.begin(), sorted.begin() + intervalTicks);
+                double sum = 0.0;
+                for (long long i = 0; i < intervalTicks; ++i) {
+                    sum += sorted[static_cast<size_t>(i)];
+                }
+                Interval interval;
+                interval.gameHours = (tick + 1) * dt / 3600.0;
+                interval.games = games;
+                interval.averageScore = games > 0 ? static_cast<double>(scoreSum) / games : 0.0;
+                interval.averageMicroseconds = sum / intervalTicks;
+                interval.medianMicroseconds = sorted[static_cast<size_t>(intervalTicks / 2)];
+                interval.p99Microseconds = sorted[static_cast<size_t>(intervalTicks * 99 / 100)];
+                interval.maxMicroseconds = sorted[static_cast<size_t>(intervalTicks - 1)];
+                interval.allocations = AllocationTracker::getTotals().allocations - intervalAllocations;
+                interval.liveBlocks = AllocationTracker::getLiveBlocks();
+                interval.residentBytes = residentBytes();
+                interval.meteorCapacity = simulation.getMeteors().capacity();
+                interval.projectileCapacity = simulation.getProjectiles().capacity();
+                interval.eventCapacity = simulation.getEvents().capacity();
+                intervals.push_back(interval);
+                printInterval(interval, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                intervalTicks = 0;
+                intervalAllocations = AllocationTracker::getTotals().allocations;
+            }
+        }
+
+        if (intervals.size() < 2) {
+            std::printf("Too short to compare intervals; run more than one report interval\n");
+            return 0;
+        }
+        const Interval& first = intervals.front();
+        const Interval& last = intervals.back();
+        bool passed = true;
+        std::int64_t blockGrowth = last.liveBlocks - first.liveBlocks;
+        double drift = first.medianMicroseconds > 0.0 ? last.medianMicroseconds / first.medianMicroseconds : 1.0;
+        std::printf("heap blocks %+lld since the first interval, RSS %+.1f MB, median step time x%.2f\n",
+                    static_cast<long long>(blockGrowth),
+                    (static_cast<double>(last.residentBytes) - static_cast<double>(first.residentBytes)) / (1024.0 * 1024.0),
+                    drift);
+        if (last.meteorCapacity != first.meteorCapacity) {
+            std::printf("meteor storage grew from %zu to %zu\n", first.meteorCapacity, last.meteorCapacity);
+        }
+        if (last.eventCapacity != first.eventCapacity) {
+            std::printf("event storage grew from %zu to %zu\n", first.eventCapacity, last.eventCapacity);
+        }
+        if (blockGrowth > 0) {
+            std::printf("FAILED: heap blocks keep piling up\n");
+            passed = false;
+        }
+        if (drift > maxDrift) {
+            std::printf("FAILED: steps got slower over time\n");
+            passed = false;
+        }
+        return passed ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
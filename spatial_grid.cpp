@@ -0,0 +1,84 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid() : originX(0.0f), originY(0.0f), cellSize(1.0f), columns(1), rows(1) {
+    cellStart.assign(2, 0);
+}
+
+void SpatialGrid::configure(float left, float top, float width, float height, float size) {
+    originX = left;
+    originY = top;
+    cellSize = std::max(size, 1.0f);
+    columns = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+    cellStart.assign(static_cast<size_t>(columns) * rows + 1, 0);
+    cellItems.clear();
+}
+
+void SpatialGrid::reserve(size_t entries) {
+    cellItems.reserve(entries);
+}
+
+void SpatialGrid::cellRange(float left, float top, float width, float height,
+                            int& firstColumn, int& firstRow, int& lastColumn, int& lastRow) const {
+    auto toCell = [this](float value, float origin, int count) {
+        float cell = std::floor((value - origin) / cellSize);
+        return static_cast<int>(std::min(std::max(cell, 0.0f), static_cast<float>(count - 1)));
+    };
+    firstColumn = toCell(left, originX, columns);
+    firstRow = toCell(top, originY, rows);
+    lastColumn = toCell(left + width, originX, columns);
+    lastRow = toCell(top + height, originY, rows);
+}
+
+void SpatialGrid::build(size_t count, const float* left, const float* top, const float* width, const float* height) {
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+
+    int firstColumn, firstRow, lastColumn, lastRow;
+    for (size_t i = 0; i < count; ++i) {
+        cellRange(left[i], top[i], width[i], height[i], firstColumn, firstRow, lastColumn, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                ++cellStart[row * columns + column + 1];
+            }
+        }
+    }
+    for (size_t cell = 1; cell < cellStart.size(); ++cell) {
+        cellStart[cell] += cellStart[cell - 1];
+    }
+
+    // Use the start offsets as write cursors; afterwards cellStart[c] holds the end of
+    // cell c, which is the start of c + 1, so shift everything up by one slot.
+    cellItems.resize(cellStart.back());
+    for (size_t i = 0; i < count; ++i) {
+        cellRange(left[i], top[i], width[i], height[i], firstColumn, firstRow, lastColumn, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                cellItems[cellStart[row * columns + column]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+    for (size_t cell = cellStart.size() - 2; cell > 0; --cell) {
+        cellStart[cell] = cellStart[cell - 1];
+    }
+    cellStart[0] = 0;
+}
+
+void SpatialGrid::query(const Bounds& area, std::vector<std::uint32_t>& result) const {
+    result.clear();
+
+    int firstColumn, firstRow, lastColumn, lastRow;
+    cellRange(area.left, area.top, area.width, area.height, firstColumn, firstRow, lastColumn, lastRow);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            int cell = row * columns + column;
+            result.insert(result.end(), cellItems.begin() + cellStart[cell], cellItems.begin() + cellStart[cell + 1]);
+        }
+    }
+    // An item spans at most a few cells, so sorting out the duplicates is cheaper than
+    // keeping per-item visit marks, and leaves the grid read-only for concurrent queries.
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+// Uniform-grid broadphase rebuilt from scratch every tick. Items are stored per cell in
+// one flat array (counting sort), so a rebuild is two linear passes with no allocation
+// once the buffers have grown. Items outside the grid are clamped into the border cells.
+class SpatialGrid {
+private:
+    float originX;
+    float originY;
+    float cellSize;
+    int columns;
+    int rows;
+    std::vector<std::uint32_t> cellStart;
+    std::vector<std::uint32_t> cellItems;
+
+    void cellRange(float left, float top, float width, float height,
+                   int& firstColumn, int& firstRow, int& lastColumn, int& lastRow) const;
+
+public:
+    SpatialGrid();
+
+    void configure(float left, float top, float width, float height, float cellSize);
+
+    // Room for this many cell entries, for a grid that should not grow during play. An item
+    // no larger than a cell takes at most four.
+    void reserve(size_t entries);
+
+    // Rebuilds the grid from packed bounds arrays; item ids are the array indices.
+    void build(size_t count, const float* left, const float* top, const float* width, const float* height);
+
+    // Replaces the contents of result with the ids of items sharing a cell with area,
+    // each reported once and in ascending order. Candidates still need an exact test.
+    // Queries do not modify the grid, so several threads may run them at once.
+    void query(const Bounds& area, std::vector<std::uint32_t>& result) const;
+
+    int getColumns() const {
+        return columns;
+    }
+
+    int getRows() const {
+        return rows;
+    }
+};
@@ -0,0 +1,54 @@
+#include "sprite_batch.h"
+
+#include <cmath>
+
+SpriteBatch::SpriteBatch() : vertices(sf::Triangles) {}
+
+void SpriteBatch::clear() {
+    // sf::VertexArray::clear keeps its storage, so steady-state frames do not allocate.
+    vertices.clear();
+}
+
+void SpriteBatch::add(const sf::IntRect& region, sf::Vector2f position, sf::Vector2f origin,
+                      float rotation, sf::Vector2f scale, sf::Color color) {
+    float angle = rotation * 3.14159f / 180;
+    float cosine = std::cos(angle);
+    float sine = std::sin(angle);
+
+    float left = -origin.x * scale.x;
+    float top = -origin.y * scale.y;
+    float right = (region.width - origin.x) * scale.x;
+    float bottom = (region.height - origin.y) * scale.y;
+
+    auto corner = [&](float x, float y) {
+        return sf::Vector2f(position.x + x * cosine - y * sine, position.y + x * sine + y * cosine);
+    };
+    sf::Vector2f topLeft = corner(left, top);
+    sf::Vector2f topRight = corner(right, top);
+    sf::Vector2f bottomRight = corner(right, bottom);
+    sf::Vector2f bottomLeft = corner(left, bottom);
+
+    float u0 = static_cast<float>(region.left);
+    float v0 = static_cast<float>(region.top);
+    float u1 = static_cast<float>(region.left + region.width);
+    float v1 = static_cast<float>(region.top + region.height);
+
+    vertices.append(sf::Vertex(topLeft, color, sf::Vector2f(u0, v0)));
+    vertices.append(sf::Vertex(topRight, color, sf::Vector2f(u1, v0)));
+    vertices.append(sf::Vertex(bottomRight, color, sf::Vector2f(u1, v1)));
+    vertices.append(sf::Vertex(topLeft, color, sf::Vector2f(u0, v0)));
+    vertices.append(sf::Vertex(bottomRight, color, sf::Vector2f(u1, v1)));
+    vertices.append(sf::Vertex(bottomLeft, color, sf::Vector2f(u0, v1)));
+}
+
+void SpriteBatch::draw(sf::RenderTarget& target, const sf::Texture& texture, RenderStats* stats) const {
+    if (vertices.getVertexCount() == 0) {
+        return;
+    }
+    sf::RenderStates states;
+    states.texture = &texture;
+    target.draw(vertices, states);
+    if (stats != nullptr) {
+        stats->add(vertices.getVertexCount());
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "render_stats.h"
+
+// Collects textured quads from one texture and submits them with a single draw call.
+// Position, rotation and scale are applied on the CPU while the quad is added.
+class SpriteBatch {
+private:
+    sf::VertexArray vertices;
+
+public:
+    SpriteBatch();
+
+    void clear();
+
+    // origin is in pixels of the region, like sf::Sprite::setOrigin; rotation is in degrees.
+    void add(const sf::IntRect& region, sf::Vector2f position, sf::Vector2f origin,
+             float rotation, sf::Vector2f scale, sf::Color color = sf::Color::White);
+
+    void draw(sf::RenderTarget& target, const sf::Texture& texture, RenderStats* stats = nullptr) const;
+
+    size_t getSpriteCount() const {
+        return vertices.getVertexCount() / 6;
+    }
+};
@@ -0,0 +1,89 @@
+#include "state_interpolator.h"
+
+#include <cmath>
+
+namespace {
+    Vec2 blend(Vec2 from, Vec2 to, float alpha) {
+        return {from.x + (to.x - from.x) * alpha, from.y + (to.y - from.y) * alpha};
+    }
+}
+
+StateInterpolator::StateInterpolator(const Simulation& simulation)
+        : simulation(simulation), captured(false), alpha(1.0f) {}
+
+void StateInterpolator::capture() {
+    shipPositions.resize(simulation.getShipCount());
+    shipRotations.resize(simulation.getShipCount());
+    for (size_t i = 0; i < simulation.getShipCount(); ++i) {
+        shipPositions[i] = simulation.getShip(i).position;
+        shipRotations[i] = simulation.getShip(i).rotation;
+    }
+    captured = true;
+
+    for (std::uint32_t slot : capturedMeteorSlots) {
+        meteorSlots[slot].generation = 0;
+    }
+    capturedMeteorSlots.clear();
+    const MeteorField& meteors = simulation.getMeteors();
+    for (size_t i = 0; i < simulation.getAwakeMeteorCount(); ++i) {
+        MeteorHandle handle = meteors.getHandle(i);
+        if (handle.slot >= meteorSlots.size()) {
+            meteorSlots.resize(handle.slot + 1, SlotState{{0.0f, 0.0f}, 0});
+        }
+        meteorSlots[handle.slot] = {meteors.getPosition(i), handle.generation + 1};
+        capturedMeteorSlots.push_back(handle.slot);
+    }
+
+    for (auto& slot : projectileSlots) {
+        slot.generation = 0;
+    }
+    const ProjectilePool& projectiles = simulation.getProjectiles();
+    for (size_t i = 0; i < projectiles.size(); ++i) {
+        ProjectileHandle handle = projectiles.getHandle(i);
+        if (handle.slot >= projectileSlots.size()) {
+            projectileSlots.resize(handle.slot + 1, SlotState{{0.0f, 0.0f}, 0});
+        }
+        projectileSlots[handle.slot] = {projectiles[i].position, handle.generation + 1};
+    }
+}
+
+void StateInterpolator::clear() {
+    captured = false;
+    meteorSlots.clear();
+    capturedMeteorSlots.clear();
+    projectileSlots.clear();
+}
+
+Vec2 StateInterpolator::getShipPosition(size_t index) const {
+    const ShipState& ship = simulation.getShip(index);
+    return captured ? blend(shipPositions[index], ship.position, alpha) : ship.position;
+}
+
+float StateInterpolator::getShipRotation(size_t index) const {
+    float rotation = simulation.getShip(index).rotation;
+    if (!captured) {
+        return rotation;
+    }
+    // Along the shorter way round, in case the angle wrapped between the two ticks.
+    float difference = rotation - shipRotations[index];
+    difference -= std::floor((difference + 180) / 360) * 360;
+    return shipRotations[index] + difference * alpha;
+}
+
+Vec2 StateInterpolator::getMeteorPosition(size_t index) const {
+    const MeteorField& meteors = simulation.getMeteors();
+    MeteorHandle handle = meteors.getHandle(index);
+    if (handle.slot < meteorSlots.size() && meteorSlots[handle.slot].generation == handle.generation + 1) {
+        return blend(meteorSlots[handle.slot].position, meteors.getPosition(index), alpha);
+    }
+    return meteors.getPosition(index);
+}
+
+Vec2 StateInterpolator::getProjectilePosition(size_t index) const {
+    const ProjectilePool& projectiles = simulation.getProjectiles();
+    ProjectileHandle handle = projectiles.getHandle(index);
+    if (handle.slot < projectileSlots.size() && projectileSlots[handle.slot].generation == handle.generation + 1) {
+        return blend(projectileSlots[handle.slot].position, projectiles[index].position, alpha);
+    }
+    return projectiles[index].position;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+// Positions for drawing between two fixed simulation ticks. capture() remembers the state
+// before a step; the getters then blend it with the simulation's current state by alpha,
+// the fraction of a tick that real time has run past the last step. Entities are matched
+// through their handles, so removals that reshuffle the packed arrays do not matter, and
+// an entity that appeared in the last step is drawn where it is now. Only awake meteors are
+// captured, so a capture costs as much as the meteors near the ships; sleeping ones are
+// off screen and drawn where they are.
+class StateInterpolator {
+private:
+    // Previous state per storage slot; the generation is stored plus one, so 0 means the
+    // slot held nothing at the last capture.
+    struct SlotState {
+        Vec2 position;
+        std::uint32_t generation;
+    };
+
+    const Simulation& simulation;
+    std::vector<Vec2> shipPositions;
+    std::vector<float> shipRotations;
+    bool captured;
+    std::vector<SlotState> meteorSlots;
+    // Slots set by the last capture, so the next one clears only those.
+    std::vector<std::uint32_t> capturedMeteorSlots;
+    std::vector<SlotState> projectileSlots;
+    float alpha;
+
+public:
+    explicit StateInterpolator(const Simulation& simulation);
+
+    // Call right before every Simulation::step.
+    void capture();
+    // Forgets the captured state, e.g. after Simulation::reset.
+    void clear();
+
+    void setAlpha(float value) {
+        alpha = value;
+    }
+
+    Vec2 getShipPosition(size_t index = 0) const;
+    float getShipRotation(size_t index = 0) const;
+    Vec2 getMeteorPosition(size_t index) const;
+    Vec2 getProjectilePosition(size_t index) const;
+};
@@ -0,0 +1,107 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+TextureAtlas::TextureAtlas(unsigned padding) : padding(padding) {}
+
+int TextureAtlas::add(const std::string& name, const sf::Image& image) {
+    names.push_back(name);
+    pendingImages.push_back(image);
+    regions.push_back(sf::IntRect());
+    return static_cast<int>(regions.size() - 1);
+}
+
+sf::Image TextureAtlas::pack(unsigned maximumSize) {
+    // Shelf packing, tallest images first. Try each power-of-two width up to maximumSize
+    // and keep the one that gives the smallest texture.
+    std::vector<size_t> order(pendingImages.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return pendingImages[a].getSize().y > pendingImages[b].getSize().y;
+    });
+
+    unsigned widest = 1;
+    for (const auto& image : pendingImages) {
+        widest = std::max(widest, image.getSize().x + padding);
+    }
+
+    unsigned bestWidth = 0;
+    unsigned bestHeight = 0;
+    std::vector<sf::IntRect> bestRegions;
+    for (unsigned width = 1; width <= maximumSize; width *= 2) {
+        if (width < widest) {
+            continue;
+        }
+        std::vector<sf::IntRect> placed(pendingImages.size());
+        unsigned x = 0, y = 0, shelfHeight = 0;
+        for (size_t index : order) {
+            sf::Vector2u size = pendingImages[index].getSize();
+            if (x + size.x + padding > width) {
+                x = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+            placed[index] = sf::IntRect(static_cast<int>(x), static_cast<int>(y),
+                                        static_cast<int>(size.x), static_cast<int>(size.y));
+            x += size.x + padding;
+            shelfHeight = std::max(shelfHeight, size.y + padding);
+        }
+        unsigned height = y + shelfHeight;
+        if (height <= maximumSize && (bestWidth == 0 || width * height < bestWidth * bestHeight)) {
+            bestWidth = width;
+            bestHeight = height;
+            bestRegions = placed;
+        }
+    }
+    if (bestWidth == 0) {
+        throw std::runtime_error("Textures do not fit into one atlas");
+    }
+
+    sf::Image atlasImage;
+    atlasImage.create(bestWidth, bestHeight, sf::Color::Transparent);
+    for (size_t i = 0; i < pendingImages.size(); ++i) {
+        atlasImage.copy(pendingImages[i], static_cast<unsigned>(bestRegions[i].left),
+                        static_cast<unsigned>(bestRegions[i].top));
+    }
+    regions = bestRegions;
+    pendingImages.clear();
+    return atlasImage;
+}
+
+void TextureAtlas::loadRegions(const AssetPack& pack, const std::string& textureName) {
+    const AssetPackTexture* record = pack.findTexture(textureName);
+    if (record == nullptr) {
+        throw std::runtime_error("Failed to load texture atlas");
+    }
+    names.clear();
+    regions.clear();
+    std::uint32_t textureIndex = pack.indexOf(*record);
+    for (std::uint32_t i = 0; i < pack.getSpriteCount(); ++i) {
+        const AssetPackSprite& sprite = pack.getSprite(i);
+        if (sprite.texture == textureIndex) {
+            names.push_back(std::string(sprite.name, strnlen(sprite.name, assetNameLength)));
+            regions.push_back(sf::IntRect(sprite.left, sprite.top, sprite.width, sprite.height));
+        }
+    }
+}
+
+int TextureAtlas::find(const std::string& name) const {
+    for (size_t id = 0; id < names.size(); ++id) {
+        if (names[id] == name) {
+            return static_cast<int>(id);
+        }
+    }
+    throw std::runtime_error("Missing atlas region: " + name);
+}
+
+bool loadPackedTexture(sf::Texture& texture, const AssetPack& pack, const std::string& name) {
+    const AssetPackTexture* record = pack.findTexture(name);
+    if (record == nullptr || !texture.create(record->width, record->height)) {
+        return false;
+    }
+    texture.update(pack.getPixels(*record));
+    return true;
+}
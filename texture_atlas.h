@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+
+// Named regions of one texture that holds several images, so sprites that use them can
+// share a draw call. The packing runs offline in oop_game_cook (add + pack, CPU only); the
+// game reads the finished regions from the asset pack and uploads the texture separately.
+class TextureAtlas {
+private:
+    std::vector<std::string> names;
+    std::vector<sf::IntRect> regions;
+    std::vector<sf::Image> pendingImages;
+    unsigned padding;
+
+public:
+    explicit TextureAtlas(unsigned padding = 2);
+
+    int add(const std::string& name, const sf::Image& image);
+    sf::Image pack(unsigned maximumSize);
+
+    void loadRegions(const AssetPack& pack, const std::string& textureName);
+    // Throws if the atlas has no region with this name.
+    int find(const std::string& name) const;
+
+    size_t getRegionCount() const {
+        return regions.size();
+    }
+
+    const std::string& getName(int id) const {
+        return names[id];
+    }
+
+    const sf::IntRect& getRegion(int id) const {
+        return regions[id];
+    }
+
+    sf::Vector2u getRegionSize(int id) const {
+        return sf::Vector2u(static_cast<unsigned>(regions[id].width), static_cast<unsigned>(regions[id].height));
+    }
+};
+
+// Uploads a texture straight from the pack's mapped pixels, without an intermediate sf::Image.
+bool loadPackedTexture(sf::Texture& texture, const AssetPack& pack, const std::string& name);